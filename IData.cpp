@@ -1,7 +1,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <set>
+#include <algorithm>
+#include <unordered_map>
 #include "IData.h"
+#include "icallstats.h"
 #include <math.h>
 
 #include <iostream>
@@ -15,197 +18,294 @@
 
 namespace eve {
 
-IData::IData(IMetaData& dInfo) : IMetaData(dInfo)
+IData::IData(IMetaData& dInfo) : IMetaData(dInfo), arrayRowSize(0)
 {
 }
 
+// lookup of positions in the (usually sorted) posCounts of a dataset
+class PosCountIndex
+{
+public:
+    PosCountIndex(const vector<int>& posCounts) : pc(posCounts), hashed(false) {
+        sorted = is_sorted(pc.begin(), pc.end());
+    };
+    // index of the first / last entry with posCount, -1 if none
+    int firstOf(int posCount){
+        if (sorted){
+            vector<int>::const_iterator it = lower_bound(pc.begin(), pc.end(), posCount);
+            return ((it != pc.end()) && (*it == posCount)) ? (int)(it - pc.begin()) : -1;
+        }
+        buildHash();
+        unordered_map<int, pair<int, int>>::iterator it = range.find(posCount);
+        return (it != range.end()) ? it->second.first : -1;
+    };
+    int lastOf(int posCount){
+        if (sorted){
+            vector<int>::const_iterator it = upper_bound(pc.begin(), pc.end(), posCount);
+            return ((it != pc.begin()) && (*(it - 1) == posCount)) ? (int)(it - pc.begin()) - 1 : -1;
+        }
+        buildHash();
+        unordered_map<int, pair<int, int>>::iterator it = range.find(posCount);
+        return (it != range.end()) ? it->second.second : -1;
+    };
+    bool isUnique(){
+        if (sorted) return adjacent_find(pc.begin(), pc.end()) == pc.end();
+        buildHash();
+        return range.size() == pc.size();
+    };
+
+private:
+    void buildHash(){
+        if (hashed) return;
+        range.reserve(pc.size());
+        for (unsigned int i = 0; i < pc.size(); ++i){
+            pair<unordered_map<int, pair<int, int>>::iterator, bool> res = range.insert(pair<int, pair<int, int>>(pc[i], pair<int, int>(i, i)));
+            if (!res.second) res.first->second.second = i;
+        }
+        hashed = true;
+    };
+    const vector<int>& pc;
+    bool sorted;
+    bool hashed;
+    unordered_map<int, pair<int, int>> range;
+};
+
+// copy column src into a new column with the rows of source, rows without source get
+// the row of fill in fillsrc (if fill is not NULL and >= 0) or fillValue
+template <typename T>
+static shared_ptr<vector<T>> gatherColumn(const vector<T>& src, const vector<int>& source, const vector<T>& fillsrc, const vector<int>* fill, const T& fillValue){
+    shared_ptr<vector<T>> column = make_shared<vector<T>>(source.size());
+    countAllocated();
+    T* dst = column->data();
+    for (size_t i = 0; i < source.size(); ++i){
+        int srcidx = source[i];
+        if (srcidx >= 0)
+            dst[i] = src[srcidx];
+        else if ((fill != NULL) && ((*fill)[i] >= 0))
+            dst[i] = fillsrc[(*fill)[i]];
+        else
+            dst[i] = fillValue;
+    }
+    return column;
+}
+
+// validity of a column gathered by gatherColumn: a row is valid if its source row is valid in
+// srcvalid, if it is filled from a valid row of fillvalid or filled with a snapshot value (snapValid)
+// returns NULL if all rows are valid
+static shared_ptr<vector<unsigned long long>> gatherValidity(const vector<int>& source, const vector<unsigned long long>* srcvalid,
+                                                             const vector<int>* fill, const vector<unsigned long long>* fillvalid, bool snapValid){
+    shared_ptr<vector<unsigned long long>> bitmap = make_shared<vector<unsigned long long>>(validityWords(source.size()));
+    countAllocated();
+    bool complete = true;
+    for (size_t i = 0; i < source.size(); ++i){
+        bool valid = false;
+        if (source[i] >= 0)
+            valid = validBit(srcvalid, source[i]);
+        else if (fill != NULL)
+            valid = ((*fill)[i] >= 0) ? validBit(fillvalid, (*fill)[i]) : snapValid;
+        if (valid)
+            setValidBit(*bitmap, i);
+        else
+            complete = false;
+    }
+    if (complete) return shared_ptr<vector<unsigned long long>>();
+    return bitmap;
+}
+
+// validity of the columns of one type gathered with source and fill,
+// the validity maps are set for columns with missing values
+template <typename C>
+static void gatherValidities(const map<int, shared_ptr<C>>& srcmap, const map<int, shared_ptr<vector<unsigned long long>>>& srcvalidmap,
+                             const vector<int>& source, const vector<int>* fill, bool snapValid,
+                             map<int, shared_ptr<vector<unsigned long long>>>& dstvalidmap){
+
+    const vector<unsigned long long>* fillvalid = NULL;
+    if ((fill != NULL) && (srcvalidmap.find(0) != srcvalidmap.end())) fillvalid = srcvalidmap.at(0).get();
+    // columns without validity of their own share the row validity
+    bool rowValidDone = false;
+    shared_ptr<vector<unsigned long long>> rowValid;
+    for(auto const &vpair : srcmap) {
+        shared_ptr<vector<unsigned long long>> valid;
+        map<int, shared_ptr<vector<unsigned long long>>>::const_iterator it = srcvalidmap.find(vpair.first);
+        if (it != srcvalidmap.end())
+            valid = gatherValidity(source, it->second.get(), fill, fillvalid, snapValid);
+        else {
+            if (!rowValidDone) rowValid = gatherValidity(source, NULL, fill, fillvalid, snapValid);
+            rowValidDone = true;
+            valid = rowValid;
+        }
+        if (valid.get() != NULL) dstvalidmap.insert(pair<int, shared_ptr<vector<unsigned long long>>>(vpair.first, valid));
+    }
+}
+
 /**
  * @brief          reduce or extent the data to the new list of posrefs
  * posrefs         list of new posrefs
  */
-IData::IData(IData& data, vector<int> posrefs, FillRule fillType, IData* snapdata) : IMetaData(data)
+IData::IData(IData& data, vector<int> posrefs, FillRule fillType, IData* snapdata) : IMetaData(data), arrayRowSize(0)
 {
     if (!isArrayData()){
-        set<int> intarrs;
-        set<int> dblarrs;
-        set<int> strarrs;
-        int pcSize = posrefs.size();
         int lastint = INT_MIN;
         double lastdbl = NAN;
-        string laststring = "NaN";
+        string laststring;
+        bool snapint = false;
+        bool snapdbl = false;
+        bool snapstr = false;
         bool dofill = false;
 
         if (((fillType == LastFill) || (fillType == LastNANFill)) && (data.getDeviceType() == Axis)){
             dofill = true;
             if ((snapdata != NULL) && (!snapdata->isArrayData())) {
-                vector<int> snap_pc = snapdata->getPosReferences();
+                vector<int>& snap_pc = snapdata->posCounts;
                 if ((snap_pc.size() > 0) && (posrefs.size() > 0) && (posrefs[0] > snap_pc[0])){
                     int snap_idx=0;
                     for (unsigned int i=0; i < snap_pc.size(); ++i) if (posrefs[0] > snap_pc[i]) snap_idx = i;
-                    if (snapdata->getDataType() == DTint32) {
-                        lastint = ((vector<int>*)snapdata->getDataPointer())->at(snap_idx);
+                    if ((snapdata->getDataType() == DTint32) && (snapdata->intsptrmap.find(0) != snapdata->intsptrmap.end())) {
+                        lastint = snapdata->intsptrmap.at(0)->at(snap_idx);
+                        snapint = true;
                     }
-                    else if (snapdata->getDataType() == DTfloat64) {
-                        lastdbl = ((vector<double>*)snapdata->getDataPointer())->at(snap_idx);
+                    else if ((snapdata->getDataType() == DTfloat64) && (snapdata->dblsptrmap.find(0) != snapdata->dblsptrmap.end())) {
+                        lastdbl = snapdata->dblsptrmap.at(0)->at(snap_idx);
+                        snapdbl = true;
                     }
-                    else if (snapdata->getDataType() == DTstring) {
-                        laststring = ((vector<string>*)snapdata->getDataPointer())->at(snap_idx);
+                    else if ((snapdata->getDataType() == DTstring) && (snapdata->strsptrmap.find(0) != snapdata->strsptrmap.end())) {
+                        laststring = snapdata->strsptrmap.at(0)->str(snap_idx);
+                        snapstr = true;
                     }
                 }
             }
         }
 
-        // init
-        for(auto const &vpair : data.intsptrmap) {
-            int key = vpair.first;
-            intarrs.insert(key);
-            intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(key, make_shared<vector<int>>(pcSize)));
-        }
-        for(auto const &vpair : data.dblsptrmap) {
-            int key = vpair.first;
-            dblarrs.insert(key);
-            dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(key, make_shared<vector<double>>(pcSize)));
-        }
-        for(auto const &vpair : data.strsptrmap) {
-            int key = vpair.first;
-            strarrs.insert(key);
-            strsptrmap.insert(pair<int, shared_ptr<vector<string>>>(key, make_shared<vector<string>>(pcSize)));
-        }
+        // compute the join index once: source[i] is the row of data for posrefs[i] or -1,
+        // fill[i] the row providing the fill value of column 0 (-1: value from snapshot)
+        const vector<int>& dataPC = data.posCounts;
+        unsigned int pcSize = posrefs.size();
+        vector<int> source(pcSize, -1);
+        vector<int> fill;
+        if (dofill) fill.assign(pcSize, -1);
 
-        bool skippedValues = false;
-        bool doLast = false;
-        unsigned int idx=0;
-        unsigned int pcidx=0;
-        set<unsigned int> doublePosCounts;
-        set<unsigned int> dPosCounts (data.posCounts.begin(), data.posCounts.end());
-        // check if workaround for doublePosCount is needed
-        if ((data.getDeviceType() == Axis) && (dPosCounts.size() != data.posCounts.size())){
-           cout << "Warning: posrefs for axis " << data.getId() << " are not unique, applying doublePosRef workaround" << endl;
-           set<unsigned int> dPC = dPosCounts;
-           for (int newpc : data.posCounts) {
-               if (dPC.erase(newpc) != 1) doublePosCounts.insert(newpc);
-            }
+        PosCountIndex pcIndex(dataPC);
+        // check if workaround for doublePosCount is needed: take the last value of an axis
+        bool doublePosCounts = false;
+        if ((data.getDeviceType() == Axis) && !pcIndex.isUnique()){
+            cout << "Warning: posrefs for axis " << data.getId() << " are not unique, applying doublePosRef workaround" << endl;
+            doublePosCounts = true;
         }
-        for (int newpc : posrefs){
-            skippedValues = false;
-            while((data.posCounts[idx] < newpc) && (idx < (data.posCounts.size()-1))) {
-                ++idx;
-                skippedValues = true;
-                if (idx == data.posCounts.size() - 1) doLast = true;
-            }
-            // adjust fill values
-            unsigned int lastidx = idx;
-            if (dofill && (skippedValues || (doLast && (data.posCounts[idx] < newpc)))){
-                if (skippedValues)
-                    lastidx = idx - 1;
-                else
-                    doLast = false;
-                if (doublePosCounts.find(data.posCounts[idx]) != doublePosCounts.end()) {
-                    for (int dindex = data.posCounts.size()-1; dindex >= 0; --dindex){
-                        if (data.posCounts[dindex] == data.posCounts[idx]) {
-                            lastidx = dindex;
-                            break;
-                        }
-                    }
-                }
-                if (intsptrmap.find(0) != intsptrmap.end()) lastint = data.intsptrmap.at(0)->at(lastidx);
-                if (dblsptrmap.find(0) != dblsptrmap.end()) lastdbl = data.dblsptrmap.at(0)->at(lastidx);
-                if (strsptrmap.find(0) != strsptrmap.end()) laststring = data.strsptrmap.at(0)->at(lastidx);
+        // posCount appears more than once, only checked if workaround is enabled
+        auto isDouble = [&](int posCount){
+            return doublePosCounts && (pcIndex.firstOf(posCount) != pcIndex.lastOf(posCount));
+        };
 
-            }
-
-            if (doublePosCounts.find(newpc) != doublePosCounts.end()) {
-                // apply workaround for doublePosCount
-                // take the last value if axis, take the first value if channel
-                for (int dindex = data.posCounts.size()-1; dindex >= 0; --dindex){
-                    if (data.posCounts[dindex] == newpc) {
-                        for (int j : intarrs){
-                            intsptrmap.at(j)->at(pcidx) = data.intsptrmap.at(j)->at(dindex);
-                            if (dofill && (j == 0)) lastint = data.intsptrmap.at(j)->at(dindex);
-                        }
-                        for (int j : dblarrs){
-                            dblsptrmap.at(j)->at(pcidx) = data.dblsptrmap.at(j)->at(dindex);
-                            if (dofill && (j == 0)) lastdbl = data.dblsptrmap.at(j)->at(dindex);
-                        }
-                        for (int j : strarrs){
-                            strsptrmap.at(j)->at(pcidx) = data.strsptrmap.at(j)->at(dindex);
-                            if (dofill && (j == 0)) laststring = data.strsptrmap.at(j)->at(dindex);
-                        }
-                        break;
-                    }
-                }
-            }
-            else if (data.posCounts[idx] == newpc) {
-                for (int j : intarrs){
-                    intsptrmap.at(j)->at(pcidx) = data.intsptrmap.at(j)->at(idx);
-                    if (dofill && (j == 0)) lastint = data.intsptrmap.at(j)->at(idx);
-                }
-                for (int j : dblarrs){
-                    dblsptrmap.at(j)->at(pcidx) = data.dblsptrmap.at(j)->at(idx);
-                    if (dofill && (j == 0)) lastdbl = data.dblsptrmap.at(j)->at(idx);
+        if (dataPC.size() > 0){
+            unsigned int last = dataPC.size() - 1;
+            bool doLast = false;
+            unsigned int idx=0;
+            int lastSource = -1;
+            for (unsigned int pcidx = 0; pcidx < pcSize; ++pcidx){
+                int newpc = posrefs[pcidx];
+                bool skippedValues = false;
+                while((dataPC[idx] < newpc) && (idx < last)) {
+                    ++idx;
+                    skippedValues = true;
+                    if (idx == last) doLast = true;
                 }
-                for (int j : strarrs){
-                    strsptrmap.at(j)->at(pcidx) = data.strsptrmap.at(j)->at(idx);
-                    if (dofill && (j == 0)) laststring = data.strsptrmap.at(j)->at(idx);
+                // adjust fill values
+                if (dofill && (skippedValues || (doLast && (dataPC[idx] < newpc)))){
+                    int lastidx = idx;
+                    if (skippedValues)
+                        lastidx = idx - 1;
+                    else
+                        doLast = false;
+                    if (isDouble(dataPC[idx])) lastidx = pcIndex.lastOf(dataPC[idx]);
+                    lastSource = lastidx;
                 }
-                if (idx < (data.posCounts.size()-1)) {
-                    ++idx;
-                    if (idx == data.posCounts.size() - 1) doLast = true;
+
+                int srcidx = -1;
+                if (isDouble(newpc)) {
+                    srcidx = pcIndex.lastOf(newpc);
                 }
-            }
-            else {
-                // posCounts may be unsorted
-                if (dPosCounts.find(newpc) != dPosCounts.end()){
-                   for (unsigned int dindex = 0; dindex < data.posCounts.size(); ++dindex){
-                        if (data.posCounts[dindex] == newpc) {
-                            for (int j : intarrs){
-                                intsptrmap.at(j)->at(pcidx) = data.intsptrmap.at(j)->at(dindex);
-                                if (dofill && (j == 0)) lastint = data.intsptrmap.at(j)->at(dindex);
-                            }
-                            for (int j : dblarrs){
-                                dblsptrmap.at(j)->at(pcidx) = data.dblsptrmap.at(j)->at(dindex);
-                                if (dofill && (j == 0)) lastdbl = data.dblsptrmap.at(j)->at(dindex);
-                            }
-                            for (int j : strarrs){
-                                strsptrmap.at(j)->at(pcidx) = data.strsptrmap.at(j)->at(dindex);
-                                if (dofill && (j == 0)) laststring = data.strsptrmap.at(j)->at(dindex);
-                            }
-                            break;
-                        }
+                else if (dataPC[idx] == newpc) {
+                    srcidx = idx;
+                    if (idx < last) {
+                        ++idx;
+                        if (idx == last) doLast = true;
                     }
                 }
                 else {
-                    int intval = INT_MIN;
-                    double dblval = NAN;
-                    string strval = "NaN";
-                    for (int j : intarrs){
-                        if(dofill && (j == 0)) intval = lastint;
-                        intsptrmap.at(j)->at(pcidx) = intval;
-                    }
-                    for (int j : dblarrs){
-                        if(dofill && (j == 0)) dblval = lastdbl;
-                        dblsptrmap.at(j)->at(pcidx) = dblval;
-                    }
-                    for (int j : strarrs){
-                        if(dofill && (j == 0)) strval = laststring;
-                        strsptrmap.at(j)->at(pcidx) = strval;
-                    }
+                    // posCounts may be unsorted
+                    srcidx = pcIndex.firstOf(newpc);
+                }
+                if (srcidx >= 0){
+                    source[pcidx] = srcidx;
+                    lastSource = srcidx;
                 }
+                else if (dofill)
+                    fill[pcidx] = lastSource;
             }
-            ++pcidx;
         }
+
+        // gather all columns; when filling an axis, all columns of a type having a
+        // column 0 get the last value of column 0. Rows without value keep INT_MIN or NAN
+        // for compatibility, strings remain empty; the validity maps mark these rows.
+        bool fillint = dofill && (data.intsptrmap.find(0) != data.intsptrmap.end());
+        bool filldbl = dofill && (data.dblsptrmap.find(0) != data.dblsptrmap.end());
+        bool fillstr = dofill && (data.strsptrmap.find(0) != data.strsptrmap.end());
+        for(auto const &vpair : data.intsptrmap) {
+            intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(vpair.first, gatherColumn<int>(*vpair.second, source,
+                fillint ? *data.intsptrmap.at(0) : *vpair.second, fillint ? &fill : NULL, fillint ? lastint : INT_MIN)));
+        }
+        for(auto const &vpair : data.dblsptrmap) {
+            dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(vpair.first, gatherColumn<double>(*vpair.second, source,
+                filldbl ? *data.dblsptrmap.at(0) : *vpair.second, filldbl ? &fill : NULL, filldbl ? lastdbl : NAN)));
+        }
+        for(auto const &vpair : data.strsptrmap) {
+            strsptrmap.insert(pair<int, shared_ptr<StringColumn>>(vpair.first, StringColumn::gather(*vpair.second, source,
+                fillstr ? *data.strsptrmap.at(0) : *vpair.second, fillstr ? &fill : NULL, (fillstr && snapstr) ? &laststring : NULL)));
+        }
+        gatherValidities(data.intsptrmap, data.intvalidmap, source, fillint ? &fill : NULL, snapint, intvalidmap);
+        gatherValidities(data.dblsptrmap, data.dblvalidmap, source, filldbl ? &fill : NULL, snapdbl, dblvalidmap);
+        gatherValidities(data.strsptrmap, data.strvalidmap, source, fillstr ? &fill : NULL, snapstr, strvalidmap);
+    }
+    else if (posrefs == data.posCounts) {
+        arrayBlock = data.arrayBlock;
+        arrayRowSize = data.arrayRowSize;
+        posRowIndex = data.posRowIndex;
     }
-    else {
-        set<int> setposrefs(posrefs.begin(), posrefs.end());
-        posPtrHash = data.posPtrHash;
-        for (int pc : data.posCounts) {
-            if ((setposrefs.find(pc) == setposrefs.end()) && (posPtrHash.find(pc) != posPtrHash.end())) posPtrHash.erase(pc);
+    else if ((data.arrayBlock.get() != NULL) && (posrefs.size() > 0)) {
+        // gather the rows into a new block, rows without data remain zero
+        arrayRowSize = data.arrayRowSize;
+        arrayBlock = shared_ptr<char>(new char[arrayRowSize * posrefs.size()](), default_delete<char[]>());
+        for (unsigned int row = 0; row < posrefs.size(); ++row) {
+            map<int, unsigned int>::iterator it = data.posRowIndex.find(posrefs[row]);
+            if (it == data.posRowIndex.end()) continue;
+            memcpy(arrayBlock.get() + row * arrayRowSize, data.arrayBlock.get() + it->second * arrayRowSize, arrayRowSize);
+            posRowIndex.insert(pair<int, unsigned int>(posrefs[row], row));
         }
     }
     posCounts = posrefs;
     dim0 = posCounts.size();
 }
 
+/**
+ * @brief          data with the given rows of data (not for array data)
+ * posrefs         list of new posrefs
+ * rows            row of data for each posref, -1 if the posref has no value
+ */
+IData::IData(IData& data, const vector<int>& posrefs, const vector<int>& rows) : IMetaData(data), arrayRowSize(0)
+{
+    for(auto const &vpair : data.intsptrmap)
+        intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(vpair.first, gatherColumn<int>(*vpair.second, rows, *vpair.second, NULL, INT_MIN)));
+    for(auto const &vpair : data.dblsptrmap)
+        dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(vpair.first, gatherColumn<double>(*vpair.second, rows, *vpair.second, NULL, NAN)));
+    for(auto const &vpair : data.strsptrmap)
+        strsptrmap.insert(pair<int, shared_ptr<StringColumn>>(vpair.first, StringColumn::gather(*vpair.second, rows, *vpair.second, NULL, NULL)));
+    gatherValidities(data.intsptrmap, data.intvalidmap, rows, NULL, false, intvalidmap);
+    gatherValidities(data.dblsptrmap, data.dblvalidmap, rows, NULL, false, dblvalidmap);
+    gatherValidities(data.strsptrmap, data.strvalidmap, rows, NULL, false, strvalidmap);
+    posCounts = posrefs;
+    dim0 = posCounts.size();
+}
+
 IData::~IData()
 {
 }
@@ -214,35 +314,44 @@ IData::~IData()
 void* IData::getArrayDataPointer(unsigned int row)
 {
     void *ptr=NULL;
-    if (isArrayData() && row < posCounts.size()){
-        int posRef = posCounts[row];
-        map<int, shared_ptr<char>>::iterator it = posPtrHash.find(posRef);
-        if ( it != posPtrHash.end()) {
-            if (datatype == DTint32)
-                ptr = new vector<int>((int*)it->second.get(), (int*)it->second.get()+dim1);
-            else if (datatype == DTfloat64)
-                ptr = new vector<double>((double*)it->second.get(), (double*)it->second.get()+dim1);
-            else if (datatype == DTint8)
-                ptr = new vector<char>((char*)it->second.get(), (char*)it->second.get()+dim1);
-            else if (datatype == DTint16)
-                ptr = new vector<short>((short*)it->second.get(), (short*)it->second.get()+dim1);
-            else if (datatype == DTint64)
-                ptr = new vector<long long>((long long*)it->second.get(), (long long*)it->second.get()+dim1);
-            else if (datatype == DTuint8)
-                ptr = new vector<unsigned char>((unsigned char*)it->second.get(), (unsigned char*)it->second.get()+dim1);
-            else if (datatype == DTuint16)
-                ptr = new vector<unsigned short>((unsigned short*)it->second.get(), (unsigned short*)it->second.get()+dim1);
-            else if (datatype == DTuint32)
-                ptr = new vector<unsigned int>((unsigned int*)it->second.get(), (unsigned int*)it->second.get()+dim1);
-            else if (datatype == DTuint64)
-                ptr = new vector<unsigned long long>((unsigned long long*)it->second.get(), (unsigned long long*)it->second.get()+dim1);
-            else if (datatype == DTfloat32)
-                ptr = new vector<float>((float*)it->second.get(), (float*)it->second.get()+dim1);
-        }
+    if (hasArrayRow(row)){
+        char* rowptr = arrayBlock.get() + posRowIndex.at(posCounts[row]) * arrayRowSize;
+        if (datatype == DTint32)
+            ptr = new vector<int>((int*)rowptr, (int*)rowptr+dim1);
+        else if (datatype == DTfloat64)
+            ptr = new vector<double>((double*)rowptr, (double*)rowptr+dim1);
+        else if (datatype == DTint8)
+            ptr = new vector<char>((char*)rowptr, (char*)rowptr+dim1);
+        else if (datatype == DTint16)
+            ptr = new vector<short>((short*)rowptr, (short*)rowptr+dim1);
+        else if (datatype == DTint64)
+            ptr = new vector<long long>((long long*)rowptr, (long long*)rowptr+dim1);
+        else if (datatype == DTuint8)
+            ptr = new vector<unsigned char>((unsigned char*)rowptr, (unsigned char*)rowptr+dim1);
+        else if (datatype == DTuint16)
+            ptr = new vector<unsigned short>((unsigned short*)rowptr, (unsigned short*)rowptr+dim1);
+        else if (datatype == DTuint32)
+            ptr = new vector<unsigned int>((unsigned int*)rowptr, (unsigned int*)rowptr+dim1);
+        else if (datatype == DTuint64)
+            ptr = new vector<unsigned long long>((unsigned long long*)rowptr, (unsigned long long*)rowptr+dim1);
+        else if (datatype == DTfloat32)
+            ptr = new vector<float>((float*)rowptr, (float*)rowptr+dim1);
     }
     return ptr;
 }
 
+MatrixView<char> IData::getArrayBlock()
+{
+    if (!isArrayData() || (arrayBlock.get() == NULL)) return MatrixView<char>();
+    return MatrixView<char>(arrayBlock, arrayBlock.get(), posCounts.size(), arrayRowSize, arrayRowSize);
+}
+
+bool IData::hasArrayRow(unsigned int row)
+{
+    if (!isArrayData() || (row >= posCounts.size())) return false;
+    return (posRowIndex.find(posCounts[row]) != posRowIndex.end());
+}
+
 void* IData::getDataPointer()
 {
     void *ptr = NULL;
@@ -251,7 +360,14 @@ void* IData::getDataPointer()
             ptr = new vector<double>(*dblsptrmap.at(0));
         }
         else if ((datatype == DTstring) && (strsptrmap.find(0) != strsptrmap.end())){
-            ptr = new vector<string>(*strsptrmap.at(0));
+            vector<string>* strings = new vector<string>(strsptrmap.at(0)->toStrings());
+            // the copy keeps the former "NaN" fill value for rows without value
+            if (strvalidmap.find(0) != strvalidmap.end()){
+                vector<unsigned long long>* valid = strvalidmap.at(0).get();
+                for (size_t i = 0; i < strings->size(); ++i)
+                    if (!validBit(valid, i)) strings->at(i) = "NaN";
+            }
+            ptr = strings;
         }
         else if (intsptrmap.find(0) != intsptrmap.end()) {
             ptr = new vector<int>(*intsptrmap.at(0));
@@ -260,6 +376,79 @@ void* IData::getDataPointer()
     return ptr;
 }
 
+DataView<int> IData::getIntView()
+{
+    if (isArrayData() || (datatype == DTfloat64) || (datatype == DTfloat32) || (datatype == DTstring))
+        return DataView<int>();
+    return intView(INTVECT1);
+}
+
+DataView<double> IData::getDoubleView()
+{
+    if (isArrayData() || ((datatype != DTfloat64) && (datatype != DTfloat32)))
+        return DataView<double>();
+    return doubleView(DBLVECT1);
+}
+
+DataView<string> IData::getStringView()
+{
+    if (isArrayData() || (datatype != DTstring))
+        return DataView<string>();
+    return stringView(STRVECT1);
+}
+
+// validity of column 0, which holds the values of getIntView(), getDoubleView() or getStringView()
+DataView<unsigned long long> IData::getValidity()
+{
+    if (isArrayData()) return DataView<unsigned long long>();
+    map<int, shared_ptr<vector<unsigned long long>>>* validmap = &intvalidmap;
+    if ((datatype == DTfloat64) || (datatype == DTfloat32))
+        validmap = &dblvalidmap;
+    else if (datatype == DTstring)
+        validmap = &strvalidmap;
+    map<int, shared_ptr<vector<unsigned long long>>>::iterator it = validmap->find(0);
+    if (it == validmap->end()) return DataView<unsigned long long>();
+    return DataView<unsigned long long>(it->second, it->second->data(), it->second->size());
+}
+
+bool IData::isValid(unsigned int row)
+{
+    if (row >= posCounts.size()) return false;
+    if (isArrayData()) return hasArrayRow(row);
+    DataView<unsigned long long> valid = getValidity();
+    return valid.empty() || (valid[row / 64] & (1ULL << (row % 64)));
+}
+
+// the view shares ownership of the column vector
+DataView<int> IData::intView(int col){
+    map<int, shared_ptr<vector<int>>>::iterator it = intsptrmap.find(col);
+    if (it == intsptrmap.end()) return DataView<int>();
+    return DataView<int>(it->second, it->second->data(), it->second->size());
+}
+DataView<double> IData::doubleView(int col){
+    map<int, shared_ptr<vector<double>>>::iterator it = dblsptrmap.find(col);
+    if (it == dblsptrmap.end()) return DataView<double>();
+    return DataView<double>(it->second, it->second->data(), it->second->size());
+}
+// the strings of the view are created once per column
+DataView<string> IData::stringView(int col){
+    map<int, shared_ptr<vector<string>>>::iterator it = strviewmap.find(col);
+    if (it == strviewmap.end()){
+        map<int, shared_ptr<StringColumn>>::iterator cit = strsptrmap.find(col);
+        if (cit == strsptrmap.end()) return DataView<string>();
+        it = strviewmap.insert(pair<int, shared_ptr<vector<string>>>(col, make_shared<vector<string>>(cit->second->toStrings()))).first;
+    }
+    return DataView<string>(it->second, it->second->data(), it->second->size());
+}
+
+StringColumnView IData::getStringColumn()
+{
+    if (isArrayData() || (datatype != DTstring)) return StringColumnView();
+    map<int, shared_ptr<StringColumn>>::iterator it = strsptrmap.find(STRVECT1);
+    if (it == strsptrmap.end()) return StringColumnView();
+    return it->second->view(it->second);
+}
+
 vector<int> IData::getAverageAttemptsPreset(){
     if (intsptrmap.find(AVATTPR) != intsptrmap.end()) return vector<int>(*intsptrmap.at(AVATTPR));
     return vector<int>();
@@ -7,6 +7,7 @@
 #include <map>
 #include "eve.h"
 #include "IMetaData.h"
+#include "stringcolumn.h"
 
 using namespace std;
 
@@ -33,6 +34,11 @@ namespace eve {
 #define STRVECT2 1
 #define STRVECTMAX 2
 
+// validity bitmaps: bit (row % 64) of word (row / 64) is set if row has a value
+inline size_t validityWords(size_t rows){return (rows + 63) / 64;};
+inline void setValidBit(vector<unsigned long long>& bitmap, size_t row){bitmap[row / 64] |= 1ULL << (row % 64);};
+inline bool validBit(const vector<unsigned long long>* bitmap, size_t row){return (bitmap == NULL) || ((*bitmap)[row / 64] & (1ULL << (row % 64)));};
+
 
 class IData : public IMetaData, public Data
 {
@@ -40,6 +46,7 @@ class IData : public IMetaData, public Data
 public:
     IData(IMetaData&);
     IData(IData&, vector<int>, FillRule fillType, IData *snapdata=NULL);
+    IData(IData&, const vector<int>& posrefs, const vector<int>& rows);
     virtual ~IData();
 
     string getName(){return IMetaData::getName();};
@@ -72,17 +79,50 @@ public:
     vector<int> getStddevCount();
     vector<double> getStddeviation();
     vector<double> getTriggerIntv();
+    DataView<int> getIntView();
+    DataView<double> getDoubleView();
+    DataView<string> getStringView();
+    StringColumnView getStringColumn();
+    DataView<int> getAverageAttemptsPresetView(){return intView(AVATTPR);};
+    DataView<int> getAverageAttemptsView(){return intView(AVATT);};
+    DataView<int> getAverageCountPresetView(){return intView(AVCOUNTPR);};
+    DataView<int> getAverageCountView(){return intView(AVCOUNT);};
+    DataView<double> getAverageLimitPresetView(){return doubleView(AVLIMIT);};
+    DataView<double> getAverageMaxDeviationPresetView(){return doubleView(AVMAXDEV);};
+    DataView<int> getStddevCountView(){return intView(STDDEVCOUNT);};
+    DataView<double> getStddeviationView(){return doubleView(STDDEV);};
+    DataView<double> getTriggerIntvView(){return doubleView(TRIGGERINTV);};
+    MatrixView<char> getArrayBlock();
+    bool hasArrayRow(unsigned int row);
+    DataView<unsigned long long> getValidity();
+    bool isValid(unsigned int row);
 
 
 private:
+    DataView<int> intView(int col);
+    DataView<double> doubleView(int col);
+    DataView<string> stringView(int col);
     vector<int> posCounts;
-    map<int, shared_ptr<char>> posPtrHash;
+    // array data: one row-major block, row i belongs to posCounts[i]
+    shared_ptr<char> arrayBlock;
+    size_t arrayRowSize;
+    map<int, unsigned int> posRowIndex;
     map<int, shared_ptr<vector<int>>> intsptrmap;
     map<int, shared_ptr<vector<double>>> dblsptrmap;
-    map<int, shared_ptr<vector<string>>> strsptrmap;
+    map<int, shared_ptr<StringColumn>> strsptrmap;
+    // strings of getStringView(), created on first use
+    map<int, shared_ptr<vector<string>>> strviewmap;
+    // validity of the columns with the same key, a column without entry has a value in every row
+    map<int, shared_ptr<vector<unsigned long long>>> intvalidmap;
+    map<int, shared_ptr<vector<unsigned long long>>> dblvalidmap;
+    map<int, shared_ptr<vector<unsigned long long>>> strvalidmap;
 
     friend class IH5File;
     friend class IH5FileV5;
+    friend class DataCache;
+    friend class JoinSource;
+    friend class DataCompute;
+    friend class DataComputeAccess;
 };
 
 } // namespace end
@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <stdlib.h>
 #include <set>
+#include <sys/stat.h>
 #include "IFile.h"
 #include "IH5File.h"
 #include <H5Exception.h>
@@ -24,47 +25,69 @@ using namespace std;
 namespace eve {
 
 DataFile* DataFile::openFile(string name){return new IFile(name);};
+DataFile* DataFile::openFile(string name, const OpenOptions& options){return new IFile(name, options);};
 
-IFile::IFile(string filename)
+IFile::IFile(string filename, OpenOptions options) : statsCallback(options.statsCallback)
 {
+    // opening and the inventory read now are reported as one call
+    StatsScope stats(statsCallback, "openFile");
     ih5file = NULL;
-    H5File h5file;
+    prefetcher = NULL;
     h5version = 0.0;
 
-    Exception::dontPrint();
+    // the H5 objects are made with the H5 lock held, init() takes it for its H5 calls
+    {
+        H5Lock lock(h5Mutex());
+        H5File h5file;
 
-    try {
-        if (H5File::isHdf5(filename))
-            h5file.openFile(filename, H5F_ACC_RDONLY);
-        else {
-            STHROW("Error opening file " << filename << "; unsupported file format " );
-            return;
-        }
-    }
-    catch (H5::Exception error){
-        STHROW("Error opening file " << filename << "; H5 Error: " << error.getDetailMsg() );
-    }
-
-    Group root;
-    openGroupH5(h5file, root, "/");
-    getH5Version(root);
-    closeGroupH5(root);
+        Exception::dontPrint();
 
-    if ((h5version > EVEH5VERSIONMAXIMUM) || (h5version < EVEH5VERSIONMINIMUM))
-        STHROW("EVEH5 version mismatch, file " << h5version << ", supported "
-               << (float)EVEH5VERSIONMINIMUM << " - " << (float)EVEH5VERSIONMAXIMUM << "\n");
-
-    if (h5version >= 5.0)
-        ih5file = new IH5FileV5(h5file, filename, h5version);
-    else if (h5version >= 4.0)
-        ih5file = new IH5FileV4(h5file, filename, h5version);
-    else if (h5version >= 3.0)
-        ih5file = new IH5FileV3(h5file, filename, h5version);
-    else if (h5version >= 2.0)
-        ih5file = new IH5FileV2(h5file, filename, h5version);
-    else
-        ih5file = new IH5File(h5file, filename, h5version);
+        try {
+            if (H5File::isHdf5(filename)){
+                FileAccPropList fapl = accessProperties(filename, options);
+                // files not written with SWMR support can't be opened for SWMR reading
+                bool opened = false;
+                if (options.followFile){
+                    try {
+                        openFileH5(h5file, filename, H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, fapl, options);
+                        opened = true;
+                    }
+                    catch (H5::Exception error){
+                    }
+                }
+                if (!opened) openFileH5(h5file, filename, H5F_ACC_RDONLY, fapl, options);
+            }
+            else {
+                STHROW("Error opening file " << filename << "; unsupported file format " );
+                return;
+            }
+        }
+        catch (H5::Exception error){
+            STHROW("Error opening file " << filename << "; H5 Error: " << error.getDetailMsg() );
+        }
 
+        Group root;
+        openGroupH5(h5file, root, "/");
+        getH5Version(root);
+        closeGroupH5(root);
+
+        if ((h5version > EVEH5VERSIONMAXIMUM) || (h5version < EVEH5VERSIONMINIMUM))
+            STHROW("EVEH5 version mismatch, file " << h5version << ", supported "
+                   << (float)EVEH5VERSIONMINIMUM << " - " << (float)EVEH5VERSIONMAXIMUM << "\n");
+
+        if (h5version >= 5.0)
+            ih5file = new IH5FileV5(h5file, filename, h5version);
+        else if (h5version >= 4.0)
+            ih5file = new IH5FileV4(h5file, filename, h5version);
+        else if (h5version >= 3.0)
+            ih5file = new IH5FileV3(h5file, filename, h5version);
+        else if (h5version >= 2.0)
+            ih5file = new IH5FileV2(h5file, filename, h5version);
+        else
+            ih5file = new IH5File(h5file, filename, h5version);
+
+        ih5file->setOptions(options);
+    }
     try {
         ih5file->init();
     }
@@ -72,6 +95,7 @@ IFile::IFile(string filename)
         string errormessage = "";
 
         try {
+            H5Lock lock(h5Mutex());
             if (ih5file != NULL) delete ih5file;
         }
         catch(Exception error){
@@ -81,14 +105,83 @@ IFile::IFile(string filename)
         ih5file = NULL;
         STHROW("Error during init" << filename << "; H5 Error: " << error.getDetailMsg() );
     }
+    if (options.prefetch && !options.deferInventory) prefetcher = new IPrefetcher(ih5file);
     return;
 }
 
 IFile::~IFile()
 {
+    // stop the prefetcher before, it may be reading
+    if (prefetcher != NULL) delete prefetcher;
+    H5Lock lock(h5Mutex());
     if (ih5file != NULL) delete ih5file;
 }
 
+// file access properties for driver and caches of options
+FileAccPropList IFile::accessProperties(const string& filename, const OpenOptions& options){
+
+    FileAccPropList fapl;
+    FileDriver driver = options.driver;
+    struct stat status;
+    if ((options.coreLimit > 0) && !options.followFile && (stat(filename.c_str(), &status) == 0)
+            && ((size_t)status.st_size <= options.coreLimit))
+        driver = CoreDriver;
+
+    if (driver == CoreDriver)
+        fapl.setCore(1024 * 1024, false);
+    else if (driver == DirectDriver){
+#ifdef H5_HAVE_DIRECT
+        if (H5Pset_fapl_direct(fapl.getId(), 4096, 4096, 16 * 1024 * 1024) < 0)
+            STHROW("Error opening file " << filename << "; unable to set direct driver");
+#else
+        STHROW("Error opening file " << filename << "; direct driver not supported by H5 library");
+#endif
+    }
+
+    if ((options.chunkCacheSize > 0) || (options.chunkCacheSlots > 0)){
+        int mdcElements;
+        size_t slots;
+        size_t bytes;
+        double preemption;
+        fapl.getCache(mdcElements, slots, bytes, preemption);
+        if (options.chunkCacheSlots > 0) slots = options.chunkCacheSlots;
+        if (options.chunkCacheSize > 0) bytes = options.chunkCacheSize;
+        fapl.setCache(mdcElements, slots, bytes, preemption);
+    }
+
+    if (options.metadataCacheSize > 0){
+        H5AC_cache_config_t config;
+        config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+        if (H5Pget_mdc_config(fapl.getId(), &config) < 0)
+            STHROW("Error opening file " << filename << "; unable to get metadata cache configuration");
+        config.set_initial_size = true;
+        config.initial_size = options.metadataCacheSize;
+        if (config.max_size < config.initial_size) config.max_size = config.initial_size;
+        if (config.min_size > config.initial_size) config.min_size = config.initial_size;
+        if (H5Pset_mdc_config(fapl.getId(), &config) < 0)
+            STHROW("Error opening file " << filename << "; unable to set metadata cache size " << options.metadataCacheSize);
+    }
+
+    if ((options.pageBufferSize > 0) && (H5Pset_page_buffer_size(fapl.getId(), options.pageBufferSize, 0, 0) < 0))
+        STHROW("Error opening file " << filename << "; unable to set page buffer size " << options.pageBufferSize);
+    return fapl;
+}
+
+// files not written with paged file space strategy can't be opened with a page buffer,
+// they are opened without
+void IFile::openFileH5(H5File& h5file, const string& filename, unsigned int flags, FileAccPropList& fapl, const OpenOptions& options){
+    if (options.pageBufferSize > 0){
+        try {
+            h5file.openFile(filename, flags, fapl);
+            return;
+        }
+        catch (H5::Exception error){
+            H5Pset_page_buffer_size(fapl.getId(), 0, 0, 0);
+        }
+    }
+    h5file.openFile(filename, flags, fapl);
+}
+
 void IFile::openGroupH5(H5File h5file, Group& h5group, string path){
     try {
         h5group = h5file.openGroup(path);
@@ -12,6 +12,10 @@
 #include "IData.h"
 #include "IH5File.h"
 #include "IMetaData.h"
+#include "iresultset.h"
+#include "h5lock.h"
+#include "iprefetcher.h"
+#include "icallstats.h"
 
 #ifndef H5_NO_NAMESPACE
      using namespace H5;
@@ -23,24 +27,50 @@ namespace eve {
 
 class IFile : public DataFile {
 public:
-    IFile(string);
+    IFile(string, OpenOptions options=OpenOptions());
     virtual ~IFile();
 
-    vector<int> getChains(){return ih5file->getChains();};
+    // reads use the inventory of the chain of their metadata, the H5 lock is taken for H5 calls only.
+    // Calls reading from the file are counted for the stats callback.
+    vector<int> getChains(){CallScope call(prefetcher); return ih5file->getChains();};
     int getChain(){return ih5file->getChain();};
-    void setChain(int chain){ih5file->setChain(chain);};
-    ChainMetaData* getChainMetaData(){return ih5file->getChainMetaData();};
-    FileMetaData* getFileMetaData(){return ih5file->getFileMetaData();};
-    vector<MetaData *> getMetaData(Section section, string id, string name){return ih5file->getMetaData(section, id, name);};
-    vector<Data*> getData(vector<MetaData*>& mdvec){return ih5file->getData(mdvec);};
-    vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill=NoFill){return ih5file->getJoinedData(mdvec, fill);};
-    vector<Data*> getPreferredData(FillRule fill){return ih5file->getPreferredData(fill);};
-    vector<string> getLogData(){return ih5file->getLogData();};
-    string getNameById(Section section, std::string id){return ih5file->getNameById(section, id);};
+    void setChain(int chain){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "setChain"); ih5file->setChain(chain);};
+    ChainMetaData* getChainMetaData(){CallScope call(prefetcher); return ih5file->getChainMetaData(ih5file->getChain());};
+    ChainMetaData* getChainMetaData(int chain){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getChainMetaData"); return ih5file->getChainMetaData(chain);};
+    FileMetaData* getFileMetaData(){CallScope call(prefetcher); return ih5file->getFileMetaData();};
+    vector<MetaData *> getMetaData(Section section, string id, string name){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getMetaData"); return ih5file->getMetaData(*inventory(), section, id, name);};
+    vector<MetaData *> getMetaData(int chain, Section section, string id, string name){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getMetaData"); return ih5file->getMetaData(*ih5file->getInventory(chain), section, id, name);};
+    vector<Data*> getData(vector<MetaData*>& mdvec){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getData"); return ih5file->getData(*inventory(mdvec), mdvec);};
+    vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill=NoFill){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getJoinedData"); return ih5file->getJoinedData(*inventory(mdvec), mdvec, fill);};
+    vector<Data*> getData(vector<MetaData*>& mdvec, const Selection& selection){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getData"); return ih5file->getData(*inventory(mdvec), mdvec, selection);};
+    vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill, const Selection& selection){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getJoinedData"); return ih5file->getJoinedData(*inventory(mdvec), mdvec, fill, selection);};
+    vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill, TimeAlignment alignment){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getJoinedData"); return ih5file->getJoinedData(*inventory(mdvec), mdvec, fill, alignment);};
+    vector<Data*> getPreferredData(FillRule fill){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getPreferredData"); return ih5file->getPreferredData(*inventory(), fill);};
+    vector<Data*> getPreferredData(int chain, FillRule fill){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getPreferredData"); return ih5file->getPreferredData(*ih5file->getInventory(chain), fill);};
+    vector<string> getLogData(){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getLogData"); return ih5file->getLogData();};
+    string getNameById(Section section, std::string id){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getNameById"); return ih5file->getNameById(*inventory(), section, id);};
+    string getNameById(int chain, Section section, std::string id){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getNameById"); return ih5file->getNameById(*ih5file->getInventory(chain), section, id);};
+    DataStream* openStream(MetaData* metadata, unsigned int chunkRows){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "openStream"); return ih5file->openStream(metadata, chunkRows);};
+    JoinedStream* openJoinedStream(vector<MetaData*>& mdvec, FillRule fill, unsigned int chunkRows){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "openJoinedStream"); return ih5file->openJoinedStream(*inventory(mdvec), mdvec, fill, chunkRows);};
+    void refresh(){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "refresh"); ih5file->refresh();};
+    ColumnarTable* getColumnarData(vector<MetaData*>& mdvec, FillRule fill){CallScope call(prefetcher); StatsScope stats(getStatsCallback(), "getColumnarData"); return ih5file->getColumnarData(*inventory(mdvec), mdvec, fill);};
+    ResultSet* createResultSet(){return new IResultSet(this);};
+    vector<Data*> getBatchData(const BatchSelection& selection){return ih5file->getBatchData(selection);};
+    void setReadControl(ReadControl* control){ih5file->setReadControl(control);};
+    void setStatsCallback(const StatsCallback& callback){lock_guard<mutex> lock(statsMutex); statsCallback = callback;};
 
 private:
     IH5File* ih5file;
+    IPrefetcher* prefetcher;
+    StatsCallback statsCallback;
+    mutex statsMutex;
+    StatsCallback getStatsCallback(){lock_guard<mutex> lock(statsMutex); return statsCallback;};
+    // inventory of the selected chain or of the chain of mdvec, kept by the caller while it reads
+    InventoryPtr inventory(){return ih5file->getInventory(ih5file->getChain());};
+    InventoryPtr inventory(vector<MetaData*>& mdvec){return ih5file->getInventory(ih5file->chainOf(mdvec));};
     float h5version;
+    FileAccPropList accessProperties(const string& filename, const OpenOptions& options);
+    void openFileH5(H5File& h5file, const string& filename, unsigned int flags, FileAccPropList& fapl, const OpenOptions& options);
     void openGroupH5(H5File, Group&, string);
     void closeGroupH5(Group&);
     void getH5Version(Group&);
@@ -6,7 +6,14 @@
 #include <stdlib.h>
 #include <algorithm>    // std::sort
 #include <set>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "IH5File.h"
+#include "inventoryfile.h"
+#include "icolumnartable.h"
 #include <H5Exception.h>
 
 using namespace std;
@@ -40,6 +47,34 @@ struct enumstruct {
 #define STR_STRUCT_SIZE 45
 #define ENUM_STRUCT_SIZE 21
 
+// decode the member at offset of count packed records into dst, converting from S to D.
+// Records are not aligned, memcpy with a constant size compiles to a plain load.
+template <typename S, typename D>
+static void decodeMember(const char* records, size_t recordSize, size_t offset, size_t count, D* dst){
+    const char* src = records + offset;
+    for (size_t i = 0; i < count; ++i, src += recordSize){
+        S value;
+        memcpy(&value, src, sizeof(S));
+        dst[i] = static_cast<D>(value);
+    }
+}
+
+// decode the fixed size, zero padded string member at offset of count packed records,
+// enum records (and shorter strings) get a dictionary column if they have few distinct values
+static void decodeStringMember(const char* records, size_t recordSize, size_t offset, size_t count, shared_ptr<eve::StringColumn>& dst){
+    size_t length = recordSize - offset;
+    const char* src = records + offset;
+    dst = make_shared<eve::StringColumn>(recordSize <= ENUM_STRUCT_SIZE);
+    size_t bytes = 0;
+    if (!dst->isDictionary())
+        for (size_t i = 0; i < count; ++i) bytes += strnlen(src + i * recordSize, length);
+    dst->reserve(count, bytes);
+    for (size_t i = 0; i < count; ++i, src += recordSize){
+        dst->append(src, strnlen(src, length));
+    }
+    dst->compact();
+}
+
 namespace eve {
 
 // expects an already opened h5 Filehandle
@@ -54,24 +89,48 @@ IH5File::IH5File(H5::H5File oh5file, string file, float version)
     sections = {"", "meta"};
     calculations = {""};
     normalizations = {"normalized"};
-    chainTSfullname = "meta/PosCountTimer";
-    timestampMeta = NULL;
+    chainTSname = "meta/PosCountTimer";
+    deferred = false;
 }
 
 void IH5File::init()
 {
-    Group root;
+    lock_guard<mutex> lock(inventoryMutex);
+
+    // a file being followed changes, its inventory is not persisted
+    bool persist = !options.indexDir.empty() && !options.followFile;
+    if (persist && loadInventory()) return;
+
+    {
+        H5Lock h5lock(h5Mutex());
+        Group root;
+        openGroup(root, "/");
+        rootAttributes = getH5Attributes(root);
+        chainList = getNumberGroups(root);
+        closeGroup(root);
+    }
+    if (haveChain(1)) selectedChain = 1;
+
+    // datasets are listed by findInventory() when they are needed
+    deferred = options.deferInventory;
+    if (deferred) return;
+    findInventory(selectedChain);
+    findInventory(0);
+    if (persist) saveInventory();
+}
 
-    openGroup(root, "/");
-    rootAttributes = getH5Attributes(root);
-    chainList = getNumberGroups(root);
+// list the monitor datasets in /device (by name only if namesOnly)
+shared_ptr<ChainInventory> IH5File::readMonitors(bool namesOnly){
 
-    setChain(1);
+    H5Lock lock(h5Mutex());
+    shared_ptr<ChainInventory> inventory = make_shared<ChainInventory>(0);
+    Group root;
+    openGroup(root, "/");
     if (haveGroupWithName(root, "device")){
         Group devices;
         openGroup(devices, "/device");
         try {
-            parseDatasets(devices, "/device", monitormeta, "", Monitor);
+            parseDatasets(devices, "/device", inventory->chainmeta, "", Monitor, *inventory, namesOnly);
         }
         catch (Exception error){
             STHROW("Error parsing file " << filename << "; H5 Error: " << error.getDetailMsg() );
@@ -79,6 +138,98 @@ void IH5File::init()
         closeGroup(devices);
     }
     closeGroup(root);
+    inventory->chainIndex.build(inventory->chainmeta);
+    inventory->extensionIndex.build(inventory->extensionmeta);
+    return inventory;
+}
+
+// list the datasets of a chain (by name only if namesOnly)
+shared_ptr<ChainInventory> IH5File::readChain(int chain, bool namesOnly){
+
+    H5Lock lock(h5Mutex());
+    shared_ptr<ChainInventory> inventory = make_shared<ChainInventory>(chain);
+    Group group;
+    string path = "/c"+to_string(chain);
+    openGroup(group, path);
+    inventory->chainAttributes = getH5Attributes(group);
+    inventory->timestampName = path + "/" + chainTSname;
+    parseChain(group, path, *inventory, namesOnly);
+    closeGroup(group);
+    inventory->chainIndex.build(inventory->chainmeta);
+    inventory->extensionIndex.build(inventory->extensionmeta);
+    return inventory;
+}
+
+// read the attributes of a chain only
+map<string, string> IH5File::readChainAttributes(int chain){
+
+    H5Lock lock(h5Mutex());
+    Group group;
+    openGroup(group, "/c"+to_string(chain));
+    map<string, string> attributes = getH5Attributes(group);
+    closeGroup(group);
+    return attributes;
+}
+
+// take the inventory from the inventory file in options.indexDir, false if there is no valid one
+bool IH5File::loadInventory(){
+
+    InventoryFile inventory(options.indexDir, filename, h5version);
+    if (!inventory.read()) return false;
+
+    rootAttributes.swap(inventory.rootAttributes);
+    chainList = inventory.chainList;
+    for (auto& cpair : inventory.chains){
+        shared_ptr<ChainInventory> cached = make_shared<ChainInventory>(cpair.first);
+        cached->timestampName = "/c" + to_string(cpair.first) + "/" + chainTSname;
+        cached->chainAttributes.swap(cpair.second.chainAttributes);
+        cached->chainmeta.swap(cpair.second.chainmeta);
+        cached->extensionmeta.swap(cpair.second.extensionmeta);
+        cached->timestampMeta = cpair.second.timestampMeta;
+        cpair.second.timestampMeta = NULL;
+        cached->chainIndex.build(cached->chainmeta);
+        cached->extensionIndex.build(cached->extensionmeta);
+        chainCache[cpair.first] = cached;
+    }
+    shared_ptr<ChainInventory> monitors = make_shared<ChainInventory>(0);
+    monitors->chainmeta.swap(inventory.monitormeta);
+    monitors->chainIndex.build(monitors->chainmeta);
+    monitors->extensionIndex.build(monitors->extensionmeta);
+    chainCache[0] = monitors;
+    if (haveChain(1)) selectedChain = 1;
+    return true;
+}
+
+// write the inventory of all chains with resolved metadata to options.indexDir
+void IH5File::saveInventory(){
+
+    InventoryFile inventory(options.indexDir, filename, h5version);
+    try {
+        findInventory(0);
+        for (int chain : chainList) findInventory(chain);
+        for (auto& cpair : chainCache){
+            const ChainInventory& cached = *cpair.second;
+            for (IMetaData* mdata : cached.chainmeta) resolveMetaData(mdata);
+            for (IMetaData* mdata : cached.extensionmeta) resolveMetaData(mdata);
+            resolveMetaData(cached.timestampMeta);
+            if (cpair.first == 0){
+                inventory.monitormeta = cached.chainmeta;
+                continue;
+            }
+            InventoryFile::Chain& chain = inventory.chains[cpair.first];
+            chain.chainAttributes = cached.chainAttributes;
+            chain.chainmeta = cached.chainmeta;
+            chain.extensionmeta = cached.extensionmeta;
+            chain.timestampMeta = cached.timestampMeta;
+        }
+    }
+    catch (...){
+        // the inventory file is optional, a chain which can't be read is reported when used
+        return;
+    }
+    inventory.rootAttributes = rootAttributes;
+    inventory.chainList = chainList;
+    inventory.write();
 }
 
 IH5File::~IH5File()
@@ -88,14 +239,7 @@ IH5File::~IH5File()
     isOpen = false;
     chainList.clear();
     rootAttributes.clear();
-    chainAttributes.clear();
-    for (IMetaData* mdata: chainmeta) delete mdata;
-    chainmeta.clear();
-    for (IMetaData* mdata: extensionmeta) delete mdata;
-    extensionmeta.clear();
-    for (IMetaData* mdata: monitormeta) delete mdata;
-    monitormeta.clear();
-    if (timestampMeta != NULL) delete timestampMeta;
+    chainCache.clear();
 /*  do not throw exceptions in destructor
     try {
         h5file.close();
@@ -106,6 +250,13 @@ IH5File::~IH5File()
 */
 }
 
+ChainInventory::~ChainInventory()
+{
+    for (IMetaData* mdata : chainmeta) delete mdata;
+    for (IMetaData* mdata : extensionmeta) delete mdata;
+    if (timestampMeta != NULL) delete timestampMeta;
+}
+
 bool IH5File::isChainSection(string name){
     if (sections.find(name) != sections.end())
         return true;
@@ -138,8 +289,8 @@ bool IH5File::isNormalization(string name){
 //    }
 //}
 
-string IH5File::getSectionString(Section sect){
-    string chainname = "/c" + to_string(selectedChain);
+string IH5File::getSectionString(Section sect, int chain){
+    string chainname = "/c" + to_string(chain);
     switch (sect) {
     case Standard:
         return chainname +"";
@@ -159,36 +310,89 @@ string IH5File::getSectionString(Section sect){
     return "unknown";
 }
 
+vector<int> IH5File::getChains(){
+    lock_guard<mutex> lock(inventoryMutex);
+    return chainList;
+}
+
+// the inventory of the chain is read when it is selected (unless deferred), unknown chains are ignored
 void IH5File::setChain(int chain){
+    {
+        lock_guard<mutex> lock(inventoryMutex);
+        if (!haveChain(chain)) return;
+        if (!deferred) findInventory(chain);
+    }
+    selectedChain = chain;
+}
 
-    for (vector<int>::iterator cit=chainList.begin(); cit != chainList.end(); ++cit){
-        if (*cit == chain){
-            if (selectedChain != chain){
-                selectedChain = chain;
-                chainInventory();
-            }
-            return;
-        }
+// inventory of chain (0: the monitors), read when it is first needed
+InventoryPtr IH5File::getInventory(int chain){
+    lock_guard<mutex> lock(inventoryMutex);
+    return findInventory(chain);
+}
+
+bool IH5File::hasInventory(int chain){
+    lock_guard<mutex> lock(inventoryMutex);
+    return chainCache.count(chain) > 0;
+}
+
+bool IH5File::haveChain(int chain){
+    return find(chainList.begin(), chainList.end(), chain) != chainList.end();
+}
+
+// cached inventory of chain or the inventory read now. The first inventory read of a
+// deferred file also lists the monitors and saves the inventory (if persisted).
+InventoryPtr IH5File::findInventory(int chain){
+    map<int, InventoryPtr>::iterator it = chainCache.find(chain);
+    if (it != chainCache.end()) return it->second;
+    if ((chain != 0) && !haveChain(chain)) STHROW("Unable to select chain " << chain);
+
+    InventoryPtr inventory = (chain == 0) ? readMonitors(options.lazyInventory) : readChain(chain, options.lazyInventory);
+    chainCache[chain] = inventory;
+    if (deferred){
+        deferred = false;
+        findInventory(0);
+        if (!options.indexDir.empty() && !options.followFile) saveInventory();
+    }
+    return inventory;
+}
+
+IChainMetaData* IH5File::getChainMetaData(int chain){
+    lock_guard<mutex> lock(inventoryMutex);
+    if (chain == 0) return new IChainMetaData(map<string, string>());
+    // only the attributes are read as long as the datasets aren't listed
+    if (deferred){
+        if (!haveChain(chain)) STHROW("Unable to select chain " << chain);
+        return new IChainMetaData(readChainAttributes(chain));
     }
+    return new IChainMetaData(findInventory(chain)->chainAttributes);
 }
 
-void IH5File::chainInventory(){
+IFileMetaData* IH5File::getFileMetaData(){
+    lock_guard<mutex> lock(inventoryMutex);
+    return new IFileMetaData(rootAttributes);
+}
 
-    bool doneLog = false;
-    Group chain;
-    string path = "/c"+to_string(selectedChain);
-    openGroup(chain, path);
-    chainAttributes = getH5Attributes(chain);
+// chain of the metadata (path /c<chain>/...), 0 for data outside of chains (monitors)
+int IH5File::chainOf(MetaData* metadata){
+    string path = ((IMetaData*)metadata)->getPath();
+    if ((path.size() < 3) || (path.compare(0, 2, "/c") != 0) || !isdigit(path[2])) return 0;
+    return strtol(path.c_str() + 2, NULL, 10);
+}
 
-    for (IMetaData* mdata : chainmeta) delete mdata;
-    chainmeta.empty();
-    for (IMetaData* mdata : extensionmeta) delete mdata;
-    extensionmeta.empty();
+// chain of the first metadata of mdvec inside a chain, the selected chain if there is none
+int IH5File::chainOf(vector<MetaData*>& mdvec){
+    for (MetaData* mdata : mdvec){
+        int chain = chainOf(mdata);
+        if (chain != 0) return chain;
+    }
+    return selectedChain;
+}
 
-    chainTSfullname = path + "/" + chainTSfullname;
-    if (timestampMeta != NULL) delete timestampMeta;
-    timestampMeta = NULL;
+// collect the datasets of all sections of a chain
+void IH5File::parseChain(Group& chain, string path, ChainInventory& inventory, bool namesOnly){
 
+    bool doneLog = false;
     vector<string> secgroups = getGroups(chain);
     // we may have no sections at all
     secgroups.push_back("");
@@ -204,9 +408,9 @@ void IH5File::chainInventory(){
         Group secgrp;
         openGroup(secgrp, secpath);
 //        cout << "chainInventory section: " << secpath << endl;
-        if (getSectionString(Snapshot) == secpath) current_section = Snapshot;
-        parseDatasets(secgrp, secpath, chainmeta, "", current_section);
-        parseGroupDatasets(secgrp, secpath, chainmeta, "", current_section);
+        if (getSectionString(Snapshot, inventory.chain) == secpath) current_section = Snapshot;
+        parseDatasets(secgrp, secpath, inventory.chainmeta, "", current_section, inventory, namesOnly);
+        parseGroupDatasets(secgrp, secpath, inventory.chainmeta, "", current_section, namesOnly);
         vector<string> dsgroups = getGroups(secgrp);
         for (vector<string>::iterator it=dsgroups.begin(); it != dsgroups.end(); ++it){
             string grpath = *it;
@@ -217,15 +421,15 @@ void IH5File::chainInventory(){
             if (isNormalization(grpath)){
 //                cout << "chainInventory normalized group: " << calcpath << " / " << grpath << endl;
                 openGroup(calcgr, calcpath);
-                parseDatasets(calcgr, secpath, chainmeta, grpath, current_section);
-                parseGroupDatasets(calcgr, calcpath, chainmeta, grpath, current_section);
+                parseDatasets(calcgr, secpath, inventory.chainmeta, grpath, current_section, inventory, namesOnly);
+                parseGroupDatasets(calcgr, calcpath, inventory.chainmeta, grpath, current_section, namesOnly);
                 closeGroup(calcgr);
             }
             else if (isCalc(grpath)){
 //                cout << "chainInventory calc group: " << calcpath << endl;
                 openGroup(calcgr, calcpath);
-                parseDatasets(calcgr, secpath, extensionmeta, grpath, current_section);
-                parseGroupDatasets(calcgr, calcpath, extensionmeta, grpath, current_section);
+                parseDatasets(calcgr, secpath, inventory.extensionmeta, grpath, current_section, inventory, namesOnly);
+                parseGroupDatasets(calcgr, calcpath, inventory.extensionmeta, grpath, current_section, namesOnly);
                 closeGroup(calcgr);
             }
             else {
@@ -238,88 +442,283 @@ void IH5File::chainInventory(){
         }
         closeGroup(secgrp);
     }
-    closeGroup(chain);
 }
 
-vector<MetaData *> IH5File::getMetaData(Section section, string id, string name){
+// reopen the file (drops metadata cached by the H5 library) and pick up everything written since.
+// The inventories of the selected chain and the monitors are replaced by new ones, reads still
+// running keep the previous ones.
+void IH5File::refresh(){
+
+    lock_guard<mutex> inventoryLock(inventoryMutex);
+    H5Lock lock(h5Mutex());
+    unsigned int intent = H5F_ACC_RDONLY;
+    H5Fget_intent(h5file.getId(), &intent);
+    try {
+        // same driver and caches as before
+        FileAccPropList fapl = h5file.getAccessPlist();
+        h5file.close();
+        h5file.openFile(filename, intent, fapl);
+    }
+    catch (Exception error){
+        isOpen = false;
+        STHROW("Error reopening file " << filename << "; H5 Error: " << error.getDetailMsg() );
+    }
+
+    try {
+        Group root;
+        openGroup(root, "/");
+        rootAttributes = getH5Attributes(root);
+        chainList = getNumberGroups(root);
+        closeGroup(root);
+        if (deferred) return;
+
+        // inventories of other chains are read again when they are needed
+        map<int, InventoryPtr> previous;
+        previous.swap(chainCache);
+        for (int chain : {0, (int)selectedChain}){
+            map<int, InventoryPtr>::iterator it = previous.find(chain);
+            if ((it != previous.end()) && (chainCache.count(chain) == 0)) chainCache[chain] = refreshInventory(*it->second);
+        }
+        refreshCache();
+    }
+    catch (Exception error){
+        STHROW("Error refreshing file " << filename << "; H5 Error: " << error.getDetailMsg() );
+    }
+}
+
+// inventory of a chain (or the monitors) read again, the metadata of datasets already
+// resolved in previous is taken over
+InventoryPtr IH5File::refreshInventory(const ChainInventory& previous){
+
+    // datasets are listed by name only, new ones are resolved after merging (unless lazy)
+    bool lazy = options.lazyInventory;
+    shared_ptr<ChainInventory> found = (previous.chain == 0) ? readMonitors(true) : readChain(previous.chain, true);
+    ChainInventory& inventory = *found;
+    mergeInventory(previous.chainmeta, inventory.chainmeta, lazy);
+    mergeInventory(previous.extensionmeta, inventory.extensionmeta, lazy);
+    vector<IMetaData*> tsfound;
+    if (inventory.timestampMeta != NULL) tsfound.push_back(inventory.timestampMeta);
+    vector<IMetaData*> tsknown;
+    if (previous.timestampMeta != NULL) tsknown.push_back(previous.timestampMeta);
+    mergeInventory(tsknown, tsfound, lazy);
+    inventory.timestampMeta = tsfound.empty() ? NULL : tsfound[0];
+    inventory.chainIndex.build(inventory.chainmeta);
+    inventory.extensionIndex.build(inventory.extensionmeta);
+    return found;
+}
+
+// in found (in order of found), replace the metadata of datasets already known by a copy
+// of the known metadata with the current size. known may still be used by other reads.
+void IH5File::mergeInventory(const vector<IMetaData*>& known, vector<IMetaData*>& found, bool lazy){
+
+    map<string, IMetaData*> byName;
+    for (IMetaData* mdata : known) byName[mdata->getFQH5Name()] = mdata;
+    for (IMetaData*& mdata : found){
+        map<string, IMetaData*>::iterator it = byName.find(mdata->getFQH5Name());
+        if ((it != byName.end()) && it->second->resolved){
+            delete mdata;
+            mdata = new IMetaData(*it->second);
+            byName.erase(it);
+            updateDimensions(mdata);
+        }
+        else if (!lazy)
+            resolveMetaData(mdata);
+    }
+}
+
+// read the current size of a dataset or array group (metadata already resolved)
+void IH5File::updateDimensions(IMetaData* mdata){
+
+    if (!mdata->resolved) return;
+
+    H5Lock lock(h5Mutex());
+    string fqname = mdata->getFQH5Name();
+    try {
+        if (mdata->dstype == EVEDSTArray){
+            Group dsgroup = h5file.openGroup(fqname);
+            setArrayDataType(dsgroup, mdata);
+            dsgroup.close();
+        }
+        else {
+            DataSet ds = h5file.openDataSet(fqname);
+            countOpened();
+            mdata->setDataType(ds);
+            ds.close();
+        }
+    }
+    catch (Exception error){
+        STHROW("Error reading metadata of " << fqname << "; H5 Error: " << error.getDetailMsg() );
+    }
+}
+
+// append the rows written since a dataset was cached, drop entries which can't be extended.
+// Only the inventories refreshed are in chainCache.
+void IH5File::refreshCache(){
+
+    if (dataCache.getMaxBytes() == 0) return;
+
+    H5Lock lock(h5Mutex());
+    vector<string> names;
+    {
+        lock_guard<mutex> cacheLock(cacheMutex);
+        names = dataCache.getNames();
+    }
+    for (const string& fqname : names){
+        IMetaData* mdata = NULL;
+        for (auto& cpair : chainCache){
+            const ChainInventory& inventory = *cpair.second;
+            if ((inventory.timestampMeta != NULL) && (inventory.timestampMeta->getFQH5Name() == fqname))
+                mdata = inventory.timestampMeta;
+            else if ((mdata = inventory.chainIndex.findByFQName(fqname)) == NULL)
+                mdata = inventory.extensionIndex.findByFQName(fqname);
+            if (mdata != NULL) break;
+        }
+        if (mdata != NULL) resolveMetaData(mdata);
+        if ((mdata == NULL) || ((mdata->dstype != EVEDSTPCOneColumn) && (mdata->dstype != EVEDSTPCTwoColumn))){
+            lock_guard<mutex> cacheLock(cacheMutex);
+            dataCache.erase(fqname);
+            continue;
+        }
+
+        IData cached(*mdata);
+        {
+            lock_guard<mutex> cacheLock(cacheMutex);
+            if (!dataCache.lookup(fqname, &cached)) continue;
+        }
+        hsize_t oldRows = cached.posCounts.size();
+        if (mdata->h5dimensions[0] == oldRows) continue;
+        {
+            lock_guard<mutex> cacheLock(cacheMutex);
+            dataCache.erase(fqname);
+        }
+        if (mdata->h5dimensions[0] < oldRows) continue;
+
+        size_t element_size;
+        hsize_t rows;
+        DataSet h5dset;
+        H5::DataType h5dtype;
+        string objname = fqname;
+        bool twoColumns = (mdata->dstype == EVEDSTPCTwoColumn);
+        if (twoColumns)
+            openPCTwoCol(&cached, h5dset, h5dtype, element_size, rows);
+        else
+            openPCOneCol(&cached, h5dset, h5dtype, element_size, rows);
+        vector<hsize_t> newRows;
+        for (hsize_t row = oldRows; row < rows; ++row) newRows.push_back(row);
+        RawRecords raw;
+        readRows(h5dset, h5dtype, element_size, newRows, raw, objname);
+        IData added(*mdata);
+        if (twoColumns)
+            decodePCTwoCol(&added, raw);
+        else
+            decodePCOneCol(&added, raw);
+
+        // cached columns are shared with data already returned, extend copies
+        cached.posCounts.insert(cached.posCounts.end(), added.posCounts.begin(), added.posCounts.end());
+        for (auto& column : cached.intsptrmap){
+            shared_ptr<vector<int>> extended = make_shared<vector<int>>(*column.second);
+            vector<int>& tail = *added.intsptrmap.at(column.first);
+            extended->insert(extended->end(), tail.begin(), tail.end());
+            column.second = extended;
+        }
+        for (auto& column : cached.dblsptrmap){
+            shared_ptr<vector<double>> extended = make_shared<vector<double>>(*column.second);
+            vector<double>& tail = *added.dblsptrmap.at(column.first);
+            extended->insert(extended->end(), tail.begin(), tail.end());
+            column.second = extended;
+        }
+        for (auto& column : cached.strsptrmap){
+            shared_ptr<StringColumn> extended = make_shared<StringColumn>(*column.second);
+            extended->append(*added.strsptrmap.at(column.first));
+            column.second = extended;
+        }
+        lock_guard<mutex> cacheLock(cacheMutex);
+        dataCache.insert(fqname, &cached);
+    }
+}
+
+vector<MetaData *> IH5File::getMetaData(const ChainInventory& inventory, Section section, string id, string name){
     vector<MetaData *> result;
-    string path = getSectionString(section);
+    string path = getSectionString(section, inventory.chain);
     if (path.size() == 0) {
         return result;
     }
 
     if (section == Timestamp){
-        if (timestampMeta != NULL) result.push_back(new IMetaData(*timestampMeta));
+        if (inventory.timestampMeta != NULL) {
+            resolveMetaData(inventory.timestampMeta);
+            result.push_back(new (ResultArena::active()) IMetaData(*inventory.timestampMeta));
+        }
     }
     else if (section == Monitor)
-        result = getMetaData(&monitormeta, path, id, name);
+        result = getMetaData(getInventory(0)->chainIndex, path, id, name);
     else
-        result = getMetaData(&chainmeta, path, id, name);
+        result = getMetaData(inventory.chainIndex, path, id, name);
 
     return result;
 }
 
-string IH5File::getNameById(Section section, string id){
+string IH5File::getNameById(const ChainInventory& inventory, Section section, string id){
 
-    string path = getSectionString(section);
+    string path = getSectionString(section, inventory.chain);
     if (path.empty() || id.empty())
         return string();
 
     if (section == Timestamp){
-        if (timestampMeta != NULL) return timestampMeta->getName();
+        if (inventory.timestampMeta != NULL){
+            resolveMetaData(inventory.timestampMeta);
+            return inventory.timestampMeta->getName();
+        }
     }
     else if (section == Monitor)
-        return getNameById(&monitormeta, path, id);
+        return getNameById(getInventory(0)->chainIndex, path, id);
     else
-        return getNameById(&chainmeta, path, id);
+        return getNameById(inventory.chainIndex, path, id);
 
     return string();
 }
 
-string IH5File::getNameById(vector<IMetaData *> *devlist, string path, string id){
+string IH5File::getNameById(const MetaDataIndex& index, string path, string id){
 
-    for (vector<IMetaData *>::iterator it=devlist->begin(); it != devlist->end(); ++it){
-        IMetaData* mdat = *it;
-        if (mdat->getPath().find(path)==0){
-            if ((mdat->getId() == id) && (!mdat->getName().empty()))
-                return mdat->getName();
-        }
+    resolveSection(index, path);
+    for (IMetaData* mdat : index.findById(path, id)){
+        if (!mdat->getName().empty())
+            return mdat->getName();
     }
     return string();
 }
 
-vector<MetaData *> IH5File::getMetaData(vector<IMetaData *> *devlist, string path, string id, string name){
+vector<MetaData *> IH5File::getMetaData(const MetaDataIndex& index, string path, string id, string name){
     vector<MetaData *> result;
     if (path.size() == 0) {
         return result;
     }
 
-    for (vector<IMetaData *>::iterator it=devlist->begin(); it != devlist->end(); ++it){
-        IMetaData* mdat = *it;
-        if (mdat->getPath().find(path)==0){
-            if (id.length() > 0){
-                if (mdat->getId() == id) result.push_back(new IMetaData(*mdat));
-            }
-            else if (name.length() > 0){
-                if (mdat->getName() == name) result.push_back(new IMetaData(*mdat));
-            }
-            else
-                result.push_back(new IMetaData(*mdat));
+    if ((id.length() > 0) || (name.length() > 0)){
+        resolveSection(index, path);
+        const vector<IMetaData*>& found = (id.length() > 0) ? index.findById(path, id) : index.findByName(path, name);
+        for (IMetaData* mdat : found) result.push_back(new (ResultArena::active()) IMetaData(*mdat));
+    }
+    else {
+        for (IMetaData* mdat : index.getSection(path)){
+            resolveMetaData(mdat);
+            result.push_back(new (ResultArena::active()) IMetaData(*mdat));
         }
     }
     return result;
 }
 
-MetaData* IH5File::findMetaData(vector<IMetaData*>& mdlist, string fullh5name){
-    for (vector<IMetaData *>::iterator it=mdlist.begin(); it != mdlist.end(); ++it){
-        IMetaData* mdat = *it;
-        string name = mdat->getFQH5Name();
-        // cout << "compare: " << name << " with " << fullh5name << endl;
-        if (name.compare(fullh5name) == 0){
-            return mdat;
-        }
-    }
-    return NULL;
+MetaData* IH5File::findMetaData(const MetaDataIndex& index, string fullh5name){
+    IMetaData* mdat = index.findByFQName(fullh5name);
+    if (mdat != NULL) resolveMetaData(mdat);
+    return mdat;
+}
+
+// Id and Name keys of a section need resolved metadata (lazy inventory)
+void IH5File::resolveSection(const MetaDataIndex& index, const string& prefix){
+    if (index.hasKeys(prefix)) return;
+    for (IMetaData* mdat : index.getSection(prefix)) resolveMetaData(mdat);
+    index.buildKeys(prefix);
 }
 
 void IH5File::openGroup(Group& h5group, string path){
@@ -340,20 +739,43 @@ void IH5File::closeGroup(Group& h5group){
     }
 }
 
+// H5Literate callback, collects name and type of all objects in a group
+static herr_t collectObjects(hid_t group, const char *name, const H5L_info_t *, void *objects){
+    H5G_obj_t objtype = H5G_UNKNOWN;
+    hid_t obj = H5Oopen(group, name, H5P_DEFAULT);
+    if (obj >= 0){
+        H5I_type_t idtype = H5Iget_type(obj);
+        if (idtype == H5I_GROUP) objtype = H5G_GROUP;
+        else if (idtype == H5I_DATASET) objtype = H5G_DATASET;
+        else if (idtype == H5I_DATATYPE) objtype = H5G_TYPE;
+        H5Oclose(obj);
+    }
+    ((vector<pair<string, H5G_obj_t>>*)objects)->push_back(pair<string, H5G_obj_t>(string(name), objtype));
+    return 0;
+}
+
+// return names and types of all objects in group (same order as getObjnameByIdx),
+// lookups by index are expensive for groups with many objects
+vector<pair<string, H5G_obj_t>> IH5File::getObjects(Group& group){
+    vector<pair<string, H5G_obj_t>> objects;
+    if (H5Literate(group.getId(), H5_INDEX_NAME, H5_ITER_INC, NULL, collectObjects, &objects) < 0)
+        STHROW("Unable to iterate H5 Group");
+    return objects;
+}
+
 // return the names of all groups in group
 vector<string> IH5File::getGroups(Group& group){
     vector<string> groupList;
-    for (hsize_t index = 0; index < group.getNumObjs(); ++index){
-        string objname = group.getObjnameByIdx(index);
-        if (group.getObjTypeByIdx(index) == H5G_GROUP){
-            groupList.push_back(objname);
+    for (auto const &object : getObjects(group)){
+        if (object.second == H5G_GROUP){
+            groupList.push_back(object.first);
         }
     }
     return groupList;
 }
 
 // collect all groups with array data i.e. with attribute "XML-ID"
-void IH5File::parseGroupDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section)
+void IH5File::parseGroupDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section, bool namesOnly)
 {
     
     vector<string> dsgroups = getGroups(group);
@@ -365,52 +787,104 @@ void IH5File::parseGroupDatasets(Group& group, string prefix, vector<IMetaData*>
         openGroup(dsgroup, fullname);
 
         // ignore all groups without an attribute "XML-ID" (could be unsupported calc groups)
-        map<string, string> attribs = getH5Attributes(dsgroup);
-        if (attribs.count("XML-ID") == 0) continue;
-
-        IMetaData* dinfo = new IMetaData(prefix + "/", calctype, *it, section, attribs);
-        for (hsize_t index = 0; index < dsgroup.getNumObjs(); ++index){
-            if (dsgroup.getObjTypeByIdx(index) != H5G_DATASET) continue;
-//            string subname = dsgroup.getObjnameByIdx(index);
-//            int posCnt = strtol(subname.c_str(),NULL,10);
-//            dinfo->posCounts.push_back(posCnt);
-            // open the first dataset to retrieve the datatype
-            if (index  == 0) {
-                string subname = dsgroup.getObjnameByIdx(index);
-                DataSet ds = dsgroup.openDataSet(subname);
-                dinfo->setDataType(ds);
-                ds.close();
+        IMetaData* dinfo;
+        if (namesOnly){
+            if (!dsgroup.attrExists("XML-ID")){
+                closeGroup(dsgroup);
+                continue;
             }
-            ++dinfo->dim0;
+            // attributes and datatype are read by resolveMetaData
+            dinfo = new IMetaData(prefix + "/", calctype, *it, section, map<string, string>());
+            dinfo->resolved = false;
+        }
+        else {
+            map<string, string> attribs = getH5Attributes(dsgroup);
+            if (attribs.count("XML-ID") == 0){
+                closeGroup(dsgroup);
+                continue;
+            }
+            dinfo = new IMetaData(prefix + "/", calctype, *it, section, attribs);
+            setArrayDataType(dsgroup, dinfo);
         }
-//        sort(begin(dinfo->posCounts), end(dinfo->posCounts));
         dinfo->dstype = EVEDSTArray;
         imeta.push_back(dinfo);
         closeGroup(dsgroup);
     }
 }
 
+// count the positions of an array group and retrieve the datatype from the first dataset
+void IH5File::setArrayDataType(Group& dsgroup, IMetaData* dinfo){
+
+    hsize_t count = dsgroup.getNumObjs();
+    if ((count > 0) && (dsgroup.getObjTypeByIdx(0) == H5G_DATASET)){
+        string subname = dsgroup.getObjnameByIdx(0);
+        DataSet ds = dsgroup.openDataSet(subname);
+        countOpened();
+        dinfo->setDataType(ds);
+        ds.close();
+    }
+    dinfo->dim0 = count;
+}
+
+// read attributes and datatype of metadata created by a lazy inventory
+void IH5File::resolveMetaData(IMetaData* mdata){
+
+    if ((mdata == NULL) || mdata->resolved) return;
 
+    // another thread may have resolved it while waiting for the lock
+    H5Lock lock(h5Mutex());
+    if (mdata->resolved) return;
+    string fqname = mdata->getFQH5Name();
+    try {
+        if (mdata->dstype == EVEDSTArray){
+            Group dsgroup = h5file.openGroup(fqname);
+            mdata->setAttributes(getH5Attributes(dsgroup));
+            setArrayDataType(dsgroup, mdata);
+            mdata->dstype = EVEDSTArray;
+            dsgroup.close();
+        }
+        else {
+            DataSet ds = h5file.openDataSet(fqname);
+            countOpened();
+            mdata->setAttributes(getH5Attributes(ds));
+            mdata->setDataType(ds);
+            ds.close();
+        }
+    }
+    catch (Exception error){
+        STHROW("Error reading metadata of " << fqname << "; H5 Error: " << error.getDetailMsg() );
+    }
+    mdata->resolved = true;
+}
 
-void IH5File::parseDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section){
+void IH5File::parseDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section, ChainInventory& inventory, bool namesOnly){
 
-    for (hsize_t index = 0; index < group.getNumObjs(); ++index){
-        string objname = group.getObjnameByIdx(index);
-        if (group.getObjTypeByIdx(index) == H5G_DATASET){
-            DataSet ds = group.openDataSet(objname);
+    for (auto const &object : getObjects(group)){
+        string objname = object.first;
+        if (object.second == H5G_DATASET){
             Section useSection=section;
 
-            if (prefix+"/"+objname == chainTSfullname) useSection=Timestamp;
+            if (prefix+"/"+objname == inventory.timestampName) useSection=Timestamp;
 
-            IMetaData* dinfo = new IMetaData(prefix + "/", calctype, objname, useSection, getH5Attributes(ds));
-            dinfo->setDataType(ds);
+            IMetaData* dinfo;
+            if (namesOnly){
+                // attributes and datatype are read by resolveMetaData
+                dinfo = new IMetaData(prefix + "/", calctype, objname, useSection, map<string, string>());
+                dinfo->resolved = false;
+            }
+            else {
+                DataSet ds = group.openDataSet(objname);
+                countOpened();
+                dinfo = new IMetaData(prefix + "/", calctype, objname, useSection, getH5Attributes(ds));
+                dinfo->setDataType(ds);
+                ds.close();
+            }
             if (useSection==Timestamp){
-                if (timestampMeta != NULL) delete timestampMeta;
-                timestampMeta = dinfo;
+                if (inventory.timestampMeta != NULL) delete inventory.timestampMeta;
+                inventory.timestampMeta = dinfo;
             }
             else
                 imeta.push_back(dinfo);
-            ds.close();
 
             // cout << "parseDatasets DS: " << dinfo->getId() << " full path: " << dinfo->getFQH5Name() << endl;
 
@@ -421,9 +895,9 @@ void IH5File::parseDatasets(Group& group, string prefix, vector<IMetaData*>& ime
 // return the names of all groups in group, where groupnames have a leading "c" and can be converted to numbers
 vector<int> IH5File::getNumberGroups(Group& group){
     vector<int> groupList;
-    for (hsize_t index = 0; index < group.getNumObjs(); ++index){
-        string objname = group.getObjnameByIdx(index);
-        if ((group.getObjTypeByIdx(index) == H5G_GROUP) && (objname.size() > 1) && (objname[0] == 'c')){
+    for (auto const &object : getObjects(group)){
+        string objname = object.first;
+        if ((object.second == H5G_GROUP) && (objname.size() > 1) && (objname[0] == 'c')){
             try {
 
                 groupList.push_back(stoi(objname.substr(1), nullptr, 10));
@@ -465,105 +939,366 @@ map<string, string> IH5File::getH5Attributes(H5Object& object){
     return attribMap;
 }
 
-Data *IH5File::getData(MetaData *dInfo){
+Data *IH5File::getData(const ChainInventory& inventory, MetaData *dInfo){
 
     // ... siehe unten: getData(IMetaData* dInfo)
-    IData* data = new IData((IMetaData&)*dInfo);
-    if (((IMetaData*)dInfo)->dstype == EVEDSTArray){
-        readDataArray(data);
-    }
-    else if (((IMetaData*)dInfo)->dstype == EVEDSTPCOneColumn){
-        readDataPCOneCol(data);
-    }
-    else if (((IMetaData*)dInfo)->dstype == EVEDSTPCTwoColumn){
-        readDataPCTwoCol(data);
+    checkCancelled();
+    resolveMetaData((IMetaData*)dInfo);
+    IData* data = new (ResultArena::active()) IData((IMetaData&)*dInfo);
+    try {
+        if (((IMetaData*)dInfo)->dstype == EVEDSTArray){
+            readDataArray(data);
+        }
+        else if (((IMetaData*)dInfo)->dstype == EVEDSTPCOneColumn){
+            readDataPCOneCol(data);
+        }
+        else if (((IMetaData*)dInfo)->dstype == EVEDSTPCTwoColumn){
+            readDataPCTwoCol(data);
+        }
+        else {
+            STHROW("Unable to read data: unknown DataSet type");
+        }
+
+        // check if we have averagedata
+        addExtensionData(inventory, data);
     }
-    else {
-        STHROW("Unable to read data: unknown DataSet type");
+    catch (...){
+        delete data;
+        throw;
     }
 
-    // check if we have averagedata
-    addExtensionData(data);
-
+    if (readControl != NULL) ++readControl->datasetsDone;
     return data;
 }
 
-void IH5File::readDataArray(IData* data){
-
-    hsize_t dims_out[2];
-    size_t element_size;
-
-    Group dsgroup;
-    openGroup(dsgroup, data->getFQH5Name());
+// getData with the selected rows of dInfo
+Data* IH5File::getSelectedData(const ChainInventory& inventory, IMetaData* mdata, const ReadSelection& selection){
 
-    for (hsize_t index = 0; index < dsgroup.getNumObjs(); ++index){
-        if (dsgroup.getObjTypeByIdx(index) != H5G_DATASET) continue;
-        string subname = dsgroup.getObjnameByIdx(index);
-        string objname = data->getFQH5Name() + "/" + subname;
-        int posCnt = strtol(subname.c_str(),NULL,10);
-        data->posCounts.push_back(posCnt);
-        DataSet h5dset;
-        H5::DataType h5dtype;
-        try {
-            h5dset = dsgroup.openDataSet(subname);
-            h5dset.getSpace().getSimpleExtentDims( dims_out, NULL);
-            h5dtype = h5dset.getDataType();
-            element_size = h5dtype.getSize();
-        }
-        catch (DataSetIException error){
-            STHROW("H5 DataSet error while reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
-        }
-        catch (DataTypeIException error){
-            STHROW("H5 Datatype error while reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+    checkCancelled();
+    resolveMetaData(mdata);
+    IData* data = new (ResultArena::active()) IData(*mdata);
+    try {
+        if (mdata->dstype == EVEDSTArray){
+            readDataArray(data, &selection);
         }
-        catch (DataSpaceIException error){
-            STHROW("Error reading H5 Dataspace in Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+        else if (mdata->dstype == EVEDSTPCOneColumn){
+            readDataPCOneCol(data, &selection);
         }
-        catch (FileIException error){
-            STHROW("Unable to open H5 DataSet: " << objname << " H5 Error: " << error.getDetailMsg() );
+        else if (mdata->dstype == EVEDSTPCTwoColumn){
+            readDataPCTwoCol(data, &selection);
         }
-        catch (...){
-            STHROW("Unknown H5 Error in Dataset " << objname);
+        else {
+            STHROW("Unable to read data: unknown DataSet type");
         }
-        if ((dims_out[1] > 1) || (data->h5dimensions[0] != dims_out[0]) || (data->h5dimensions[1] != dims_out[1])){
-            STHROW("Error: Unexpected dimension in Dataset " << objname);
+
+        // extension data is needed for the rows read only
+        if (data->posCounts.size() > 0){
+            ReadSelection extSelection;
+            extSelection.posRefs = data->posCounts;
+            addExtensionData(inventory, data, &extSelection);
         }
+    }
+    catch (...){
+        delete data;
+        throw;
+    }
+    if (readControl != NULL) ++readControl->datasetsDone;
+    return data;
+}
 
-        shared_ptr<char> memBuffer(new char[element_size * dims_out[0]], default_delete<char[]>() );
-        // std::shared_ptr<char> memBuffer(new char[element_size * dims_out[0]], array_deleter<char>() );
+// selection includes all rows
+static bool selectsAll(const Selection& selection){
+    return selection.posRefs.empty() && (selection.firstPosRef == INT_MIN) && (selection.lastPosRef == INT_MAX) && (selection.stride <= 1);
+}
 
-        if (memBuffer.get() == NULL){
-            STHROW("Unable to allocate memory when reading Dataset " << objname);
+// rows of a dataset with posCounts selected by selection, in ascending order
+static vector<hsize_t> selectRows(const vector<int>& posCounts, const ReadSelection& selection){
+
+    vector<hsize_t> rows;
+    bool useList = !selection.posRefs.empty();
+    vector<int> wanted;
+    int lowest = selection.firstPosRef;
+    if (useList){
+        wanted = selection.posRefs;
+        sort(wanted.begin(), wanted.end());
+        wanted.erase(unique(wanted.begin(), wanted.end()), wanted.end());
+        lowest = wanted.front();
+    }
+    hsize_t stride = (useList || (selection.stride == 0)) ? 1 : selection.stride;
+
+    if (!useList && is_sorted(posCounts.begin(), posCounts.end())){
+        // binary search for the interval
+        hsize_t first = lower_bound(posCounts.begin(), posCounts.end(), selection.firstPosRef) - posCounts.begin();
+        hsize_t end = upper_bound(posCounts.begin(), posCounts.end(), selection.lastPosRef) - posCounts.begin();
+        if (selection.previousRow && (first > 0)) rows.push_back(first - 1);
+        for (hsize_t row = first; row < end; row += stride) rows.push_back(row);
+        return rows;
+    }
+
+    long previous = -1;
+    hsize_t matched = 0;
+    for (hsize_t row = 0; row < posCounts.size(); ++row){
+        int posCount = posCounts[row];
+        if (posCount < lowest){
+            if ((previous < 0) || (posCount >= posCounts[previous])) previous = row;
+            continue;
         }
-        try {
-            h5dset.read(memBuffer.get(), h5dtype);
+        if (useList ? binary_search(wanted.begin(), wanted.end(), posCount) : (posCount <= selection.lastPosRef)){
+            if ((matched % stride) == 0) rows.push_back(row);
+            ++matched;
         }
-        catch (DataSetIException error){
-            STHROW("Error reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+    }
+    if (selection.previousRow && (previous >= 0))
+        rows.insert(lower_bound(rows.begin(), rows.end(), (hsize_t)previous), previous);
+    return rows;
+}
+
+// thrown by the decode stage of getDataPipelined if a dataset has not been fetched
+struct NotPrefetched {};
+
+thread_local IH5File::PrefetchSet* IH5File::workerPrefetch = NULL;
+thread_local ReadControl* IH5File::readControl = NULL;
+
+// read data through the data cache (if enabled)
+void IH5File::readCached(IData* data, void (IH5File::*load)(IData*)){
+    string fqname = data->getFQH5Name();
+    if (workerPrefetch != NULL){
+        // decode stage of getDataPipelined, no H5 calls allowed
+        PrefetchSet::iterator it = workerPrefetch->find(fqname);
+        if (it == workerPrefetch->end()) throw NotPrefetched();
+        if (it->second.loaded != NULL){
+            shareColumns(it->second.loaded.get(), data);
         }
-        catch (...){
-            STHROW("Unknown error while reading DataSet: " << objname);
+        else {
+            it->second.decode(data, it->second.raw);
+            lock_guard<mutex> lock(cacheMutex);
+            if (dataCache.getMaxBytes() > 0) dataCache.insert(fqname, data);
         }
-        data->posPtrHash.insert(pair<int, shared_ptr<char>>(posCnt, memBuffer));
+        return;
     }
-    closeGroup(dsgroup);
-    sort(begin(data->posCounts), end(data->posCounts));
+    if (dataCache.getMaxBytes() == 0){
+        (this->*load)(data);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        if (dataCache.lookup(fqname, data)) return;
+    }
+    (this->*load)(data);
+    lock_guard<mutex> lock(cacheMutex);
+    dataCache.insert(fqname, data);
+}
+
+// let data use the columns read into source
+void IH5File::shareColumns(IData* source, IData* data){
+    data->posCounts = source->posCounts;
+    data->intsptrmap = source->intsptrmap;
+    data->dblsptrmap = source->dblsptrmap;
+    data->strsptrmap = source->strsptrmap;
+    data->intvalidmap = source->intvalidmap;
+    data->dblvalidmap = source->dblvalidmap;
+    data->strvalidmap = source->strvalidmap;
+    data->arrayBlock = source->arrayBlock;
+    data->arrayRowSize = source->arrayRowSize;
+    data->posRowIndex = source->posRowIndex;
+}
 
+// a selection is read from file, without the data cache
+void IH5File::readDataArray(IData* data, const ReadSelection* selection){
+    if (selection != NULL)
+        loadDataArray(data, selection);
+    else
+        readCached(data, &IH5File::loadDataArray);
+}
 
+void IH5File::readDataPCOneCol(IData* data, const ReadSelection* selection){
+    if (selection != NULL)
+        loadSelectedPC(data, *selection, false);
+    else
+        readCached(data, &IH5File::loadDataPCOneCol);
 }
 
-void IH5File::readDataPCOneCol(IData* data){
+void IH5File::readDataPCTwoCol(IData* data, const ReadSelection* selection){
+    if (selection != NULL)
+        loadSelectedPC(data, *selection, true);
+    else
+        readCached(data, &IH5File::loadDataPCTwoCol);
+}
 
-    if ((data->datatype == DTunknown)) STHROW("unsupported datatype");
+// H5Literate callback, collects the position references of an array group (dataset names are posRefs)
+static herr_t collectPositions(hid_t, const char *name, const H5L_info_t *, void *positions){
+    ((vector<pair<int, string>>*)positions)->push_back(pair<int, string>(strtol(name,NULL,10), string(name)));
+    return 0;
+}
 
-    hsize_t dims_out[2];
+// H5 id (dataset, datatype or dataspace) released when leaving the scope
+class ScopedId {
+public:
+    explicit ScopedId(hid_t id=-1) : id(id) {};
+    ~ScopedId(){if (id >= 0) H5Idec_ref(id);};
+    void reset(hid_t newid){if (id >= 0) H5Idec_ref(id); id = newid;};
+    hid_t get() const {return id;};
+    bool valid() const {return id >= 0;};
+private:
+    ScopedId(const ScopedId&);
+    ScopedId& operator=(const ScopedId&);
+    hid_t id;
+};
+
+void IH5File::loadDataArray(IData* data, const ReadSelection* selection){
+
+    H5Lock lock(h5Mutex());
+    vector<pair<int, string>> positions;
+    string fqname = data->getFQH5Name();
+
+    Group dsgroup;
+    openGroup(dsgroup, fqname);
+    hid_t groupid = dsgroup.getId();
+
+    // list all links with one pass (lookups by index are expensive for large groups)
+    // and read the datasets in ascending order
+    if (H5Literate(groupid, H5_INDEX_NAME, H5_ITER_NATIVE, NULL, collectPositions, &positions) < 0)
+        STHROW("Unable to iterate H5 Group " << fqname);
+    sort(begin(positions), end(positions));
+    if (selection != NULL){
+        vector<int> posCounts;
+        for (auto const &position : positions) posCounts.push_back(position.first);
+        vector<pair<int, string>> selected;
+        for (hsize_t row : selectRows(posCounts, *selection)) selected.push_back(positions[row]);
+        positions.swap(selected);
+    }
+
+    // datatype and memory dataspace of the first dataset are used for all datasets
+    ScopedId memtype;
+    ScopedId memspace;
+    size_t rowsize = 0;
+    unsigned int row = 0;
+    if (readControl != NULL){
+        readControl->rowsDone = 0;
+        readControl->rowsTotal = positions.size();
+    }
+    for (unsigned int index = 0; index < positions.size(); ++index){
+        if ((readControl != NULL) && readControl->cancelled) throw ReadCancelled();
+        if (readControl != NULL) readControl->rowsDone = index;
+        int posCnt = positions[index].first;
+        string objname = fqname + "/" + positions[index].second;
+        ScopedId dset(H5Oopen(groupid, positions[index].second.c_str(), H5P_DEFAULT));
+        countOpened();
+        if (!dset.valid()) STHROW("Unable to open H5 DataSet: " << objname);
+        if (H5Iget_type(dset.get()) != H5I_DATASET) continue;
+        if (!memtype.valid()){
+            hsize_t dims_out[2] = {0, 0};
+            ScopedId filetype(H5Dget_type(dset.get()));
+            ScopedId filespace(H5Dget_space(dset.get()));
+            int rank = filespace.valid() ? H5Sget_simple_extent_ndims(filespace.get()) : -1;
+            if ((rank > 0) && (rank <= 2)) H5Sget_simple_extent_dims(filespace.get(), dims_out, NULL);
+            if ((rank < 1) || (rank > 2) || (dims_out[1] > 1) || (data->h5dimensions[0] != dims_out[0]) || (data->h5dimensions[1] != dims_out[1]))
+                STHROW("Error: Unexpected dimension in Dataset " << objname);
+            if (filetype.valid()) memtype.reset(H5Tget_native_type(filetype.get(), H5T_DIR_DEFAULT));
+            if (!memtype.valid()) STHROW("H5 Datatype error while reading Dataset " << objname);
+            memspace.reset(H5Screate_simple(1, dims_out, NULL));
+            rowsize = H5Tget_size(memtype.get()) * dims_out[0];
+            data->arrayRowSize = rowsize;
+            data->arrayBlock = shared_ptr<char>(new char[rowsize * positions.size()](), default_delete<char[]>());
+            countAllocated();
+        }
+        // fails, if the dataset has a different number of elements
+        if (H5Dread(dset.get(), memtype.get(), memspace.get(), H5S_ALL, H5P_DEFAULT, data->arrayBlock.get() + row * rowsize) < 0)
+            STHROW("Error reading Dataset " << objname << " (unexpected dimension or datatype)");
+        countRead(rowsize);
+        data->posCounts.push_back(posCnt);
+        data->posRowIndex.insert(pair<int, unsigned int>(posCnt, row));
+        ++row;
+    }
+    if (readControl != NULL) readControl->rowsDone = positions.size();
+    closeGroup(dsgroup);
+}
+
+// read the posCounts of a one or two column dataset and the records of the selected rows
+void IH5File::loadSelectedPC(IData* data, const ReadSelection& selection, bool twoColumns){
+
+    RawRecords raw;
+    fetchSelectedPC(data, selection, twoColumns, raw);
+    if (twoColumns)
+        decodePCTwoCol(data, raw);
+    else
+        decodePCOneCol(data, raw);
+}
+
+// H5 part of loadSelectedPC
+void IH5File::fetchSelectedPC(IData* data, const ReadSelection& selection, bool twoColumns, RawRecords& raw){
+
+    H5Lock lock(h5Mutex());
     size_t element_size;
+    hsize_t rows;
     DataSet h5dset;
     H5::DataType h5dtype;
     string objname = data->getFQH5Name();
+    if (twoColumns)
+        openPCTwoCol(data, h5dset, h5dtype, element_size, rows);
+    else
+        openPCOneCol(data, h5dset, h5dtype, element_size, rows);
+
+    vector<int> posCounts;
+    RawRecords mapped;
+    if (mapRecords(h5dset, element_size, rows, mapped)){
+        // posCounts and the selected records are taken from the mapping
+        posCounts.resize(rows);
+        decodeMember<int, int>(mapped.buffer.get(), element_size, 0, rows, posCounts.data());
+        vector<hsize_t> selected = selectRows(posCounts, selection);
+        raw.buffer = shared_ptr<char>((char*)malloc(element_size * max(selected.size(), (size_t)1)), free);
+        if (raw.buffer == NULL)
+            STHROW("Unable to allocate memory when reading Dataset " << objname);
+        countAllocated();
+        raw.elementSize = element_size;
+        raw.count = selected.size();
+        for (size_t i = 0; i < selected.size(); ++i)
+            memcpy(raw.buffer.get() + i * element_size, mapped.buffer.get() + selected[i] * element_size, element_size);
+    }
+    else {
+        readPosCounts(h5dset, h5dtype, rows, posCounts, objname);
+        readRows(h5dset, h5dtype, element_size, selectRows(posCounts, selection), raw, objname);
+    }
+}
+
+// read the posCount column of a one or two column dataset
+void IH5File::readPosCounts(DataSet& h5dset, H5::DataType& h5dtype, hsize_t rows, vector<int>& posCounts, string& objname){
+    posCounts.resize(rows);
+    if (rows == 0) return;
+    if (h5dtype.getClass() != H5T_COMPOUND) STHROW("Unable to read posCounts: no compound datatype in Dataset " << objname);
+    CompType filetype(h5dset);
+    readMember(h5dset, filetype, 0, PredType::NATIVE_INT, posCounts.data(), objname);
+}
+
+void IH5File::loadDataPCOneCol(IData* data){
+    RawRecords raw;
+    if (fetchPCOneCol(data, raw)) decodePCOneCol(data, raw);
+}
+
+// add columns of size count for the datatype of data
+void IH5File::addColumns(IData* data, int columns, size_t count){
+    countAllocated(columns);
+    for (int col = 0; col < columns; ++col){
+        if (data->datatype == DTstring)
+            data->strsptrmap.insert(pair<int, shared_ptr<StringColumn>>(col, make_shared<StringColumn>()));
+        else if ((data->datatype == DTfloat64) || (data->datatype == DTfloat32))
+            data->dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(col, make_shared<vector<double>>(count)));
+        else
+            data->intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(col, make_shared<vector<int>>(count)));
+    }
+}
+
+// open a one column dataset and check its layout against the metadata
+void IH5File::openPCOneCol(IData* data, DataSet& h5dset, H5::DataType& h5dtype, size_t& element_size, hsize_t& rows){
+
+    if ((data->datatype == DTunknown)) STHROW("unsupported datatype");
+
+    hsize_t dims_out[2];
+    string objname = data->getFQH5Name();
 
     try {
         h5dset = h5file.openDataSet(objname);
+        countOpened();
         h5dset.getSpace().getSimpleExtentDims( dims_out, NULL);
         h5dtype = h5dset.getDataType();
         element_size = h5dtype.getSize();
@@ -609,86 +1344,217 @@ void IH5File::readDataPCOneCol(IData* data){
     default:
         break;
     }
+    rows = dims_out[0];
+}
 
-    void* memBuffer = malloc(element_size * dims_out[0]);
-    if (memBuffer == NULL)
-        STHROW("Unable to allocate memory when reading Dataset " << objname);
-    try {
-        h5dset.read(memBuffer, h5dtype);
-    }
-    catch (DataSetIException error){
-        STHROW("Error reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
-    }
-    catch (...){
-        STHROW("Unknown error while reading DataSet: " << objname);
+// H5 part of reading a one column dataset: the records are read into raw (return true)
+// or, with memberReads, straight into the columns of data (return false)
+bool IH5File::fetchPCOneCol(IData* data, RawRecords& raw){
+
+    H5Lock lock(h5Mutex());
+    size_t element_size;
+    hsize_t rows;
+    DataSet h5dset;
+    H5::DataType h5dtype;
+    string objname = data->getFQH5Name();
+    openPCOneCol(data, h5dset, h5dtype, element_size, rows);
+
+    if (mapRecords(h5dset, element_size, rows, raw)) return true;
+    if (options.memberReads && (data->datatype != DTstring) && (h5dtype.getClass() == H5T_COMPOUND)){
+        addColumns(data, 1, rows);
+        CompType filetype(h5dset);
+        size_t firstPos = data->posCounts.size();
+        data->posCounts.resize(firstPos + rows);
+        readMember(h5dset, filetype, 0, PredType::NATIVE_INT, data->posCounts.data() + firstPos, objname);
+        if ((data->datatype == DTfloat64) || (data->datatype == DTfloat32))
+            readMember(h5dset, filetype, 1, PredType::NATIVE_DOUBLE, data->dblsptrmap.at(DBLVECT1)->data(), objname);
+        else if (data->datatype == DTuint32)
+            // same bit pattern as the staged decoder, HDF5 would clip values > INT_MAX
+            readMember(h5dset, filetype, 1, PredType::NATIVE_UINT, data->intsptrmap.at(INTVECT1)->data(), objname);
+        else
+            readMember(h5dset, filetype, 1, PredType::NATIVE_INT, data->intsptrmap.at(INTVECT1)->data(), objname);
+        return false;
     }
+    readRecords(h5dset, h5dtype, element_size, rows, raw, objname);
+    return true;
+}
 
-    if (data->datatype == DTstring)
-        data->strsptrmap.insert(pair<int, shared_ptr<vector<string>>>(STRVECT1, make_shared<vector<string>>(dims_out[0])));
-    else if ((data->datatype == DTfloat64) || (data->datatype == DTfloat32))
-        data->dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(DBLVECT1, make_shared<vector<double>>(dims_out[0])));
-    else
-        data->intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(INTVECT1, make_shared<vector<int>>(dims_out[0])));
+// decode the records of a one column dataset
+void IH5File::decodePCOneCol(IData* data, RawRecords& raw){
 
+    // select the decoder once per dataset, records are {int posCount, value}
     bool typeerror = false;
-    char *memptr = (char*)memBuffer;
-    for (unsigned int i = 0; i < dims_out[0]; ++i){
-        data->posCounts.push_back(*((int*)memptr));
-        if (data->datatype == DTint32) {
-            data->intsptrmap.at(INTVECT1)->at(i) = *((int*)(memptr + 4));
-//            data->intvect.push_back(*((int*)(memptr + 4)));
-        }
-        else if (data->datatype == DTuint32) {
-            data->intsptrmap.at(INTVECT1)->at(i) = (int)*((unsigned int*)(memptr + 4));
-        }
-        else if (data->datatype == DTint8) {
-            data->intsptrmap.at(INTVECT1)->at(i) = (int)*(memptr + 4);
-//            data->intvect.push_back((int)*(memptr + 4));
-        }
-        else if (data->datatype == DTuint8) {
-            data->intsptrmap.at(INTVECT1)->at(i) = (int)*((unsigned char*)(memptr + 4));
-//            data->intvect.push_back((int)*((unsigned char*)(memptr + 4)));
-        }
-        else if (data->datatype == DTint16) {
-            data->intsptrmap.at(INTVECT1)->at(i) = (int)*((short*)(memptr + 4));
-//            data->intvect.push_back((int)*((short*)(memptr + 4)));
-        }
-        else if (data->datatype == DTuint16) {
-            data->intsptrmap.at(INTVECT1)->at(i) = (int)*((unsigned short*)(memptr + 4));
-//            data->intvect.push_back((int)*((unsigned short*)(memptr + 4)));
-        }
-        else if (data->datatype == DTfloat32) {
-            data->dblsptrmap.at(DBLVECT1)->at(i) = ((double)*((float*)(memptr + 4)));
-        }
-        else if (data->datatype == DTfloat64) {
-            data->dblsptrmap.at(DBLVECT1)->at(i) = *((double*)(memptr + 4));
-        }
-        else if (data->datatype == DTstring) {
-            string tmpstring(memptr + 4, element_size-4);
-            data->strsptrmap.at(STRVECT1)->at(i) = string(tmpstring.c_str());
-        }
+    const char *memptr = raw.buffer.get();
+    size_t element_size = raw.elementSize;
+    size_t count = raw.count;
+    addColumns(data, 1, count);
+    size_t firstPos = data->posCounts.size();
+    data->posCounts.resize(firstPos + count);
+    decodeMember<int, int>(memptr, element_size, 0, count, data->posCounts.data() + firstPos);
+    switch (data->datatype) {
+    case DTint32:
+        decodeMember<int, int>(memptr, element_size, 4, count, data->intsptrmap.at(INTVECT1)->data());
+        break;
+    case DTuint32:
+        decodeMember<unsigned int, int>(memptr, element_size, 4, count, data->intsptrmap.at(INTVECT1)->data());
+        break;
+    case DTint8:
+        decodeMember<signed char, int>(memptr, element_size, 4, count, data->intsptrmap.at(INTVECT1)->data());
+        break;
+    case DTuint8:
+        decodeMember<unsigned char, int>(memptr, element_size, 4, count, data->intsptrmap.at(INTVECT1)->data());
+        break;
+    case DTint16:
+        decodeMember<short, int>(memptr, element_size, 4, count, data->intsptrmap.at(INTVECT1)->data());
+        break;
+    case DTuint16:
+        decodeMember<unsigned short, int>(memptr, element_size, 4, count, data->intsptrmap.at(INTVECT1)->data());
+        break;
+    case DTfloat32:
+        decodeMember<float, double>(memptr, element_size, 4, count, data->dblsptrmap.at(DBLVECT1)->data());
+        break;
+    case DTfloat64:
+        decodeMember<double, double>(memptr, element_size, 4, count, data->dblsptrmap.at(DBLVECT1)->data());
+        break;
+    case DTstring:
+        decodeStringMember(memptr, element_size, 4, count, data->strsptrmap.at(STRVECT1));
+        break;
+    default:
+        typeerror = true;
+        break;
+    }
+    if (typeerror) STHROW("Unable to read data: unknown DataSet type");
+}
+
+// map the records of a contiguous, unfiltered dataset into raw (if options.mappedReads).
+// The file holds the records exactly as dset.read() with the file datatype returns them.
+// Returns false if the dataset can't be mapped, it is read with the H5 library then.
+bool IH5File::mapRecords(DataSet& dset, size_t elementSize, hsize_t count, RawRecords& raw){
+
+    if (!options.mappedReads || (count == 0)) return false;
+
+    hid_t dsetid = dset.getId();
+    hid_t plist = H5Dget_create_plist(dsetid);
+    if (plist < 0) return false;
+    bool contiguous = (H5Pget_layout(plist) == H5D_CONTIGUOUS) && (H5Pget_nfilters(plist) == 0) && (H5Pget_external_count(plist) == 0);
+    H5Pclose(plist);
+    haddr_t offset = H5Dget_offset(dsetid);
+    hsize_t bytes = elementSize * count;
+    if (!contiguous || (offset == HADDR_UNDEF) || (H5Dget_storage_size(dsetid) < bytes)) return false;
+
+    // other drivers don't keep the file as it is on disk
+    plist = H5Fget_access_plist(h5file.getId());
+    if (plist < 0) return false;
+    bool sec2 = (H5Pget_driver(plist) == H5FD_SEC2);
+    H5Pclose(plist);
+    int* fd = NULL;
+    if (!sec2 || (H5Fget_vfd_handle(h5file.getId(), H5P_DEFAULT, (void**)&fd) < 0) || (fd == NULL)) return false;
+
+    size_t pagesize = sysconf(_SC_PAGESIZE);
+    haddr_t start = offset - offset % pagesize;
+    size_t length = bytes + (offset - start);
+    void* mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, *fd, start);
+    if (mapping == MAP_FAILED) return false;
+    posix_madvise(mapping, length, POSIX_MADV_SEQUENTIAL);
+    countRead(bytes);
+    raw.buffer = shared_ptr<char>((char*)mapping + (offset - start), [mapping, length](char*){munmap(mapping, length);});
+    raw.elementSize = elementSize;
+    raw.count = count;
+    return true;
+}
+
+// read all records of dset into the staging buffer of raw
+void IH5File::readRecords(DataSet& dset, H5::DataType& dtype, size_t elementSize, hsize_t count, RawRecords& raw, string& objname){
+    raw.buffer = shared_ptr<char>((char*)malloc(elementSize * count), free);
+    if (raw.buffer == NULL)
+        STHROW("Unable to allocate memory when reading Dataset " << objname);
+    countAllocated();
+    raw.elementSize = elementSize;
+    raw.count = count;
+    try {
+        dset.read(raw.buffer.get(), dtype);
+        countRead(elementSize * count);
+    }
+    catch (DataSetIException error){
+        STHROW("Error reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+    }
+    catch (...){
+        STHROW("Unknown error while reading DataSet: " << objname);
+    }
+}
+
+// read the records of rows (ascending) into the staging buffer of raw
+void IH5File::readRows(DataSet& dset, H5::DataType& dtype, size_t elementSize, const vector<hsize_t>& rows, RawRecords& raw, string& objname){
+    hsize_t count = rows.size();
+    raw.buffer = shared_ptr<char>((char*)malloc(elementSize * max(count, (hsize_t)1)), free);
+    if (raw.buffer == NULL)
+        STHROW("Unable to allocate memory when reading Dataset " << objname);
+    countAllocated();
+    raw.elementSize = elementSize;
+    raw.count = count;
+    if (count == 0) return;
+
+    // rows with a constant distance are read as one hyperslab, any other rows as points
+    hsize_t start = rows[0];
+    hsize_t stride = (count > 1) ? rows[1] - rows[0] : 1;
+    bool regular = true;
+    for (hsize_t i = 1; regular && (i < count); ++i) regular = (rows[i] - rows[i - 1] == stride);
+    try {
+        DataSpace filespace = dset.getSpace();
+        if (regular)
+            filespace.selectHyperslab(H5S_SELECT_SET, &count, &start, &stride);
         else
-            typeerror = true;
+            filespace.selectElements(H5S_SELECT_SET, count, rows.data());
+        DataSpace memspace(1, &count);
+        dset.read(raw.buffer.get(), dtype, memspace, filespace);
+        countRead(elementSize * count);
+    }
+    catch (DataSetIException error){
+        STHROW("Error reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+    }
+    catch (DataSpaceIException error){
+        STHROW("Error reading H5 Dataspace in Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+    }
+    catch (...){
+        STHROW("Unknown error while reading DataSet: " << objname);
+    }
+}
 
-        memptr += element_size;
+// read one member of the compound dataset dset straight into dst, converted to memtype
+void IH5File::readMember(DataSet& dset, CompType& filetype, unsigned int member, const PredType& memtype, void* dst, string& objname){
+    try {
+        if ((int)member >= filetype.getNmembers())
+            STHROW("Missing column in Dataset " << objname);
+        CompType membertype(memtype.getSize());
+        membertype.insertMember(filetype.getMemberName(member), 0, memtype);
+        dset.read(dst, membertype);
+        countRead(memtype.getSize() * dset.getSpace().getSimpleExtentNpoints());
     }
-    free(memBuffer);
-    if (typeerror) STHROW("Unable to read data: unknown DataSet type");
+    catch (DataSetIException error){
+        STHROW("Error reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+    }
+    catch (DataTypeIException error){
+        STHROW("H5 Datatype error while reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
+    }
+}
+
+void IH5File::loadDataPCTwoCol(IData* data){
+    RawRecords raw;
+    if (fetchPCTwoCol(data, raw)) decodePCTwoCol(data, raw);
 }
 
-void IH5File::readDataPCTwoCol(IData* data){
+// open a two column dataset and check its layout against the metadata
+void IH5File::openPCTwoCol(IData* data, DataSet& h5dset, H5::DataType& h5dtype, size_t& element_size, hsize_t& rows){
 
     if ((data->datatype != DTint32) && (data->datatype != DTfloat64))
         STHROW("unsupported datatype, currently only int32 and float64 is supported for two column arrays");
 
     hsize_t dims_out[2];
-    size_t element_size;
-    DataSet h5dset;
-    H5::DataType h5dtype;
     string objname = data->getFQH5Name();
 
     try {
         h5dset = h5file.openDataSet(objname);
+        countOpened();
         h5dset.getSpace().getSimpleExtentDims( dims_out, NULL);
         h5dtype = h5dset.getDataType();
         element_size = h5dtype.getSize();
@@ -712,56 +1578,63 @@ void IH5File::readDataPCTwoCol(IData* data){
         STHROW("Unexpected dimension error in Dataset " << objname);
     if ((element_size != 20) && (element_size != 12))
         STHROW("Unexpected string size error in Dataset " << objname);
-    void* memBuffer = malloc(element_size * dims_out[0]);
-    if (memBuffer == NULL)
-        STHROW("Unable to allocate memory when reading Dataset " << objname);
-    try {
-        h5dset.read(memBuffer, h5dtype);
-    }
-    catch (DataSetIException error){
-        STHROW("Error reading Dataset " << objname << " H5 Error: " << error.getDetailMsg() );
-    }
-    catch (...){
-        STHROW("Unknown error while reading DataSet: " << objname);
-    }
+    rows = dims_out[0];
+}
 
-    char *memptr = (char*)memBuffer;
+// H5 part of reading a two column dataset, see fetchPCOneCol
+bool IH5File::fetchPCTwoCol(IData* data, RawRecords& raw){
 
-    if (data->datatype == DTint32){
-        data->intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(INTVECT1, make_shared<vector<int>>(dims_out[0])));
-        data->intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(INTVECT2, make_shared<vector<int>>(dims_out[0])));
-    }
-    else {
-        data->dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(DBLVECT1, make_shared<vector<double>>(dims_out[0])));
-        data->dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(DBLVECT2, make_shared<vector<double>>(dims_out[0])));
-    }
-    for (unsigned int i = 0; i < dims_out[0]; ++i){
-        int posCount=*((int*)memptr);
-        data->posCounts.push_back(posCount);
+    H5Lock lock(h5Mutex());
+    size_t element_size;
+    hsize_t rows;
+    DataSet h5dset;
+    H5::DataType h5dtype;
+    string objname = data->getFQH5Name();
+    openPCTwoCol(data, h5dset, h5dtype, element_size, rows);
+
+    if (mapRecords(h5dset, element_size, rows, raw)) return true;
+    if (options.memberReads && (h5dtype.getClass() == H5T_COMPOUND)){
+        addColumns(data, 2, rows);
+        CompType filetype(h5dset);
+        size_t firstPos = data->posCounts.size();
+        data->posCounts.resize(firstPos + rows);
+        readMember(h5dset, filetype, 0, PredType::NATIVE_INT, data->posCounts.data() + firstPos, objname);
         if (data->datatype == DTint32){
-            int target;
-            memcpy((void*)&target, memptr + 4, 4);
-            data->intsptrmap.at(INTVECT1)->at(i) = target;
-            //data->intsptrmap.at(INTVECT1).push_back(target);
-            memcpy((void*)&target, memptr + 8, 4);
-            //data->intvect2.push_back(target);
-            data->intsptrmap.at(INTVECT2)->at(i) = target;
+            readMember(h5dset, filetype, 1, PredType::NATIVE_INT, data->intsptrmap.at(INTVECT1)->data(), objname);
+            readMember(h5dset, filetype, 2, PredType::NATIVE_INT, data->intsptrmap.at(INTVECT2)->data(), objname);
         }
         else {
-            double target;
-            memcpy((void*)&target, memptr + 4, 8);
-            // data->dblvect.push_back(target);
-            data->dblsptrmap.at(DBLVECT1)->at(i) = target;
-            memcpy((void*)&target, memptr + 12, 8);
-            // data->dblvect2.push_back(target);
-            data->dblsptrmap.at(DBLVECT2)->at(i) = target;
+            readMember(h5dset, filetype, 1, PredType::NATIVE_DOUBLE, data->dblsptrmap.at(DBLVECT1)->data(), objname);
+            readMember(h5dset, filetype, 2, PredType::NATIVE_DOUBLE, data->dblsptrmap.at(DBLVECT2)->data(), objname);
         }
-        memptr += element_size;
+        return false;
     }
-    free(memBuffer);
+    readRecords(h5dset, h5dtype, element_size, rows, raw, objname);
+    return true;
 }
 
-void IH5File::addExtensionData(IData* data){
+// decode the records of a two column dataset
+void IH5File::decodePCTwoCol(IData* data, RawRecords& raw){
+
+    // records are {int posCount, value1, value2}
+    const char *memptr = raw.buffer.get();
+    size_t element_size = raw.elementSize;
+    size_t count = raw.count;
+    addColumns(data, 2, count);
+    size_t firstPos = data->posCounts.size();
+    data->posCounts.resize(firstPos + count);
+    decodeMember<int, int>(memptr, element_size, 0, count, data->posCounts.data() + firstPos);
+    if (data->datatype == DTint32){
+        decodeMember<int, int>(memptr, element_size, 4, count, data->intsptrmap.at(INTVECT1)->data());
+        decodeMember<int, int>(memptr, element_size, 8, count, data->intsptrmap.at(INTVECT2)->data());
+    }
+    else {
+        decodeMember<double, double>(memptr, element_size, 4, count, data->dblsptrmap.at(DBLVECT1)->data());
+        decodeMember<double, double>(memptr, element_size, 12, count, data->dblsptrmap.at(DBLVECT2)->data());
+    }
+}
+
+void IH5File::addExtensionData(const ChainInventory& inventory, IData* data, const ReadSelection* selection){
 
     string datasetname = data->getH5name();
     vector<int> exclusions;
@@ -769,56 +1642,90 @@ void IH5File::addExtensionData(IData* data){
         datasetname = data->getId();
     else {
         // since the name of averagemetadata is ambigous in all EVEH5 versions up to 4.0, use normalized data if any
-        for (vector<IMetaData *>::iterator it = chainmeta.begin(); it != chainmeta.end(); ++it){
-            IMetaData* mdat = *it;
-            if ((mdat->getId().compare(data->getId()) == 0) && (mdat->getNormalizeId().size() > 0)){
-                IData* normdata = new IData(*mdat);
-                if (mdat->dstype == EVEDSTPCOneColumn) readDataPCOneCol(normdata);
-                exclusions = normdata->getPosReferences();
-                delete normdata;
-                break;
-            }
+        IMetaData* normalized = findNormalized(inventory, data->getId());
+        if (normalized != NULL){
+            IData* normdata = new IData(*normalized);
+            if (normalized->dstype == EVEDSTPCOneColumn) readDataPCOneCol(normdata, selection);
+            exclusions = normdata->getPosReferences();
+            delete normdata;
+        }
+        // both are read with the same selection
+        if (!exclusions.empty() && (exclusions == data->getPosReferences())) return;
+    }
+    string fullh5name = data->getPath() + "averagemeta/" + datasetname;
+    shared_ptr<IData> avdata = readExtension(inventory, fullh5name + "__AverageCount", true, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTint32, INTVECT1, data, DTint32, AVCOUNT, exclusions);
+        copyAndFill(avdata.get(), DTint32, INTVECT2, data, DTint32, AVATT, exclusions);
+    }
+    avdata = readExtension(inventory, fullh5name + "__Limit", true, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT1, data, DTfloat64, AVLIMIT, exclusions);
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT2, data, DTfloat64, AVMAXDEV, exclusions);
+    }
+    avdata = readExtension(inventory, fullh5name + "__MaxAttempts", false, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTint32, INTVECT1, data, DTint32, AVATTPR, exclusions);
+    }
+    fullh5name = data->getPath() + "standarddev/" + datasetname;
+    avdata = readExtension(inventory, fullh5name + "__Count", true, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT1, data, DTint32, STDDEVCOUNT, exclusions);
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT2, data, DTfloat64, STDDEV, exclusions);
+    }
+}
+
+// first normalized dataset of channel id in the chain of inventory (NULL if there is none).
+// Only datasets of normalization groups are resolved, not the whole chain.
+IMetaData* IH5File::findNormalized(const ChainInventory& inventory, const string& id){
+    for (const string& calc : normalizations){
+        for (IMetaData* mdat : inventory.chainIndex.findByCalculation(calc)){
+            resolveMetaData(mdat);
+            if ((mdat->getId() == id) && (mdat->getNormalizeId().size() > 0)) return mdat;
+        }
+    }
+    return NULL;
+}
+
+// extension dataset fullh5name read as one or two column data, NULL if the dataset doesn't exist
+shared_ptr<IData> IH5File::readExtension(const ChainInventory& inventory, const string& fullh5name, bool twoColumns, const ReadSelection* selection){
+
+    MetaData *extensionmd = findMetaData(inventory.extensionIndex, fullh5name);
+    if (extensionmd == NULL) return NULL;
+    shared_ptr<IData> extdata = make_shared<IData>((IMetaData&)*extensionmd);
+    if (twoColumns)
+        readDataPCTwoCol(extdata.get(), selection);
+    else
+        readDataPCOneCol(extdata.get(), selection);
+    return extdata;
+}
+
+// find the extension datasets of all entries of mdvec in one pass over the extension inventory
+// of each path. Extension datasets are named <h5name or id>__<suffix>, they are listed by
+// path + <h5name or id>
+void IH5File::findExtensions(const ChainInventory& inventory, vector<MetaData*>& mdvec, ExtensionSet& extensions){
+
+    set<string> paths;
+    set<string> wanted;
+    for (MetaData* mdat : mdvec){
+        IMetaData* imdat = (IMetaData*)mdat;
+        resolveMetaData(imdat);
+        paths.insert(imdat->getPath());
+        wanted.insert(imdat->getPath() + imdat->getH5name());
+        wanted.insert(imdat->getPath() + imdat->getId());
+    }
+    for (const string& path : paths){
+        for (IMetaData* mdat : inventory.extensionIndex.getSection(path)){
+            string h5name = mdat->getH5name();
+            size_t separator = h5name.rfind("__");
+            if ((separator == string::npos) || (mdat->getPath() != path)) continue;
+            string key = path + h5name.substr(0, separator);
+            if (wanted.count(key) > 0) extensions[key].push_back(mdat);
         }
-        if (exclusions == data->getPosReferences()) return;
-    }
-    string fullh5name = data->getPath() + "averagemeta/" + datasetname + "__AverageCount";
-    MetaData *extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCTwoCol(avdata);
-        copyAndFill(avdata, DTint32, INTVECT1, data, DTint32, AVCOUNT, exclusions);
-        copyAndFill(avdata, DTint32, INTVECT2, data, DTint32, AVATT, exclusions);
-        delete avdata;
-    }
-    fullh5name = data->getPath() + "averagemeta/" + datasetname + "__Limit";
-    extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCTwoCol(avdata);
-        copyAndFill(avdata, DTfloat64, DBLVECT1, data, DTfloat64, AVLIMIT, exclusions);
-        copyAndFill(avdata, DTfloat64, DBLVECT2, data, DTfloat64, AVMAXDEV, exclusions);
-        delete avdata;
-    }
-    fullh5name = data->getPath() + "averagemeta/" + datasetname + "__MaxAttempts";
-    extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCOneCol(avdata);
-        copyAndFill(avdata, DTint32, INTVECT1, data, DTint32, AVATTPR, exclusions);
-        delete avdata;
-    }
-    fullh5name = data->getPath() + "standarddev/" + datasetname + "__Count";
-    extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCTwoCol(avdata);
-        copyAndFill(avdata, DTfloat64, DBLVECT1, data, DTint32, STDDEVCOUNT, exclusions);
-        copyAndFill(avdata, DTfloat64, DBLVECT2, data, DTfloat64, STDDEV, exclusions);
-        delete avdata;
-    }
-}
-
-void IH5File::copyAndFill(IData *srcdata, eve::DataType srctype, int srccol, IData *dstdata, eve::DataType dsttype, int dstcol, vector<int> excl){
+    }
+}
+
+void IH5File::copyAndFill(IData *srcdata, eve::DataType srctype, int srccol, IData *dstdata, eve::DataType dsttype, int dstcol, const vector<int>& excl){
 
     if (((srctype != DTint32) && (srctype != DTfloat64)) || ((dsttype != DTint32) && (dsttype != DTfloat64)))
         STHROW("unsupported datatype, currently only int32 or float64 are supported for data conversion (src)");
@@ -828,6 +1735,10 @@ void IH5File::copyAndFill(IData *srcdata, eve::DataType srctype, int srccol, IDa
 
     if (srcPosCounts.size() == 0) return;
 
+    // rows without value keep INT_MIN or NAN and are marked in the validity map of dstcol
+    map<int, shared_ptr<vector<unsigned long long>>>& dstvalidmap = (dsttype == DTint32) ? dstdata->intvalidmap : dstdata->dblvalidmap;
+    dstvalidmap.erase(dstcol);
+
     if ((srctype == dsttype) && (srcPosCounts.size() == dstPosCounts.size()) && (srcPosCounts == dstPosCounts)){
         if (dsttype == DTint32){
             if (dstdata->intsptrmap.find(dstcol) != dstdata->intsptrmap.end()) dstdata->intsptrmap.erase(dstcol);
@@ -854,50 +1765,57 @@ void IH5File::copyAndFill(IData *srcdata, eve::DataType srctype, int srccol, IDa
         int srcposcountsize = srcPosCounts.size();
         unsigned int srcsize;
         bool copiedNone = true;
-        if (srctype == DTint32)
-            srcsize = srcdata->intsptrmap.at(srccol)->size();
-        else
-            srcsize = srcdata->dblsptrmap.at(srccol)->size();
+        bool copiedAll = true;
+        shared_ptr<vector<unsigned long long>> valid = make_shared<vector<unsigned long long>>(validityWords(dstPosCounts.size()));
+        countAllocated(2);
+        // columns are looked up once, not per row
+        vector<int>* srcint = (srctype == DTint32) ? srcdata->intsptrmap.at(srccol).get() : NULL;
+        vector<double>* srcdbl = (srctype == DTint32) ? NULL : srcdata->dblsptrmap.at(srccol).get();
+        int* dstint = (dsttype == DTint32) ? dstdata->intsptrmap.at(dstcol)->data() : NULL;
+        double* dstdbl = (dsttype == DTint32) ? NULL : dstdata->dblsptrmap.at(dstcol)->data();
+        srcsize = (srcint != NULL) ? srcint->size() : srcdbl->size();
 
         for (unsigned int i=0; i < dstPosCounts.size(); ++i){
             bool noexclude = true;
-            int dstposcnt = dstPosCounts.at(i);
-            while ((srcdata->posCounts[srcidx] < dstposcnt) && (srcidx < srcsize - 1)) ++ srcidx;
+            int dstposcnt = dstPosCounts[i];
+            while ((srcPosCounts[srcidx] < dstposcnt) && (srcidx < srcsize - 1)) ++ srcidx;
             if (exclsize > 0){
                 while ((exclidx < (unsigned int) dstposcnt) && (exclidx < exclsize - 1)) ++exclidx;
-                if (dstposcnt == excl.at(exclidx)) noexclude = false;
+                if (dstposcnt == excl[exclidx]) noexclude = false;
             }
-            if ((srcposcountsize > 0) && (dstposcnt == srcdata->posCounts[srcidx]) && noexclude){
-                if (srcdata->getDataType() == DTint32){
-                    if (dsttype == DTint32)
-                        dstdata->intsptrmap.at(dstcol)->at(i) = srcdata->intsptrmap.at(srccol)->at(srcidx);
+            if ((srcposcountsize > 0) && (dstposcnt == srcPosCounts[srcidx]) && noexclude){
+                if (srcint != NULL){
+                    if (dstint != NULL)
+                        dstint[i] = (*srcint)[srcidx];
                     else
-                        dstdata->dblsptrmap.at(dstcol)->at(i) = (double)srcdata->intsptrmap.at(srccol)->at(srcidx);
+                        dstdbl[i] = (double)(*srcint)[srcidx];
                 }
                 else {
-                    if (dsttype == DTint32) {
+                    if (dstint != NULL) {
                         try {
-                            dstdata->intsptrmap.at(dstcol)->at(i) = (int)srcdata->dblsptrmap.at(srccol)->at(srcidx);
+                            dstint[i] = (int)(*srcdbl)[srcidx];
                         } catch (Exception error) {
-                            if (srcdata->dblsptrmap.at(srccol)->at(srcidx) > 0.0)
-                                dstdata->intsptrmap.at(dstcol)->at(i) = INT_MAX;
+                            if ((*srcdbl)[srcidx] > 0.0)
+                                dstint[i] = INT_MAX;
                             else
-                                dstdata->intsptrmap.at(dstcol)->at(i) = INT_MIN;
+                                dstint[i] = INT_MIN;
                         }
                     }
                     else {
-                        dstdata->dblsptrmap.at(dstcol)->at(i) = srcdata->dblsptrmap.at(srccol)->at(srcidx);
+                        dstdbl[i] = (*srcdbl)[srcidx];
                     }
                 }
                 ++srcidx;
                 if (srcidx >= srcsize) --srcidx;
                 copiedNone = false;
+                setValidBit(*valid, i);
             }
             else {
-                if (dsttype == DTint32)
-                    dstdata->intsptrmap.at(dstcol)->at(i) = INT_MIN;
+                copiedAll = false;
+                if (dstint != NULL)
+                    dstint[i] = INT_MIN;
                 else
-                    dstdata->dblsptrmap.at(dstcol)->at(i) = NAN;
+                    dstdbl[i] = NAN;
             }
         }
         if(copiedNone){
@@ -908,11 +1826,14 @@ void IH5File::copyAndFill(IData *srcdata, eve::DataType srctype, int srccol, IDa
                 if (dstdata->dblsptrmap.find(dstcol) != dstdata->dblsptrmap.end()) dstdata->dblsptrmap.erase(dstcol);
             }
         }
+        else if (!copiedAll)
+            dstvalidmap.insert(pair<int, shared_ptr<vector<unsigned long long>>>(dstcol, valid));
     }
 }
 
 vector<string> IH5File::getLogData(){
 
+    H5Lock lock(h5Mutex());
     vector<string> stringlist;
 
     StrType tid1(0, H5T_VARIABLE);
@@ -922,6 +1843,7 @@ vector<string> IH5File::getLogData(){
 
     try {
         h5dset = h5file.openDataSet("/LiveComment");
+        countOpened();
     }
     catch (Exception error) {
         return stringlist;
@@ -955,13 +1877,149 @@ vector<string> IH5File::getLogData(){
     return stringlist;
 }
 
-vector<Data*> IH5File::getJoinedData(vector<MetaData*>& mdvec, FillRule fillType){
+// merge posCounts into the sorted list of unique posCounts merged
+void IH5File::mergePosCounts(vector<int>& merged, const vector<int>& posCounts){
+    vector<int> sorted;
+    const vector<int>* addList = &posCounts;
+    if (!is_sorted(posCounts.begin(), posCounts.end()) || (adjacent_find(posCounts.begin(), posCounts.end()) != posCounts.end())){
+        sorted = posCounts;
+        sort(sorted.begin(), sorted.end());
+        sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+        addList = &sorted;
+    }
+    if (merged.empty()){
+        merged = *addList;
+        return;
+    }
+    vector<int> result;
+    result.reserve(max(merged.size(), addList->size()));
+    set_union(merged.begin(), merged.end(), addList->begin(), addList->end(), back_inserter(result));
+    merged.swap(result);
+}
+
+vector<Data*> IH5File::getJoinedData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fillType){
+    return joinData(inventory, mdvec, fillType, NULL);
+}
+
+vector<Data*> IH5File::getJoinedData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fillType, const Selection& selection){
+    return joinData(inventory, mdvec, fillType, selectsAll(selection) ? NULL : &selection);
+}
+
+// indices of values in ascending order of the values, equal values keep their order
+static vector<int> sortedOrder(const vector<int>& values){
+    vector<int> order(values.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    if (!is_sorted(values.begin(), values.end()))
+        stable_sort(order.begin(), order.end(), [&](int a, int b){return values[a] < values[b];});
+    return order;
+}
+
+// time of each of the ascending posRefs from the timestamps (tsPosRefs[i] was at tsTimes[i]),
+// INT_MIN if a posRef has no timestamp
+static vector<int> positionTimes(const vector<int>& posRefs, const vector<int>& tsPosRefs, const vector<int>& tsTimes){
+    vector<int> times(posRefs.size(), INT_MIN);
+    vector<int> order = sortedOrder(tsPosRefs);
+    size_t next = 0;
+    for (size_t i = 0; i < posRefs.size(); ++i){
+        while ((next < order.size()) && (tsPosRefs[order[next]] < posRefs[i])) ++next;
+        if ((next < order.size()) && (tsPosRefs[order[next]] == posRefs[i])) times[i] = tsTimes[order[next]];
+    }
+    return times;
+}
+
+// row of the event in eventTimes selected by alignment for each of times (-1: none),
+// events and positions are merged in time order
+static vector<int> alignEvents(const vector<int>& eventTimes, const vector<int>& times, TimeAlignment alignment){
+    vector<int> rows(times.size(), -1);
+    vector<int> events = sortedOrder(eventTimes);
+    vector<int> positions = sortedOrder(times);
+    size_t next = 0;    // first event later than the current position
+    for (int pos : positions){
+        long long time = times[pos];
+        if (time == INT_MIN) continue;
+        while ((next < events.size()) && (eventTimes[events[next]] <= time)) ++next;
+        if (alignment == NearestValue){
+            long long before = (next > 0) ? time - eventTimes[events[next - 1]] : LLONG_MAX;
+            long long after = (next < events.size()) ? eventTimes[events[next]] - time : LLONG_MAX;
+            if (before > after){
+                rows[pos] = events[next];
+                continue;
+            }
+        }
+        if (next > 0) rows[pos] = events[next - 1];
+    }
+    return rows;
+}
+
+// join the data of mdvec without monitor data, align the monitor data of mdvec to the positions
+// through the posRef timestamps of the chain
+vector<Data*> IH5File::getJoinedData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fillType, TimeAlignment alignment){
+
+    vector<MetaData*> joinList;
+    vector<MetaData*> monitorList;
+    for (MetaData* mdata : mdvec)
+        if (mdata->getSection() == Monitor)
+            monitorList.push_back(mdata);
+        else
+            joinList.push_back(mdata);
+
+    vector<Data*> datavect = joinData(inventory, joinList, fillType, NULL);
+    if (monitorList.empty() || (!joinList.empty() && datavect.empty())) return datavect;
+
+    IData* timestamps = NULL;
+    try {
+        if (inventory.timestampMeta == NULL)
+            STHROW("Unable to align monitor data: no timestamp dataset " << inventory.timestampName);
+        timestamps = (IData*) getData(inventory, inventory.timestampMeta);
+        vector<int> tsTimes;
+        if (timestamps->intsptrmap.find(INTVECT1) != timestamps->intsptrmap.end())
+            tsTimes = *timestamps->intsptrmap.at(INTVECT1);
+        else if (timestamps->dblsptrmap.find(DBLVECT1) != timestamps->dblsptrmap.end())
+            for (double msecs : *timestamps->dblsptrmap.at(DBLVECT1)) tsTimes.push_back((int)msecs);
+        else
+            STHROW("Unable to align monitor data: unsupported timestamp dataset " << inventory.timestampName);
+
+        // the positions of the joined data or all positions with a timestamp
+        vector<int> posRefs;
+        if (datavect.empty())
+            mergePosCounts(posRefs, timestamps->posCounts);
+        else
+            posRefs = ((IData*)datavect[0])->posCounts;
+        vector<int> times = positionTimes(posRefs, timestamps->posCounts, tsTimes);
+        delete timestamps;
+        timestamps = NULL;
+
+        for (MetaData* mdata : monitorList){
+            IData* monitor = (IData*) getData(inventory, mdata);
+            IData* aligned;
+            try {
+                if (monitor->isArrayData()) STHROW("Unable to align monitor data: array data " << monitor->getFQH5Name());
+                aligned = new (ResultArena::active()) IData(*monitor, posRefs, alignEvents(monitor->posCounts, times, alignment));
+            }
+            catch (...){
+                delete monitor;
+                throw;
+            }
+            delete monitor;
+            datavect.push_back(aligned);
+        }
+    }
+    catch (...){
+        if (timestamps != NULL) delete timestamps;
+        for (Data* data : datavect) delete data;
+        throw;
+    }
+    return datavect;
+}
+
+// join the datasets of mdvec; with a selection only the rows in its posRef interval are read
+// and joined, the rows of the joined data are selected afterwards
+vector<Data*> IH5File::joinData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fillType, const Selection* selection){
 
     vector<IData*> datavect;
     vector<Data*> moddatavect;
-    set<int> channelPosCounts;
-    set<int> axisPosCounts;
-    set<int> newlist;
+    vector<int> channelPosCounts;
+    vector<int> axisPosCounts;
     vector<int> posCounters;
     vector<MetaData*> standardList;
     vector<MetaData*> timeStampList;
@@ -977,44 +2035,70 @@ vector<Data*> IH5File::getJoinedData(vector<MetaData*>& mdvec, FillRule fillType
         else if (mdata->getSection() == Snapshot)
             snapshotMap.insert(pair<string, MetaData*>(mdata->getId(), mdata));
 
-    for (vector<MetaData*>::iterator mdit=standardList.begin(); mdit != standardList.end(); ++mdit){
-        IData* idat = (IData*) getData((IMetaData*)*mdit);
-        if (idat != NULL) datavect.push_back(idat);
+    ReadSelection interval;
+    vector<Data*> standardData;
+    if (selection == NULL)
+        standardData = getData(inventory, standardList);
+    else {
+        if (selection->posRefs.empty()){
+            interval.firstPosRef = selection->firstPosRef;
+            interval.lastPosRef = selection->lastPosRef;
+        }
+        else {
+            interval.firstPosRef = *min_element(selection->posRefs.begin(), selection->posRefs.end());
+            interval.lastPosRef = *max_element(selection->posRefs.begin(), selection->posRefs.end());
+        }
+        // the last axis position before the interval is the first fill value
+        ReadSelection axisInterval(interval, (fillType == LastFill) || (fillType == LastNANFill));
+        try {
+            for (MetaData* mdata : standardList)
+                standardData.push_back(getSelectedData(inventory, (IMetaData*)mdata, (mdata->getDeviceType() == Axis) ? axisInterval : interval));
+        }
+        catch (...){
+            for (Data* data : standardData) delete data;
+            throw;
+        }
+    }
+    for (vector<Data*>::iterator dit=standardData.begin(); dit != standardData.end(); ++dit){
+        IData* idat = (IData*) *dit;
+        datavect.push_back(idat);
         DeviceType deviceType = idat->getDeviceType();
         if (deviceType == Channel) {
-            channelPosCounts.insert(idat->posCounts.begin(), idat->posCounts.end());
+            mergePosCounts(channelPosCounts, idat->posCounts);
         }
         else if (deviceType == Axis) {
-            axisPosCounts.insert(idat->posCounts.begin(), idat->posCounts.end());
+            mergePosCounts(axisPosCounts, idat->posCounts);
         }
 
     }
 
     if (fillType == NoFill) {
         if ((channelPosCounts.size() == 0) || (axisPosCounts.size() == 0)) return moddatavect;
-        for (set<int>::iterator it=axisPosCounts.begin(); it != axisPosCounts.end(); ++it){
-            if (channelPosCounts.find(*it) != channelPosCounts.end()) newlist.insert(*it);
-        }
+        set_intersection(axisPosCounts.begin(), axisPosCounts.end(), channelPosCounts.begin(), channelPosCounts.end(), back_inserter(posCounters));
     }
     else if (fillType == LastFill) {
         if (channelPosCounts.size() == 0) return moddatavect;
-        newlist.insert(channelPosCounts.begin(), channelPosCounts.end());
+        posCounters.swap(channelPosCounts);
     }
     else if (fillType == NANFill) {
         if (axisPosCounts.size() == 0) return moddatavect;
-        newlist.insert(axisPosCounts.begin(), axisPosCounts.end());
+        posCounters.swap(axisPosCounts);
     }
     else if (fillType == LastNANFill) {
         if ((axisPosCounts.size() == 0) && (channelPosCounts.size() == 0)) return moddatavect;
-        newlist.insert(axisPosCounts.begin(), axisPosCounts.end());
-        newlist.insert(channelPosCounts.begin(), channelPosCounts.end());
+        set_union(axisPosCounts.begin(), axisPosCounts.end(), channelPosCounts.begin(), channelPosCounts.end(), back_inserter(posCounters));
     }
 
-    posCounters.insert(posCounters.begin(),newlist.begin(), newlist.end());
     // add timestamp here, because it is not used to calc posCounters
-    for (vector<MetaData*>::iterator mdit=timeStampList.begin(); mdit != timeStampList.end(); ++mdit){
-        IData* idat = (IData*) getData((IMetaData*)*mdit);
-        if (idat != NULL) datavect.push_back(idat);
+    try {
+        for (vector<MetaData*>::iterator mdit=timeStampList.begin(); mdit != timeStampList.end(); ++mdit){
+            IData* idat = (IData*) ((selection == NULL) ? getData(inventory, (IMetaData*)*mdit) : getSelectedData(inventory, (IMetaData*)*mdit, interval));
+            if (idat != NULL) datavect.push_back(idat);
+        }
+    }
+    catch (...){
+        for (IData* data : datavect) delete data;
+        throw;
     }
 
     for (vector<IData*>::iterator datait=datavect.begin(); datait != datavect.end(); ++datait){
@@ -1024,52 +2108,419 @@ vector<Data*> IH5File::getJoinedData(vector<MetaData*>& mdvec, FillRule fillType
                     && (newData->getDeviceType() == Axis)
                     && snapshotMap.find(newData->getId()) != snapshotMap.end()){
                 // need to fill in start value from snapshot
-                IData* snapData = (IData*) getData((IMetaData*)snapshotMap.find(newData->getId())->second);
-                newData = new IData(*newData, posCounters, fillType, snapData);
+                IData* snapData;
+                try {
+                    snapData = (IData*) getData(inventory, (IMetaData*)snapshotMap.find(newData->getId())->second);
+                }
+                catch (...){
+                    for (Data* data : moddatavect) delete data;
+                    for (; datait != datavect.end(); ++datait) delete *datait;
+                    throw;
+                }
+                newData = new (ResultArena::active()) IData(*newData, posCounters, fillType, snapData);
+                delete snapData;
             }
             else {
-                newData = new IData(*newData, posCounters, fillType);
+                newData = new (ResultArena::active()) IData(*newData, posCounters, fillType);
             }
             delete *datait;
         }
         moddatavect.push_back(newData);
     }
+
+    if (selection != NULL){
+        vector<int> selectedPosCounts;
+        for (hsize_t row : selectRows(posCounters, ReadSelection(*selection))) selectedPosCounts.push_back(posCounters[row]);
+        if (selectedPosCounts != posCounters){
+            for (vector<Data*>::iterator datait=moddatavect.begin(); datait != moddatavect.end(); ++datait){
+                IData* newData = new (ResultArena::active()) IData(*(IData*)*datait, selectedPosCounts, NoFill);
+                delete *datait;
+                *datait = newData;
+            }
+        }
+    }
     return moddatavect;
 }
 
-vector<Data*> IH5File::getPreferredData(FillRule fill){
+ColumnarTable* IH5File::getColumnarData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fillType){
+    vector<Data*> joined = getJoinedData(inventory, mdvec, fillType);
+    ColumnarTable* table;
+    try {
+        table = new IColumnarTable(joined);
+    }
+    catch (...){
+        for (Data* data : joined) delete data;
+        throw;
+    }
+    for (Data* data : joined) delete data;
+    return table;
+}
+
+vector<Data*> IH5File::getPreferredData(const ChainInventory& inventory, FillRule fill){
+    vector<MetaData*> mdvect = getPreferredMetaData(inventory);
+    return getJoinedData(inventory, mdvect, fill);
+}
+
+// read the preferred data of the chain of inventory with its extension datasets into the
+// data cache (see IPrefetcher), false if the cache is disabled
+bool IH5File::warmCache(const ChainInventory& inventory){
+    if (dataCache.getMaxBytes() == 0) return false;
+    vector<MetaData*> mdvect = getPreferredMetaData(inventory);
+    for (Data* data : getData(inventory, mdvect)) delete data;
+    return true;
+}
+
+// metadata of preferred axis and channel of the chain of inventory (empty if not available)
+vector<MetaData*> IH5File::getPreferredMetaData(const ChainInventory& inventory){
     string prefAxis = "";
     string prefChannel = "";
     vector<MetaData*> mdvect;
+    const map<string, string>& attributes = inventory.chainAttributes;
 
-    map<string, string>::iterator it = chainAttributes.find("preferredAxis");
-    if (it != chainAttributes.end()) prefAxis = it->second;
-    it = chainAttributes.find("preferredChannel");
-    if (it != chainAttributes.end()) prefChannel = it->second;
-    it = chainAttributes.find("PreferredNormalizationChannel");
-    if (it != chainAttributes.end()) prefChannel = "normalized/" + prefChannel + "__" + it->second;
+    map<string, string>::const_iterator it = attributes.find("preferredAxis");
+    if (it != attributes.end()) prefAxis = it->second;
+    it = attributes.find("preferredChannel");
+    if (it != attributes.end()) prefChannel = it->second;
+    it = attributes.find("PreferredNormalizationChannel");
+    if (it != attributes.end()) prefChannel = "normalized/" + prefChannel + "__" + it->second;
 
     if ((prefAxis.size() > 0) && (prefChannel.size() > 0)){
-        prefAxis = getSectionString(Standard) + "/" + prefAxis;
-        MetaData* axismd = findMetaData(chainmeta, prefAxis);
-        prefChannel = getSectionString(Standard) + "/" + prefChannel;
-        MetaData* channelmd = findMetaData(chainmeta, prefChannel);
+        prefAxis = getSectionString(Standard, inventory.chain) + "/" + prefAxis;
+        MetaData* axismd = findMetaData(inventory.chainIndex, prefAxis);
+        prefChannel = getSectionString(Standard, inventory.chain) + "/" + prefChannel;
+        MetaData* channelmd = findMetaData(inventory.chainIndex, prefChannel);
         if ((axismd != NULL) && (channelmd != NULL)) {
             mdvect.push_back(axismd);
             mdvect.push_back(channelmd);
         }
     }
-    return getJoinedData(mdvect, fill);
+    return mdvect;
+}
+
+vector<Data*> IH5File::getData(const ChainInventory& inventory, vector<MetaData*>& md, const Selection& selection){
+    vector<Data*> datavect;
+
+    if (selectsAll(selection)) return getData(inventory, md);
+
+    ReadSelection rowSelection(selection);
+    try {
+        for (vector<MetaData*>::iterator mdit=md.begin(); mdit != md.end(); ++mdit){
+            Data* idat = getSelectedData(inventory, (IMetaData*)*mdit, rowSelection);
+            if (idat != NULL) datavect.push_back(idat);
+        }
+    }
+    catch (...){
+        for (Data* data : datavect) delete data;
+        throw;
+    }
+    return datavect;
 }
 
-vector<Data*> IH5File::getData(vector<MetaData*>& md){
+vector<Data*> IH5File::getData(const ChainInventory& inventory, vector<MetaData*>& md){
     vector<Data*> datavect;
 
-    for (vector<MetaData*>::iterator mdit=md.begin(); mdit != md.end(); ++mdit){
-        Data* idat = getData((IMetaData*)*mdit);
-        if (idat != NULL) datavect.push_back(idat);
+    if ((options.decodeThreads > 0) && (md.size() > 1))
+        return getDataPipelined(inventory, md);
+
+    try {
+        for (vector<MetaData*>::iterator mdit=md.begin(); mdit != md.end(); ++mdit){
+            Data* idat = getData(inventory, (IMetaData*)*mdit);
+            if (idat != NULL) datavect.push_back(idat);
+        }
+    }
+    catch (...){
+        for (Data* data : datavect) delete data;
+        throw;
     }
     return datavect;
 }
 
+// fetch the dataset of mdata and all datasets addExtensionData may read for it,
+// extensions are the extension datasets found by findExtensions
+void IH5File::prefetchData(const ChainInventory& inventory, IMetaData* mdata, PrefetchSet& fetched, const ExtensionSet& extensions){
+
+    checkCancelled();
+    resolveMetaData(mdata);
+    prefetch(mdata, fetched);
+
+    vector<IMetaData*> candidates;
+    set<string> keys = {mdata->getPath() + mdata->getH5name(), mdata->getPath() + mdata->getId()};
+    for (const string& key : keys){
+        ExtensionSet::const_iterator it = extensions.find(key);
+        if (it != extensions.end()) candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    }
+    // normalized data used for exclusions
+    IMetaData* normalized = findNormalized(inventory, mdata->getId());
+    if (normalized != NULL) candidates.push_back(normalized);
+
+    // a candidate which can't be read is left to the serial fallback
+    for (IMetaData* mdat : candidates){
+        try {
+            prefetch(mdat, fetched);
+        }
+        catch (std::exception&){
+            fetched.erase(mdat->getFQH5Name());
+        }
+    }
+}
+
+void IH5File::prefetch(IMetaData* mdata, PrefetchSet& fetched){
+
+    string fqname = mdata->getFQH5Name();
+    if (fetched.find(fqname) != fetched.end()) return;
+
+    shared_ptr<IData> data = make_shared<IData>(*mdata);
+    if (dataCache.getMaxBytes() > 0){
+        lock_guard<mutex> lock(cacheMutex);
+        if (dataCache.lookup(fqname, data.get())){
+            fetched[fqname].loaded = data;
+            return;
+        }
+    }
+
+    PrefetchedData entry;
+    if (mdata->dstype == EVEDSTArray)
+        loadDataArray(data.get());
+    else if (mdata->dstype == EVEDSTPCOneColumn){
+        if (fetchPCOneCol(data.get(), entry.raw)) entry.decode = decodePCOneCol;
+    }
+    else if (mdata->dstype == EVEDSTPCTwoColumn){
+        if (fetchPCTwoCol(data.get(), entry.raw)) entry.decode = decodePCTwoCol;
+    }
+    else
+        return;
+
+    if (entry.decode == NULL){
+        entry.loaded = data;
+        lock_guard<mutex> lock(cacheMutex);
+        if (dataCache.getMaxBytes() > 0) dataCache.insert(fqname, data.get());
+    }
+    fetched[fqname] = entry;
+}
+
+// the decode stage only looks up metadata, resolve and index everything it may need
+void IH5File::prepareDecode(const ChainInventory& inventory, vector<MetaData*>& mdvec){
+    for (IMetaData* mdat : inventory.extensionmeta) resolveMetaData(mdat);
+    for (const string& calc : normalizations)
+        for (IMetaData* mdat : inventory.chainIndex.findByCalculation(calc)) resolveMetaData(mdat);
+    for (MetaData* mdat : mdvec) inventory.extensionIndex.getSection(((IMetaData*)mdat)->getPath());
+}
+
+// getData with the H5 reads done by the calling thread (the H5 library is not thread-safe)
+// and decoding and merging of extension data done by options.decodeThreads workers.
+// Results are in the order of mdvec, the first error in that order is thrown.
+vector<Data*> IH5File::getDataPipelined(const ChainInventory& inventory, vector<MetaData*>& mdvec){
+
+    size_t total = mdvec.size();
+    vector<PrefetchSet> fetched(total);
+    vector<Data*> results(total, NULL);
+    vector<exception_ptr> errors(total);
+    vector<char> redo(total, 0);
+
+    prepareDecode(inventory, mdvec);
+    ExtensionSet extensions;
+    findExtensions(inventory, mdvec, extensions);
+
+    mutex queueMutex;
+    condition_variable queueCond;
+    condition_variable slotCond;
+    size_t fetchedCount = 0;
+    size_t decodedCount = 0;
+    size_t nextDecode = 0;
+    bool ioDone = false;
+    size_t maxInFlight = 2 * options.decodeThreads;
+
+    ReadStats* stats = threadStats;
+    ReadControl* control = readControl;
+    auto worker = [&](){
+        threadStats = stats;
+        readControl = control;
+        while (true){
+            size_t index;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueCond.wait(lock, [&]{return (nextDecode < fetchedCount) || ioDone;});
+                if (nextDecode >= fetchedCount) return;
+                index = nextDecode++;
+            }
+            workerPrefetch = &fetched[index];
+            try {
+                results[index] = getData(inventory, mdvec[index]);
+            }
+            catch (NotPrefetched&){
+                redo[index] = 1;
+            }
+            catch (...){
+                errors[index] = current_exception();
+            }
+            workerPrefetch = NULL;
+            fetched[index].clear();
+            {
+                lock_guard<mutex> lock(queueMutex);
+                ++decodedCount;
+            }
+            slotCond.notify_one();
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned int i = 0; i < options.decodeThreads; ++i) workers.push_back(thread(worker));
+
+    // I/O stage, stops at the first error like the serial version
+    size_t lastItem = total;
+    for (size_t index = 0; index < total; ++index){
+        {
+            unique_lock<mutex> lock(queueMutex);
+            slotCond.wait(lock, [&]{return (fetchedCount - decodedCount) < maxInFlight;});
+        }
+        try {
+            prefetchData(inventory, (IMetaData*)mdvec[index], fetched[index], extensions);
+        }
+        catch (...){
+            errors[index] = current_exception();
+            lastItem = index + 1;
+            break;
+        }
+        {
+            lock_guard<mutex> lock(queueMutex);
+            ++fetchedCount;
+        }
+        queueCond.notify_one();
+    }
+    {
+        lock_guard<mutex> lock(queueMutex);
+        ioDone = true;
+    }
+    queueCond.notify_all();
+    for (thread& thr : workers) thr.join();
+
+    vector<Data*> datavect;
+    for (size_t index = 0; index < lastItem; ++index){
+        try {
+            if (errors[index] != NULL) rethrow_exception(errors[index]);
+            if (redo[index]) results[index] = getData(inventory, mdvec[index]);
+        }
+        catch (...){
+            for (Data* dat : results) if (dat != NULL) delete dat;
+            throw;
+        }
+        if (results[index] != NULL) datavect.push_back(results[index]);
+    }
+    return datavect;
+}
+
+// read the data of a FileBatch selection, the H5 calls take the H5 lock,
+// decoding and joining run without it
+vector<Data*> IH5File::getBatchData(const BatchSelection& selection){
+
+    InventoryPtr inventory = getInventory(selection.chain);
+    vector<MetaData*> mdvec;
+    if (selection.preferred){
+        for (MetaData* mdat : getPreferredMetaData(*inventory)) mdvec.push_back(new IMetaData(*(IMetaData*)mdat));
+    }
+    else {
+        for (Section section : selection.sections){
+            vector<MetaData*> found;
+            if (selection.ids.empty() && selection.names.empty())
+                found = getMetaData(*inventory, section, "", "");
+            for (const string& id : selection.ids){
+                vector<MetaData*> byId = getMetaData(*inventory, section, id, "");
+                found.insert(found.end(), byId.begin(), byId.end());
+            }
+            for (const string& name : selection.names){
+                vector<MetaData*> byName = getMetaData(*inventory, section, "", name);
+                found.insert(found.end(), byName.begin(), byName.end());
+            }
+            mdvec.insert(mdvec.end(), found.begin(), found.end());
+        }
+    }
+    bool joined = selection.preferred || selection.joined;
+
+    vector<Data*> datavect;
+    try {
+        datavect = joined ? joinData(*inventory, mdvec, selection.fill, NULL) : getData(*inventory, mdvec);
+    }
+    catch (...){
+        for (MetaData* mdat : mdvec) delete mdat;
+        throw;
+    }
+    for (MetaData* mdat : mdvec) delete mdat;
+    return datavect;
+}
+
+DataStream* IH5File::openStream(MetaData* metadata, unsigned int chunkRows){
+
+    IMetaData* mdata = (IMetaData*)metadata;
+    if (chunkRows == 0) STHROW("Unable to open stream with block size 0");
+    resolveMetaData(mdata);
+
+    H5Lock lock(h5Mutex());
+    IData data(*mdata);
+    DataSet h5dset;
+    H5::DataType h5dtype;
+    size_t element_size;
+    hsize_t rows;
+    if (mdata->dstype == EVEDSTPCOneColumn){
+        openPCOneCol(&data, h5dset, h5dtype, element_size, rows);
+        return new IDataStream(*mdata, h5dset, h5dtype, element_size, rows, chunkRows, decodePCOneCol);
+    }
+    else if (mdata->dstype == EVEDSTPCTwoColumn){
+        openPCTwoCol(&data, h5dset, h5dtype, element_size, rows);
+        return new IDataStream(*mdata, h5dset, h5dtype, element_size, rows, chunkRows, decodePCTwoCol);
+    }
+    else
+        STHROW("Unable to open stream for " << mdata->getFQH5Name() << ": only one and two column datasets are supported");
+    return NULL;
+}
+
+JoinedStream* IH5File::openJoinedStream(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fillType, unsigned int chunkRows){
+
+    vector<MetaData*> joinList;
+    vector<MetaData*> timeStampList;
+    map<string, MetaData*> snapshotMap;
+
+    if (chunkRows == 0) STHROW("Unable to open stream with block size 0");
+
+    for (MetaData* mdata: mdvec)
+        if (mdata->getSection() == Standard)
+            joinList.push_back(mdata);
+        else if (mdata->getSection() == Timestamp)
+            timeStampList.push_back(mdata);
+        else if (mdata->getSection() == Snapshot)
+            snapshotMap.insert(pair<string, MetaData*>(mdata->getId(), mdata));
+    joinList.insert(joinList.end(), timeStampList.begin(), timeStampList.end());
+
+    vector<JoinSource*> sources;
+    try {
+        for (MetaData* metadata : joinList){
+            IMetaData* mdata = (IMetaData*)metadata;
+            DataStream* stream = openStream(mdata, chunkRows);
+            IData shape(*mdata);
+            addColumns(&shape, (mdata->dstype == EVEDSTPCTwoColumn) ? 2 : 1, 0);
+
+            // posCounts of standard channels and/or axes define the rows of the join
+            DeviceType deviceType = mdata->getDeviceType();
+            bool generating = (mdata->getSection() == Standard) && (
+                    ((deviceType == Channel) && (fillType != NANFill)) || ((deviceType == Axis) && (fillType != LastFill)));
+            bool dofill = ((fillType == LastFill) || (fillType == LastNANFill)) && (deviceType == Axis);
+            IData* snapData = NULL;
+            if (dofill && (snapshotMap.find(mdata->getId()) != snapshotMap.end())){
+                try {
+                    snapData = (IData*) getData(inventory, (IMetaData*)snapshotMap.find(mdata->getId())->second);
+                }
+                catch (...){
+                    delete stream;
+                    throw;
+                }
+            }
+            sources.push_back(new JoinSource(shape, stream, generating, dofill, snapData));
+        }
+    }
+    catch (...){
+        for (JoinSource* source : sources) delete source;
+        throw;
+    }
+    return new IJoinedStream(sources, fillType, chunkRows);
+}
+
 } // namespace end
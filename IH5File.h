@@ -9,12 +9,20 @@
 #include <map>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <atomic>
 #include "eve.h"
 #include "H5Cpp.h"
 #include "IData.h"
 #include "IMetaData.h"
 #include "ifilemetadata.h"
 #include "ichainmetadata.h"
+#include "metadataindex.h"
+#include "datacache.h"
+#include "idatastream.h"
+#include "ijoinedstream.h"
+#include "h5lock.h"
+#include "icallstats.h"
 
 #ifndef H5_NO_NAMESPACE
      using namespace H5;
@@ -24,65 +32,188 @@ using namespace std;
 
 namespace eve {
 
+// inventory of a chain (chain 0: the monitors in /device), built once when the chain is
+// first needed and not changed afterwards, refresh() replaces it. Reads of several threads
+// share it: entries of a lazy inventory are resolved with the H5 lock held, the indexes
+// add their buckets under their own lock.
+struct ChainInventory {
+    ChainInventory(int chain) : chain(chain), timestampMeta(NULL) {};
+    ~ChainInventory();
+    int chain;
+    string timestampName;       // full name of the posRef timestamps of the chain
+    map<string, string> chainAttributes;
+    vector<IMetaData*> chainmeta;
+    vector<IMetaData*> extensionmeta;
+    MetaDataIndex chainIndex;
+    MetaDataIndex extensionIndex;
+    IMetaData* timestampMeta;
+
+private:
+    ChainInventory(const ChainInventory&);
+    ChainInventory& operator=(const ChainInventory&);
+};
+
+typedef shared_ptr<const ChainInventory> InventoryPtr;
+
+// selection used when reading a dataset
+struct ReadSelection : public Selection {
+    ReadSelection() : previousRow(false) {};
+    ReadSelection(const Selection& selection, bool previous=false) : Selection(selection), previousRow(previous) {};
+    bool previousRow;       // also select the last row before the selected posRefs (fill value for LastFill)
+};
+
+// cancellation and progress of an asynchronous read (see IAsyncFile),
+// checked before each dataset and each array dataset of an array group
+struct ReadControl {
+    ReadControl() : cancelled(false), datasetsDone(0), rowsDone(0), rowsTotal(0) {};
+    atomic<bool> cancelled;
+    atomic<size_t> datasetsDone;
+    atomic<size_t> rowsDone;        // arrays read of the array group being read
+    atomic<size_t> rowsTotal;       // arrays of the array group being read
+};
+
+// thrown by a read if its ReadControl has been cancelled
+struct ReadCancelled {};
+
 class IH5File {
 public:
     IH5File(H5::H5File, string, float);
     virtual ~IH5File();
     virtual void init();
+    void setOptions(const OpenOptions& opts){options = opts; dataCache.setMaxBytes(opts.cacheSize);};
+    // cancellation and progress of the reads of the calling thread
+    void setReadControl(ReadControl* control){readControl = control;};
 //    void close();
 
-    virtual string getSectionString(Section);
-    virtual vector<int> getChains(){return chainList;};
+    // reads take the inventory of the chain they read from, the H5 lock is held for H5 calls only
+    virtual string getSectionString(Section sect, int chain);
+    virtual vector<int> getChains();
     virtual int getChain(){return selectedChain;};
     virtual void setChain(int chain);
-    virtual IChainMetaData* getChainMetaData(){return new IChainMetaData(chainAttributes);};
-    virtual IFileMetaData* getFileMetaData(){return new IFileMetaData(rootAttributes);};
-    virtual void chainInventory();
-    virtual vector<MetaData *> getMetaData(Section section, string id, string name);
-    virtual vector<Data*> getData(vector<MetaData*>& mdvec);
-    virtual std::vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill=NoFill);
-    virtual std::vector<Data*> getPreferredData(FillRule fill=NoFill);
+    InventoryPtr getInventory(int chain);
+    bool hasInventory(int chain);
+    virtual IChainMetaData* getChainMetaData(int chain);
+    virtual IFileMetaData* getFileMetaData();
+    virtual vector<MetaData *> getMetaData(const ChainInventory& inventory, Section section, string id, string name);
+    virtual vector<Data*> getData(const ChainInventory& inventory, vector<MetaData*>& mdvec);
+    virtual std::vector<Data*> getJoinedData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fill=NoFill);
+    virtual vector<Data*> getData(const ChainInventory& inventory, vector<MetaData*>& mdvec, const Selection& selection);
+    virtual std::vector<Data*> getJoinedData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fill, const Selection& selection);
+    virtual std::vector<Data*> getJoinedData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fill, TimeAlignment alignment);
+    virtual std::vector<Data*> getPreferredData(const ChainInventory& inventory, FillRule fill=NoFill);
     virtual vector<string> getLogData();
-    virtual string getNameById(Section section, string id);
+    virtual string getNameById(const ChainInventory& inventory, Section section, string id);
+    virtual DataStream* openStream(MetaData* metadata, unsigned int chunkRows);
+    virtual JoinedStream* openJoinedStream(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fill, unsigned int chunkRows);
+    virtual void refresh();
+    virtual ColumnarTable* getColumnarData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fill=NoFill);
+    vector<Data*> getBatchData(const BatchSelection& selection);
+    bool warmCache(const ChainInventory& inventory);
+    int chainOf(MetaData* metadata);
+    int chainOf(vector<MetaData*>& mdvec);
 
 
 protected:
-    virtual Data* getData(MetaData* );
+    virtual Data* getData(const ChainInventory& inventory, MetaData* );
+    Data* getSelectedData(const ChainInventory& inventory, IMetaData* mdata, const ReadSelection& selection);
+    vector<Data*> joinData(const ChainInventory& inventory, vector<MetaData*>& mdvec, FillRule fill, const Selection* selection);
     string filename;
     float h5version;
-    int selectedChain;
+    atomic<int> selectedChain;  // chain of the calls without a chain
     bool isOpen;
-    void readDataArray(IData* data);
-    void readDataPCOneCol(IData* data);
-    void readDataPCTwoCol(IData* data);
-    void copyAndFill(IData *srcdata,eve::DataType srctype, int srccol, IData *dstdata, eve::DataType dsttype, int dstcol, vector<int> excl=vector<int>());
-    virtual void addExtensionData(IData* data);
+    bool deferred;          // datasets not listed yet (OpenOptions::deferInventory)
+    void checkCancelled(){if ((readControl != NULL) && readControl->cancelled) throw ReadCancelled();};
+    void readDataArray(IData* data, const ReadSelection* selection=NULL);
+    void readDataPCOneCol(IData* data, const ReadSelection* selection=NULL);
+    void readDataPCTwoCol(IData* data, const ReadSelection* selection=NULL);
+    void readCached(IData* data, void (IH5File::*load)(IData*));
+    void shareColumns(IData* source, IData* data);
+    void loadDataArray(IData* data){loadDataArray(data, NULL);};
+    void loadDataArray(IData* data, const ReadSelection* selection);
+    void loadSelectedPC(IData* data, const ReadSelection& selection, bool twoColumns);
+    void fetchSelectedPC(IData* data, const ReadSelection& selection, bool twoColumns, RawRecords& raw);
+    void loadDataPCOneCol(IData* data);
+    void loadDataPCTwoCol(IData* data);
+    bool fetchPCOneCol(IData* data, RawRecords& raw);
+    bool fetchPCTwoCol(IData* data, RawRecords& raw);
+    void openPCOneCol(IData* data, DataSet& h5dset, H5::DataType& h5dtype, size_t& element_size, hsize_t& rows);
+    void openPCTwoCol(IData* data, DataSet& h5dset, H5::DataType& h5dtype, size_t& element_size, hsize_t& rows);
+    static void decodePCOneCol(IData* data, RawRecords& raw);
+    static void decodePCTwoCol(IData* data, RawRecords& raw);
+    static void addColumns(IData* data, int columns, size_t count);
+    bool mapRecords(DataSet& dset, size_t elementSize, hsize_t count, RawRecords& raw);
+    void readRecords(DataSet& dset, H5::DataType& dtype, size_t elementSize, hsize_t count, RawRecords& raw, string& objname);
+    void readPosCounts(DataSet& h5dset, H5::DataType& h5dtype, hsize_t rows, vector<int>& posCounts, string& objname);
+    void readRows(DataSet& dset, H5::DataType& dtype, size_t elementSize, const vector<hsize_t>& rows, RawRecords& raw, string& objname);
+    // extension datasets of the datasets read by getData, by path + <h5name or id>
+    typedef map<string, vector<IMetaData*>> ExtensionSet;
+    void findExtensions(const ChainInventory& inventory, vector<MetaData*>& mdvec, ExtensionSet& extensions);
+    // datasets fetched by the I/O stage of getDataPipelined, to be decoded by a worker
+    struct PrefetchedData {
+        PrefetchedData() : decode(NULL) {};
+        shared_ptr<IData> loaded;       // already decoded (arrays, member reads, cache hits)
+        RawRecords raw;
+        void (*decode)(IData*, RawRecords&);
+    };
+    typedef map<string, PrefetchedData> PrefetchSet;
+    vector<Data*> getDataPipelined(const ChainInventory& inventory, vector<MetaData*>& mdvec);
+    void prepareDecode(const ChainInventory& inventory, vector<MetaData*>& mdvec);
+    vector<MetaData*> getPreferredMetaData(const ChainInventory& inventory);
+    void prefetchData(const ChainInventory& inventory, IMetaData* mdata, PrefetchSet& fetched, const ExtensionSet& extensions);
+    void prefetch(IMetaData* mdata, PrefetchSet& fetched);
+    static thread_local PrefetchSet* workerPrefetch;
+    void readMember(DataSet& dset, CompType& filetype, unsigned int member, const PredType& memtype, void* dst, string& objname);
+    void mergePosCounts(vector<int>& merged, const vector<int>& posCounts);
+    void copyAndFill(IData *srcdata,eve::DataType srctype, int srccol, IData *dstdata, eve::DataType dsttype, int dstcol, const vector<int>& excl=vector<int>());
+    virtual void addExtensionData(const ChainInventory& inventory, IData* data, const ReadSelection* selection=NULL);
+    IMetaData* findNormalized(const ChainInventory& inventory, const string& id);
+    shared_ptr<IData> readExtension(const ChainInventory& inventory, const string& fullh5name, bool twoColumns, const ReadSelection* selection);
     void openGroup(Group& h5group, string path);
     void closeGroup(Group& h5group);
     virtual bool isChainSection(string);
     virtual bool isCalc(string);
     virtual bool isNormalization(string);
-    vector<MetaData *> getMetaData(vector<IMetaData *> *devlist, string path, string id, string name);
-    virtual MetaData* findMetaData(vector<IMetaData *> &mdlist, string);
+    vector<MetaData *> getMetaData(const MetaDataIndex& index, string path, string id, string name);
+    virtual MetaData* findMetaData(const MetaDataIndex& index, string);
+    void resolveSection(const MetaDataIndex& index, const string& prefix);
+    vector<pair<string, H5G_obj_t>> getObjects(Group& group);
     virtual vector<string> getGroups(Group& group);
     virtual vector<int> getNumberGroups(Group& group);
-    virtual void parseDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section);
-    virtual void parseGroupDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section);
+    virtual void parseDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section, ChainInventory& inventory, bool namesOnly);
+    virtual void parseGroupDatasets(Group& group, string prefix, vector<IMetaData*>& imeta, string calctype, Section section, bool namesOnly);
+    void setArrayDataType(Group& dsgroup, IMetaData* dinfo);
+    void resolveMetaData(IMetaData* mdata);
+    // inventoryMutex held by the callers of these
+    bool haveChain(int chain);
+    InventoryPtr findInventory(int chain);
+    bool loadInventory();
+    void saveInventory();
+    shared_ptr<ChainInventory> readMonitors(bool namesOnly);
+    shared_ptr<ChainInventory> readChain(int chain, bool namesOnly);
+    map<string, string> readChainAttributes(int chain);
+    InventoryPtr refreshInventory(const ChainInventory& previous);
+    void parseChain(Group& chain, string path, ChainInventory& inventory, bool namesOnly);
+    void mergeInventory(const vector<IMetaData*>& known, vector<IMetaData*>& found, bool lazy);
+    void updateDimensions(IMetaData* mdata);
+    void refreshCache();
     map<string, string> getH5Attributes(H5Object &);
     bool haveGroupWithName(Group& group, string name);
-    string getNameById(vector<IMetaData *> *devlist, string path, string id);
+    string getNameById(const MetaDataIndex& index, string path, string id);
     H5File h5file;
-    IMetaData* timestampMeta;
-    string chainTSfullname;
+    OpenOptions options;    // set once by setOptions() before init()
+    string chainTSname;
     set<string> sections;
     set<string> calculations;
     set<string> normalizations;
-    vector<IMetaData*> chainmeta;
-    vector<IMetaData*> extensionmeta;
-    vector<IMetaData*> monitormeta;
+    // chainList, rootAttributes, chainCache and deferred are guarded by inventoryMutex,
+    // it is taken before the H5 lock
     vector<int> chainList;
     map<string, string> rootAttributes;
-    map<string, string> chainAttributes;
+    map<int, InventoryPtr> chainCache;
+    mutex inventoryMutex;
+    DataCache dataCache;
+    mutex cacheMutex;
+    static thread_local ReadControl* readControl;
 };
 
 } // namespace end
@@ -13,8 +13,8 @@
 
 namespace eve {
 
-IMetaData::IMetaData() : datatype(DTunknown), devtype(Unknown),
-    dstype(EVEDSTUnknown)
+IMetaData::IMetaData() : attributes(make_shared<const map<string, string>>()), datatype(DTunknown), devtype(Unknown),
+    dstype(EVEDSTUnknown), resolved(true)
 {
     dim0 = 0;
     dim1 = 0;
@@ -26,7 +26,7 @@ IMetaData::IMetaData() : datatype(DTunknown), devtype(Unknown),
 }
 
 IMetaData::IMetaData(string basep, string calc, string h5n, Section section, map<string, string> attrib)
-    : selSection(section), path(basep), calculation(calc), h5name(h5n), attributes(attrib)
+    : selSection(section), path(basep), calculation(calc), h5name(h5n), resolved(true)
 {
 
     dim0 = 0;
@@ -36,6 +36,19 @@ IMetaData::IMetaData(string basep, string calc, string h5n, Section section, map
     datatype = DTunknown;
     devtype = Unknown;
     dstype = EVEDSTUnknown;
+    setAttributes(attrib);
+}
+
+// set attributes and all members derived from attributes
+void IMetaData::setAttributes(map<string, string> attrib){
+
+    attributes = make_shared<const map<string, string>>(attrib);
+    const map<string, string>& attributes = *this->attributes;
+    xmlId.clear();
+    channelId.clear();
+    normalizeId.clear();
+    name.clear();
+    devtype = Unknown;
 
     if (attributes.count("axis") > 0)
         xmlId = attributes.find("axis")->second;
@@ -65,6 +78,27 @@ IMetaData::IMetaData(string basep, string calc, string h5n, Section section, map
 
 }
 
+// allocations carry the arena they belong to, memory of arena objects is released with the arena
+void* IMetaData::operator new(size_t size){
+    return operator new(size, NULL);
+}
+
+void* IMetaData::operator new(size_t size, ResultArena* arena){
+    char* block = (arena != NULL) ? (char*)arena->allocate(size + RESULTARENAHEADER) : (char*)::operator new(size + RESULTARENAHEADER);
+    *(ResultArena**)block = arena;
+    return block + RESULTARENAHEADER;
+}
+
+void IMetaData::operator delete(void* ptr){
+    if (ptr == NULL) return;
+    char* block = (char*)ptr - RESULTARENAHEADER;
+    if (*(ResultArena**)block == NULL) ::operator delete(block);
+}
+
+void IMetaData::operator delete(void* ptr, ResultArena*){
+    operator delete(ptr);
+}
+
 string IMetaData::getFQH5Name(){
 
     string calcstring = "";
@@ -74,6 +108,7 @@ string IMetaData::getFQH5Name(){
 
 string IMetaData::getUnit(){
 
+    const map<string, string>& attributes = *this->attributes;
     if (attributes.count("Unit") > 0)
         return attributes.find("Unit")->second;
     else if (attributes.count("unit") > 0)
@@ -93,6 +128,7 @@ DetectorType IMetaData::getDetectorType(){
 string IMetaData::getAttribute(string target, int substrnr){
 
     string retval = "";
+    const map<string, string>& attributes = *this->attributes;
     if (attributes.count(target) > 0) {
         retval = attributes.find(target)->second;
         if (substrnr > 0) {
@@ -4,8 +4,11 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <memory>
+#include <atomic>
 #include "eve.h"
 #include "H5Cpp.h"
+#include "resultarena.h"
 
 #ifndef H5_NO_NAMESPACE
      using namespace H5;
@@ -16,6 +19,20 @@ namespace eve {
 
 enum EVEDatasetType { EVEDSTUnknown, EVEDSTPCOneColumn, EVEDSTPCTwoColumn, EVEDSTArray};
 
+// resolved flag of IMetaData, checked without a lock: an entry of a lazy inventory is
+// resolved by one thread (H5 lock held) while other threads may look it up
+class ResolvedFlag
+{
+public:
+    ResolvedFlag(bool resolved=true) : value(resolved) {};
+    ResolvedFlag(const ResolvedFlag& other) : value(other.value.load()) {};
+    ResolvedFlag& operator=(const ResolvedFlag& other){value = other.value.load(); return *this;};
+    operator bool() const {return value.load();};
+
+private:
+    atomic<bool> value;
+};
+
 class IMetaData : public MetaData
 {
 public:
@@ -34,18 +51,24 @@ public:
     virtual DetectorType getDetectorType();
     virtual DeviceType getDeviceType(){return devtype;};
     virtual eve::DataType getDataType(){return datatype;};
+    static void* operator new(size_t size);
+    static void* operator new(size_t size, ResultArena* arena);
+    static void operator delete(void* ptr);
+    static void operator delete(void* ptr, ResultArena* arena);
 
 protected:
     virtual string getPath(){return path;};
     virtual string getH5name(){return h5name;};
     virtual string getFQH5Name();
     void setDataType(DataSet& ds);
+    void setAttributes(map<string, string> attrib);
     virtual string getAttribute(string, int);
     Section selSection;
     string path;
     string calculation;
     string h5name;
-    map<string, string> attributes;
+    // shared by all copies of the metadata, replaced by setAttributes
+    shared_ptr<const map<string, string>> attributes;
     string name;
     string xmlId;
     string channelId;
@@ -56,9 +79,13 @@ protected:
     hsize_t dim0; // Anzahl der PosCounts
     hsize_t dim1; // > 1 bei arrayData und EVEDSTPCTwoColumn
     hsize_t h5dimensions[2];
+    ResolvedFlag resolved; // false, if attributes and datatype are not yet read (lazy inventory)
 
     friend class IH5File;
     friend class IH5FileV5;
+    friend class MetaDataIndex;
+    friend class IDataStream;
+    friend class InventoryFile;
 };
 } // namespace end
 
@@ -0,0 +1,346 @@
+// Benchmark of the EVE data interface: writes synthetic EVEH5 files (versions 2 - 5) and
+// times opening, inventory, getData, getJoinedData and getPreferredData on them.
+// The statistics of the calls (see DataFile::setStatsCallback) are reported with the times.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "H5Cpp.h"
+#include "eve.h"
+
+using namespace std;
+using namespace eve;
+
+// size of the generated files
+struct FileShape {
+    FileShape() : chains(1), channels(8), posRefs(100000), arrays(0), arrayWidth(1024), arrayRows(100), duplicates(0) {};
+    int chains;
+    int channels;       // one column channels, int and double alternating
+    int posRefs;        // rows of the axis
+    int arrays;         // array channels
+    int arrayWidth;     // values of each array
+    int arrayRows;      // arrays of each array channel (at the first posRefs)
+    int duplicates;     // every n-th row of a channel repeats the posRef of the row before (0: none)
+};
+
+// totals of the calls of one step
+struct StepStats {
+    StepStats() : seconds(0.0), bytesRead(0), datasetsOpened(0), allocations(0) {};
+    double seconds;
+    size_t bytesRead;
+    size_t datasetsOpened;
+    size_t allocations;
+};
+
+#pragma pack(push, 1)
+struct IntRecord {int posCount; int value;};
+struct DoubleRecord {int posCount; double value;};
+struct CountRecord {int posCount; int count; int attempts;};
+struct MonitorRecord {int mSecs; double value;};
+#pragma pack(pop)
+
+static void writeAttribute(H5::H5Object& object, const string& name, const string& value){
+    H5::StrType strtype(H5::PredType::C_S1, value.size() + 1);
+    H5::Attribute attribute = object.createAttribute(name, strtype, H5::DataSpace(H5S_SCALAR));
+    attribute.write(strtype, value.c_str());
+}
+
+static void writeDevice(H5::H5Object& object, const string& id, const string& type){
+    writeAttribute(object, "XML-ID", id);
+    writeAttribute(object, "Name", id + " name");
+    writeAttribute(object, "DeviceType", type);
+    writeAttribute(object, "unit", "mm");
+}
+
+template <typename Record>
+static void writeRecords(H5::Group& group, const string& name, const H5::CompType& type, const vector<Record>& records){
+    hsize_t count = records.size();
+    H5::DataSet dataset = group.createDataSet(name, type, H5::DataSpace(1, &count));
+    dataset.write(records.data(), type);
+}
+
+// posRefs of a channel: 1..posRefs, with duplicates
+static vector<int> channelPosRefs(const FileShape& shape){
+    vector<int> posRefs;
+    for (int posRef = 1; posRef <= shape.posRefs; ++posRef){
+        posRefs.push_back(posRef);
+        if ((shape.duplicates > 0) && (posRef % shape.duplicates == 0)) posRefs.push_back(posRef);
+    }
+    return posRefs;
+}
+
+static void writeFile(const string& filename, int version, const FileShape& shape){
+
+    H5::CompType inttype(sizeof(IntRecord));
+    inttype.insertMember("PosCounter", HOFFSET(IntRecord, posCount), H5::PredType::NATIVE_INT);
+    inttype.insertMember("value", HOFFSET(IntRecord, value), H5::PredType::NATIVE_INT);
+    H5::CompType dbltype(sizeof(DoubleRecord));
+    dbltype.insertMember("PosCounter", HOFFSET(DoubleRecord, posCount), H5::PredType::NATIVE_INT);
+    dbltype.insertMember("value", HOFFSET(DoubleRecord, value), H5::PredType::NATIVE_DOUBLE);
+    H5::CompType counttype(sizeof(CountRecord));
+    counttype.insertMember("PosCounter", HOFFSET(CountRecord, posCount), H5::PredType::NATIVE_INT);
+    counttype.insertMember("count", HOFFSET(CountRecord, count), H5::PredType::NATIVE_INT);
+    counttype.insertMember("attempts", HOFFSET(CountRecord, attempts), H5::PredType::NATIVE_INT);
+    H5::CompType montype(sizeof(MonitorRecord));
+    montype.insertMember("mSecsSinceStart", HOFFSET(MonitorRecord, mSecs), H5::PredType::NATIVE_INT);
+    montype.insertMember("value", HOFFSET(MonitorRecord, value), H5::PredType::NATIVE_DOUBLE);
+
+    H5::H5File file(filename, H5F_ACC_TRUNC);
+    H5::Group root = file.openGroup("/");
+    writeAttribute(root, "EVEH5Version", to_string(version) + ".0");
+    writeAttribute(root, "Location", "eveh5bench");
+    writeAttribute(root, "Version", "1.0");
+
+    // section names changed with version 4
+    string standard = (version >= 4) ? "main" : "default";
+
+    vector<int> posRefs = channelPosRefs(shape);
+    for (int chain = 1; chain <= shape.chains; ++chain){
+        string chainpath = "/c" + to_string(chain);
+        H5::Group chaingroup = file.createGroup(chainpath);
+        writeAttribute(chaingroup, "preferredAxis", "axis1");
+        writeAttribute(chaingroup, "preferredChannel", "channel1");
+        H5::Group section = file.createGroup(chainpath + "/" + standard);
+        H5::Group meta = file.createGroup(chainpath + "/meta");
+        H5::Group average = file.createGroup(chainpath + "/" + standard + "/averagemeta");
+
+        vector<DoubleRecord> axis(shape.posRefs);
+        vector<IntRecord> timer(shape.posRefs);
+        for (int row = 0; row < shape.posRefs; ++row){
+            axis[row] = {row + 1, 0.5 * row};
+            timer[row] = {row + 1, 10 * row};
+        }
+        writeRecords(section, "axis1", dbltype, axis);
+        H5::DataSet axisset = section.openDataSet("axis1");
+        writeDevice(axisset, "axis1", "Axis");
+        writeRecords(meta, "PosCountTimer", inttype, timer);
+
+        for (int channel = 1; channel <= shape.channels; ++channel){
+            string id = "channel" + to_string(channel);
+            if (channel % 2){
+                vector<IntRecord> records(posRefs.size());
+                for (size_t row = 0; row < posRefs.size(); ++row) records[row] = {posRefs[row], (int)row * channel};
+                writeRecords(section, id, inttype, records);
+            }
+            else {
+                vector<DoubleRecord> records(posRefs.size());
+                for (size_t row = 0; row < posRefs.size(); ++row) records[row] = {posRefs[row], 0.25 * row * channel};
+                writeRecords(section, id, dbltype, records);
+            }
+            H5::DataSet channelset = section.openDataSet(id);
+            writeDevice(channelset, id, "Channel");
+        }
+        if (shape.channels > 0){
+            vector<CountRecord> counts(shape.posRefs);
+            for (int row = 0; row < shape.posRefs; ++row) counts[row] = {row + 1, 3, 5};
+            writeRecords(average, "channel1__AverageCount", counttype, counts);
+        }
+
+        // array channels: a group with one dataset per posRef
+        hsize_t width = shape.arrayWidth;
+        vector<double> values(width);
+        for (int array = 1; array <= shape.arrays; ++array){
+            string id = "array" + to_string(array);
+            H5::Group arraygroup = file.createGroup(chainpath + "/" + standard + "/" + id);
+            writeDevice(arraygroup, id, "Channel");
+            for (int posRef = 1; posRef <= min(shape.arrayRows, shape.posRefs); ++posRef){
+                for (hsize_t i = 0; i < width; ++i) values[i] = posRef + 0.001 * i;
+                H5::DataSet arrayset = arraygroup.createDataSet(to_string(posRef), H5::PredType::NATIVE_DOUBLE, H5::DataSpace(1, &width));
+                arrayset.write(values.data(), H5::PredType::NATIVE_DOUBLE);
+            }
+        }
+    }
+
+    H5::Group devices = file.createGroup("/device");
+    vector<MonitorRecord> monitor(100);
+    for (int row = 0; row < 100; ++row) monitor[row] = {1000 * row, 20.0 + 0.01 * row};
+    writeRecords(devices, "monitor1", montype, monitor);
+    H5::DataSet monitorset = devices.openDataSet("monitor1");
+    writeDevice(monitorset, "monitor1", "Monitor");
+}
+
+static void deleteAll(vector<MetaData*>& metadata){
+    for (MetaData* mdata : metadata) delete mdata;
+    metadata.clear();
+}
+
+static void deleteAll(vector<Data*> data){
+    for (Data* item : data) delete item;
+}
+
+static void printStep(int version, const string& step, const StepStats& stats){
+    cout << "v" << version << "  " << left << setw(12) << step << right
+         << setw(10) << fixed << setprecision(2) << stats.seconds * 1000.0 << " ms"
+         << setw(14) << stats.bytesRead << " bytes"
+         << setw(8) << stats.datasetsOpened << " datasets"
+         << setw(8) << stats.allocations << " allocations" << endl;
+}
+
+// time the steps on one file, the fastest of repeat runs is reported
+static void runFile(const string& filename, int version, const OpenOptions& options, int repeat){
+
+    vector<string> steps = {"open", "inventory", "getData", "joined", "preferred"};
+    vector<StepStats> best(steps.size());
+    for (int run = 0; run < repeat; ++run){
+        vector<StepStats> current(steps.size());
+        StepStats* step = NULL;
+        // calls between the steps are not counted
+        StatsCallback collect = [&](const CallStats& stats){
+            if (step == NULL) return;
+            step->bytesRead += stats.bytesRead;
+            step->datasetsOpened += stats.datasetsOpened;
+            step->allocations += stats.allocations;
+        };
+
+        // the callback of the options also counts the inventory read by the constructor
+        OpenOptions counted = options;
+        counted.statsCallback = collect;
+        step = &current[0];
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        DataFile* file = DataFile::openFile(filename, counted);
+        current[0].seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        // inventory of all chains, monitors and the timestamps
+        step = &current[1];
+        start = chrono::steady_clock::now();
+        vector<MetaData*> metadata;
+        for (int chain : file->getChains()){
+            file->setChain(chain);
+            metadata = file->getMetaData(Standard, "", "");
+            deleteAll(metadata);
+            metadata = file->getMetaData(Timestamp, "", "");
+            deleteAll(metadata);
+        }
+        metadata = file->getMetaData(Monitor, "", "");
+        deleteAll(metadata);
+        file->setChain(1);
+        step->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        step = NULL;
+
+        // all datasets of chain 1, the scalar ones are joined
+        vector<MetaData*> standard = file->getMetaData(Standard, "", "");
+        vector<MetaData*> scalar;
+        for (MetaData* mdata : standard)
+            if (mdata->getDimension().second <= 1) scalar.push_back(mdata);
+
+        step = &current[2];
+        start = chrono::steady_clock::now();
+        deleteAll(file->getData(standard));
+        step->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        step = &current[3];
+        start = chrono::steady_clock::now();
+        deleteAll(file->getJoinedData(scalar, LastFill));
+        step->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        step = &current[4];
+        start = chrono::steady_clock::now();
+        deleteAll(file->getPreferredData(LastFill));
+        step->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        step = NULL;
+
+        deleteAll(standard);
+        file->setStatsCallback(StatsCallback());
+        delete file;
+        for (size_t i = 0; i < steps.size(); ++i)
+            if ((run == 0) || (current[i].seconds < best[i].seconds)) best[i] = current[i];
+    }
+    for (size_t i = 0; i < steps.size(); ++i) printStep(version, steps[i], best[i]);
+}
+
+static void usage(const char* program){
+    cerr << "usage: " << program << " [options]\n"
+         << "  --versions 2,3,4,5   EVEH5 versions of the generated files\n"
+         << "  --chains n           chains of each file (1)\n"
+         << "  --channels n         one column channels (8)\n"
+         << "  --posrefs n          posRefs of the axis (100000)\n"
+         << "  --arrays n           array channels (0)\n"
+         << "  --width n            values of each array (1024)\n"
+         << "  --arrayrows n        arrays of each array channel (100)\n"
+         << "  --duplicates n       every n-th channel row repeats a posRef (0: none)\n"
+         << "  --repeat n           runs of each file, the fastest is reported (3)\n"
+         << "  --dir path           directory of the generated files (/tmp)\n"
+         << "  --keep               keep the generated files\n"
+         << "  --lazy --member --mapped --cache bytes --threads n\n"
+         << "                       open options (see OpenOptions)\n";
+}
+
+int main(int argc, char* argv[]){
+
+    FileShape shape;
+    OpenOptions options;
+    vector<int> versions = {2, 3, 4, 5};
+    int repeat = 3;
+    string dir = "/tmp";
+    bool keep = false;
+
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--help"){
+            usage(argv[0]);
+            return 0;
+        }
+        else if (arg == "--keep") keep = true;
+        else if (arg == "--lazy") options.lazyInventory = true;
+        else if (arg == "--member") options.memberReads = true;
+        else if (arg == "--mapped") options.mappedReads = true;
+        else if (!hasValue){
+            usage(argv[0]);
+            return 1;
+        }
+        else if (arg == "--versions"){
+            versions.clear();
+            stringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ',')) versions.push_back(atoi(item.c_str()));
+        }
+        else if (arg == "--chains") shape.chains = atoi(argv[++i]);
+        else if (arg == "--channels") shape.channels = atoi(argv[++i]);
+        else if (arg == "--posrefs") shape.posRefs = atoi(argv[++i]);
+        else if (arg == "--arrays") shape.arrays = atoi(argv[++i]);
+        else if (arg == "--width") shape.arrayWidth = atoi(argv[++i]);
+        else if (arg == "--arrayrows") shape.arrayRows = atoi(argv[++i]);
+        else if (arg == "--duplicates") shape.duplicates = atoi(argv[++i]);
+        else if (arg == "--repeat") repeat = max(1, atoi(argv[++i]));
+        else if (arg == "--dir") dir = argv[++i];
+        else if (arg == "--cache") options.cacheSize = strtoull(argv[++i], NULL, 10);
+        else if (arg == "--threads") options.decodeThreads = atoi(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    H5::Exception::dontPrint();
+    for (int version : versions){
+        if ((version < 2) || (version > 5)){
+            cerr << "unsupported version " << version << endl;
+            return 1;
+        }
+        string filename = dir + "/eveh5bench-v" + to_string(version) + ".h5";
+        try {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            writeFile(filename, version, shape);
+            cout << "v" << version << "  generated " << filename << " in " << fixed << setprecision(0)
+                 << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+            runFile(filename, version, options, repeat);
+        }
+        catch (H5::Exception& error){
+            cerr << "H5 error: " << error.getDetailMsg() << endl;
+            return 1;
+        }
+        catch (exception& error){
+            cerr << "error: " << error.what() << endl;
+            return 1;
+        }
+        if (!keep) remove(filename.c_str());
+    }
+    return 0;
+}
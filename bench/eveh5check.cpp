@@ -0,0 +1,641 @@
+// Checks of the EVE data interface on random EVEH5 files, exits with 1 if a check fails:
+//   join     getJoinedData against a reference join with the rules of the IData join
+//            constructor before it computed a join index (rescans of the posRefs)
+//   stream   the blocks of openJoinedStream against getJoinedData
+//   threads  reads of several threads of one file while another thread refreshes it and
+//            selects chains, with and without lazy inventory and decode threads, and a FileBatch
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <random>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <stdlib.h>
+#include <stdio.h>
+#include <thread>
+#include <atomic>
+#include "H5Cpp.h"
+#include "eve.h"
+
+using namespace std;
+using namespace eve;
+
+#pragma pack(push, 1)
+struct IntRecord {int posCount; int value;};
+struct DoubleRecord {int posCount; double value;};
+#pragma pack(pop)
+
+// a one column dataset of a generated file
+struct Dataset {
+    string id;
+    bool axis;
+    bool integer;
+    vector<int> posRefs;
+    vector<int> ints;
+    vector<double> doubles;
+};
+
+// datasets of one chain, snapshots have the id of their axis
+struct ChainContent {
+    vector<Dataset> standard;
+    vector<Dataset> snapshots;
+};
+
+static void writeAttribute(H5::H5Object& object, const string& name, const string& value){
+    H5::StrType strtype(H5::PredType::C_S1, value.size() + 1);
+    H5::Attribute attribute = object.createAttribute(name, strtype, H5::DataSpace(H5S_SCALAR));
+    attribute.write(strtype, value.c_str());
+}
+
+static void writeDataset(H5::Group& group, const Dataset& dataset){
+    H5::CompType inttype(sizeof(IntRecord));
+    inttype.insertMember("PosCounter", HOFFSET(IntRecord, posCount), H5::PredType::NATIVE_INT);
+    inttype.insertMember("value", HOFFSET(IntRecord, value), H5::PredType::NATIVE_INT);
+    H5::CompType dbltype(sizeof(DoubleRecord));
+    dbltype.insertMember("PosCounter", HOFFSET(DoubleRecord, posCount), H5::PredType::NATIVE_INT);
+    dbltype.insertMember("value", HOFFSET(DoubleRecord, value), H5::PredType::NATIVE_DOUBLE);
+
+    hsize_t count = dataset.posRefs.size();
+    H5::DataSet h5dset;
+    if (dataset.integer){
+        vector<IntRecord> records(count);
+        for (size_t row = 0; row < count; ++row) records[row] = {dataset.posRefs[row], dataset.ints[row]};
+        h5dset = group.createDataSet(dataset.id, inttype, H5::DataSpace(1, &count));
+        h5dset.write(records.data(), inttype);
+    }
+    else {
+        vector<DoubleRecord> records(count);
+        for (size_t row = 0; row < count; ++row) records[row] = {dataset.posRefs[row], dataset.doubles[row]};
+        h5dset = group.createDataSet(dataset.id, dbltype, H5::DataSpace(1, &count));
+        h5dset.write(records.data(), dbltype);
+    }
+    writeAttribute(h5dset, "XML-ID", dataset.id);
+    writeAttribute(h5dset, "Name", dataset.id + " name");
+    writeAttribute(h5dset, "DeviceType", dataset.axis ? "Axis" : "Channel");
+}
+
+static void writeFile(const string& filename, int version, const vector<ChainContent>& chains){
+
+    H5::H5File file(filename, H5F_ACC_TRUNC);
+    H5::Group root = file.openGroup("/");
+    writeAttribute(root, "EVEH5Version", to_string(version) + ".0");
+    writeAttribute(root, "Location", "eveh5check");
+    writeAttribute(root, "Version", "1.0");
+
+    // section names changed with version 4
+    string standard = (version >= 4) ? "main" : "default";
+    string snapshot = (version >= 4) ? "snapshot" : "alternate";
+    for (size_t chain = 0; chain < chains.size(); ++chain){
+        string chainpath = "/c" + to_string(chain + 1);
+        H5::Group chaingroup = file.createGroup(chainpath);
+        writeAttribute(chaingroup, "preferredAxis", chains[chain].standard.front().id);
+        writeAttribute(chaingroup, "preferredChannel", chains[chain].standard.back().id);
+        H5::Group section = file.createGroup(chainpath + "/" + standard);
+        for (const Dataset& dataset : chains[chain].standard) writeDataset(section, dataset);
+        if (!chains[chain].snapshots.empty()){
+            H5::Group snapgroup = file.createGroup(chainpath + "/" + snapshot);
+            for (const Dataset& dataset : chains[chain].snapshots) writeDataset(snapgroup, dataset);
+        }
+    }
+}
+
+// random dataset with rows posRefs out of 1..maxPosRef: ascending, with repeated posRefs
+// if duplicates, with some rows swapped if unsorted
+static Dataset randomDataset(mt19937& random, const string& id, bool axis, int maxPosRef, bool duplicates, bool unsorted){
+    Dataset dataset;
+    dataset.id = id;
+    dataset.axis = axis;
+    dataset.integer = (random() % 2) == 0;
+    int density = 1 + random() % 4;
+    for (int posRef = 1; posRef <= maxPosRef; ++posRef){
+        if ((random() % density) != 0) continue;
+        dataset.posRefs.push_back(posRef);
+        if (duplicates && ((random() % 5) == 0)) dataset.posRefs.push_back(posRef);
+    }
+    if (dataset.posRefs.empty()) dataset.posRefs.push_back(1 + random() % maxPosRef);
+    if (unsorted)
+        for (size_t swaps = random() % 4; swaps > 0; --swaps)
+            swap(dataset.posRefs[random() % dataset.posRefs.size()], dataset.posRefs[random() % dataset.posRefs.size()]);
+    for (size_t row = 0; row < dataset.posRefs.size(); ++row){
+        dataset.ints.push_back((int)(random() % 2001) - 1000);
+        dataset.doubles.push_back((double)((int)(random() % 20001) - 10000) / 8.0);
+    }
+    return dataset;
+}
+
+// axes and channels of a chain, snapshots for some of the axes
+static ChainContent randomChain(mt19937& random, bool duplicates, bool unsorted){
+    ChainContent content;
+    int maxPosRef = 1 + random() % 60;
+    int axes = 1 + random() % 3;
+    int channels = 1 + random() % 4;
+    for (int axis = 1; axis <= axes; ++axis){
+        content.standard.push_back(randomDataset(random, "axis" + to_string(axis), true, maxPosRef, duplicates, unsorted));
+        if ((random() % 2) == 0){
+            Dataset snapshot = randomDataset(random, "axis" + to_string(axis), true, 3, false, false);
+            for (int& posRef : snapshot.posRefs) posRef -= 1;
+            content.snapshots.push_back(snapshot);
+        }
+    }
+    for (int channel = 1; channel <= channels; ++channel)
+        content.standard.push_back(randomDataset(random, "channel" + to_string(channel), false, maxPosRef, duplicates, unsorted));
+    return content;
+}
+
+// a joined column: value and validity of each row
+template <typename T>
+struct Column {
+    vector<T> values;
+    vector<char> valid;
+};
+
+// join of a one column dataset with the rules of the join constructor before the join index:
+// a value per posRef or a missing row; with dofill an axis fills missing rows with its last value
+// (from the snapshot before the first posRef at the start), duplicate posRefs of an axis take the last row
+template <typename T>
+static Column<T> referenceJoin(const vector<int>& posCounts, const vector<T>& values, const vector<int>& posrefs,
+                               bool axis, bool dofill, bool hasStart, T start, T missing){
+    Column<T> column;
+    T last = hasStart ? start : missing;
+    bool lastValid = hasStart;
+    set<int> dPosCounts(posCounts.begin(), posCounts.end());
+    set<int> doublePosCounts;
+    if (axis && (dPosCounts.size() != posCounts.size())){
+        set<int> dPC = dPosCounts;
+        for (int newpc : posCounts)
+            if (dPC.erase(newpc) != 1) doublePosCounts.insert(newpc);
+    }
+    // last row of posCount (doublePosRef workaround)
+    auto lastRow = [&](int posCount){
+        for (int dindex = posCounts.size() - 1; dindex >= 0; --dindex)
+            if (posCounts[dindex] == posCount) return (size_t)dindex;
+        return (size_t)0;
+    };
+
+    size_t idx = 0;
+    size_t lastIdx = posCounts.size() - 1;
+    bool doLast = false;
+    for (int newpc : posrefs){
+        bool skippedValues = false;
+        while ((posCounts[idx] < newpc) && (idx < lastIdx)){
+            ++idx;
+            skippedValues = true;
+            if (idx == lastIdx) doLast = true;
+        }
+        if (dofill && (skippedValues || (doLast && (posCounts[idx] < newpc)))){
+            size_t fillIdx = idx;
+            if (skippedValues)
+                fillIdx = idx - 1;
+            else
+                doLast = false;
+            if (doublePosCounts.count(posCounts[idx]) > 0) fillIdx = lastRow(posCounts[idx]);
+            last = values[fillIdx];
+            lastValid = true;
+        }
+
+        size_t source = posCounts.size();
+        if (doublePosCounts.count(newpc) > 0)
+            source = lastRow(newpc);
+        else if (posCounts[idx] == newpc){
+            source = idx;
+            if (idx < lastIdx){
+                ++idx;
+                if (idx == lastIdx) doLast = true;
+            }
+        }
+        else if (dPosCounts.count(newpc) > 0)
+            source = find(posCounts.begin(), posCounts.end(), newpc) - posCounts.begin();
+
+        if (source < posCounts.size()){
+            column.values.push_back(values[source]);
+            column.valid.push_back(1);
+            if (dofill){
+                last = values[source];
+                lastValid = true;
+            }
+        }
+        else if (dofill){
+            column.values.push_back(last);
+            column.valid.push_back(lastValid);
+        }
+        else {
+            column.values.push_back(missing);
+            column.valid.push_back(0);
+        }
+    }
+    return column;
+}
+
+static bool sameValue(int a, int b){return a == b;}
+static bool sameValue(double a, double b){return (a == b) || (std::isnan(a) && std::isnan(b));}
+
+// the rows of data match the expected column, the first difference is reported in message
+template <typename T>
+static bool compareColumn(Data* data, const DataView<T>& view, const Column<T>& expected, string& message){
+    if (view.size() != expected.values.size()){
+        message = data->getId() + ": " + to_string(view.size()) + " rows instead of " + to_string(expected.values.size());
+        return false;
+    }
+    for (size_t row = 0; row < view.size(); ++row){
+        if ((data->isValid(row) != (expected.valid[row] != 0)) || (expected.valid[row] && !sameValue(view[row], expected.values[row]))){
+            ostringstream text;
+            text << data->getId() << " row " << row << ": " << view[row] << (data->isValid(row) ? "" : " (invalid)")
+                 << " instead of " << expected.values[row] << (expected.valid[row] ? "" : " (invalid)");
+            message = text.str();
+            return false;
+        }
+    }
+    return true;
+}
+
+// sorted posRefs without repetitions merged into merged
+static void mergePosRefs(vector<int>& merged, vector<int> posRefs){
+    sort(posRefs.begin(), posRefs.end());
+    posRefs.erase(unique(posRefs.begin(), posRefs.end()), posRefs.end());
+    vector<int> result;
+    set_union(merged.begin(), merged.end(), posRefs.begin(), posRefs.end(), back_inserter(result));
+    merged.swap(result);
+}
+
+static const char* fillName(FillRule fill){
+    switch (fill){
+    case NoFill: return "NoFill";
+    case LastFill: return "LastFill";
+    case NANFill: return "NANFill";
+    case LastNANFill: return "LastNANFill";
+    }
+    return "unknown";
+}
+
+// join of a random selection of the datasets of content against the reference join
+static bool checkJoin(DataFile* file, const ChainContent& content, mt19937& random, string& message){
+
+    vector<MetaData*> standard = file->getMetaData(1, Standard, "", "");
+    vector<MetaData*> snapshots = file->getMetaData(1, Snapshot, "", "");
+    vector<MetaData*> selected;
+    for (MetaData* mdata : standard)
+        if ((selected.empty() && (mdata == standard.back())) || ((random() % 3) != 0)) selected.push_back(mdata);
+    vector<MetaData*> request = selected;
+    request.insert(request.end(), snapshots.begin(), snapshots.end());
+    FillRule fill = (FillRule)(random() % 4);
+
+    vector<Data*> joined = file->getJoinedData(request, fill);
+
+    // posRefs of the join
+    vector<int> axisPosRefs;
+    vector<int> channelPosRefs;
+    vector<const Dataset*> datasets;
+    for (MetaData* mdata : selected){
+        for (const Dataset& dataset : content.standard)
+            if (dataset.id == mdata->getId()) datasets.push_back(&dataset);
+        mergePosRefs(datasets.back()->axis ? axisPosRefs : channelPosRefs, datasets.back()->posRefs);
+    }
+    vector<int> posrefs;
+    bool empty = false;
+    if (fill == NoFill){
+        empty = axisPosRefs.empty() || channelPosRefs.empty();
+        set_intersection(axisPosRefs.begin(), axisPosRefs.end(), channelPosRefs.begin(), channelPosRefs.end(), back_inserter(posrefs));
+    }
+    else if (fill == LastFill){
+        empty = channelPosRefs.empty();
+        posrefs = channelPosRefs;
+    }
+    else if (fill == NANFill){
+        empty = axisPosRefs.empty();
+        posrefs = axisPosRefs;
+    }
+    else {
+        posrefs = axisPosRefs;
+        mergePosRefs(posrefs, channelPosRefs);
+    }
+
+    bool same = true;
+    ostringstream prefix;
+    prefix << fillName(fill) << ", " << selected.size() << " datasets: ";
+    if (joined.size() != (empty ? 0 : selected.size())){
+        message = prefix.str() + to_string(joined.size()) + " results";
+        same = false;
+    }
+    for (size_t index = 0; same && (index < joined.size()); ++index){
+        Data* data = joined[index];
+        const Dataset& dataset = *datasets[index];
+        if ((data->getId() != dataset.id) || (data->getPosReferences() != posrefs)){
+            message = prefix.str() + dataset.id + ": other posRefs";
+            same = false;
+            break;
+        }
+        bool dofill = dataset.axis && ((fill == LastFill) || (fill == LastNANFill));
+        // start value from the snapshot row of the last posRef before the first one of the join
+        const Dataset* snapshot = NULL;
+        for (const Dataset& snap : content.snapshots)
+            if ((snap.id == dataset.id) && (snap.integer == dataset.integer)) snapshot = &snap;
+        size_t snapRow = 0;
+        bool hasStart = dofill && (snapshot != NULL) && !posrefs.empty() && (posrefs[0] > snapshot->posRefs[0]);
+        if (hasStart)
+            for (size_t row = 0; row < snapshot->posRefs.size(); ++row)
+                if (posrefs[0] > snapshot->posRefs[row]) snapRow = row;
+        if (dataset.integer){
+            Column<int> expected = referenceJoin<int>(dataset.posRefs, dataset.ints, posrefs, dataset.axis, dofill,
+                                                      hasStart, hasStart ? snapshot->ints[snapRow] : 0, INT_MIN);
+            same = compareColumn<int>(data, data->getIntView(), expected, message);
+        }
+        else {
+            Column<double> expected = referenceJoin<double>(dataset.posRefs, dataset.doubles, posrefs, dataset.axis, dofill,
+                                                            hasStart, hasStart ? snapshot->doubles[snapRow] : 0.0, NAN);
+            same = compareColumn<double>(data, data->getDoubleView(), expected, message);
+        }
+        if (!same) message = prefix.str() + message;
+    }
+
+    for (Data* data : joined) delete data;
+    for (MetaData* mdata : standard) delete mdata;
+    for (MetaData* mdata : snapshots) delete mdata;
+    return same;
+}
+
+// rows of a column of the blocks of a joined stream
+template <typename T>
+static void appendColumn(Data* data, const DataView<T>& view, Column<T>& column){
+    for (size_t row = 0; row < view.size(); ++row){
+        column.values.push_back(view[row]);
+        column.valid.push_back(data->isValid(row));
+    }
+}
+
+// the blocks of a joined stream of a random selection against getJoinedData
+static bool checkStream(DataFile* file, mt19937& random, string& message){
+
+    vector<MetaData*> standard = file->getMetaData(1, Standard, "", "");
+    vector<MetaData*> snapshots = file->getMetaData(1, Snapshot, "", "");
+    vector<MetaData*> request;
+    for (MetaData* mdata : standard)
+        if ((request.empty() && (mdata == standard.back())) || ((random() % 3) != 0)) request.push_back(mdata);
+    for (MetaData* mdata : snapshots)
+        if ((random() % 2) == 0) request.push_back(mdata);
+    FillRule fill = (FillRule)(random() % 4);
+    unsigned int chunkRows = 1 + random() % 20;
+
+    vector<Data*> joined = file->getJoinedData(request, fill);
+    vector<vector<int> > posRefs(joined.size());
+    vector<Column<int> > ints(joined.size());
+    vector<Column<double> > doubles(joined.size());
+    JoinedStream* stream = file->openJoinedStream(request, fill, chunkRows);
+    bool same = true;
+    ostringstream prefix;
+    prefix << fillName(fill) << ", " << request.size() << " datasets, blocks of " << chunkRows << ": ";
+    for (vector<Data*> block = stream->next(); same && !block.empty(); block = stream->next()){
+        if (block.size() != joined.size()){
+            message = to_string(block.size()) + " columns instead of " + to_string(joined.size());
+            same = false;
+        }
+        for (size_t col = 0; same && (col < block.size()); ++col){
+            vector<int> blockRefs = block[col]->getPosReferences();
+            if ((block[col]->getId() != joined[col]->getId()) || (block[col]->getDataType() != joined[col]->getDataType())
+                    || (blockRefs.size() > chunkRows) || blockRefs.empty()){
+                message = block[col]->getId() + ": other column or block size";
+                same = false;
+                break;
+            }
+            posRefs[col].insert(posRefs[col].end(), blockRefs.begin(), blockRefs.end());
+            if (block[col]->getDataType() == DTint32)
+                appendColumn<int>(block[col], block[col]->getIntView(), ints[col]);
+            else
+                appendColumn<double>(block[col], block[col]->getDoubleView(), doubles[col]);
+        }
+        for (Data* data : block) delete data;
+    }
+    delete stream;
+
+    for (size_t col = 0; same && (col < joined.size()); ++col){
+        if (posRefs[col] != joined[col]->getPosReferences()){
+            message = joined[col]->getId() + ": other posRefs";
+            same = false;
+        }
+        else if (joined[col]->getDataType() == DTint32)
+            same = compareColumn<int>(joined[col], joined[col]->getIntView(), ints[col], message);
+        else
+            same = compareColumn<double>(joined[col], joined[col]->getDoubleView(), doubles[col], message);
+    }
+    if (!same) message = prefix.str() + message;
+
+    for (Data* data : joined) delete data;
+    for (MetaData* mdata : standard) delete mdata;
+    for (MetaData* mdata : snapshots) delete mdata;
+    return same;
+}
+
+// reads of a file with 3 chains, the axis values are the number of the chain
+static bool checkThreads(const string& filename, int version, int rounds, string& message){
+
+    vector<ChainContent> chains(3);
+    for (int chain = 1; chain <= 3; ++chain){
+        Dataset axis;
+        axis.id = "axis1";
+        axis.axis = true;
+        axis.integer = false;
+        Dataset channel;
+        channel.id = "channel1";
+        channel.axis = false;
+        channel.integer = true;
+        for (int posRef = 1; posRef <= 10 * chain; ++posRef){
+            axis.posRefs.push_back(posRef);
+            axis.ints.push_back(chain);
+            axis.doubles.push_back(chain);
+            if ((posRef % 2) == 0) continue;
+            channel.posRefs.push_back(posRef);
+            channel.ints.push_back(posRef);
+            channel.doubles.push_back(posRef);
+        }
+        chains[chain - 1].standard = {axis, channel};
+    }
+    writeFile(filename, version, chains);
+
+    ostringstream failures;
+    for (int lazy = 0; lazy < 2; ++lazy){
+        for (int threads = 0; threads <= 2; threads += 2){
+            OpenOptions options;
+            options.lazyInventory = lazy;
+            options.decodeThreads = threads;
+            options.cacheSize = threads ? (1 << 20) : 0;
+            options.prefetch = (threads != 0);
+            DataFile* file = DataFile::openFile(filename, options);
+            atomic<int> bad(0);
+            atomic<bool> stop(false);
+            vector<thread> readers;
+            for (int reader = 0; reader < 6; ++reader) readers.push_back(thread([&, reader]{
+                int chain = reader % 3 + 1;
+                for (int round = 0; round < rounds; ++round){
+                    try {
+                        vector<MetaData*> mdata = file->getMetaData(chain, Standard, "", "");
+                        if (mdata.size() != 2){
+                            ++bad;
+                            for (MetaData* md : mdata) delete md;
+                            continue;
+                        }
+                        Selection selection;
+                        selection.firstPosRef = 2;
+                        selection.lastPosRef = 5;
+                        bool joined = (round % 2) == 0;
+                        vector<Data*> data = joined ? file->getJoinedData(mdata, LastFill, selection) : file->getData(mdata);
+                        if (data.size() != 2) ++bad;
+                        for (Data* dat : data){
+                            vector<int> posRefs = dat->getPosReferences();
+                            if (joined && (posRefs != vector<int>{3, 5})) ++bad;
+                            if (!joined && (posRefs.size() != (size_t)((dat->getId() == "axis1") ? 10 * chain : 5 * chain))) ++bad;
+                            if (dat->getId() == "axis1"){
+                                DataView<double> values = dat->getDoubleView();
+                                for (size_t row = 0; row < values.size(); ++row)
+                                    if (values[row] != chain) ++bad;
+                            }
+                            delete dat;
+                        }
+                        if (file->getNameById(chain, Standard, "axis1") != "axis1 name") ++bad;
+                        for (MetaData* md : mdata) delete md;
+                    }
+                    catch (exception&){
+                        ++bad;
+                    }
+                }
+            }));
+            thread other([&]{
+                mt19937 random(lazy * 2 + threads);
+                while (!stop){
+                    try {
+                        file->refresh();
+                        file->setChain(1 + random() % 3);
+                        vector<Data*> data = file->getPreferredData(LastFill);
+                        if (data.size() != 2) ++bad;
+                        for (Data* dat : data) delete dat;
+                    }
+                    catch (exception&){
+                        ++bad;
+                    }
+                }
+            });
+            for (thread& reader : readers) reader.join();
+            stop = true;
+            other.join();
+            delete file;
+            if (bad) failures << " lazy " << lazy << " threads " << threads << ": " << bad << " bad reads";
+        }
+    }
+
+    BatchSelection selection;
+    selection.chain = 2;
+    selection.preferred = true;
+    FileBatch* batch = FileBatch::open(vector<string>(8, filename), selection, OpenOptions(), 4);
+    BatchResult result;
+    int files = 0;
+    int bad = 0;
+    while (batch->next(result)){
+        ++files;
+        if (!result.error.empty() || (result.data.size() != 2)) ++bad;
+        for (Data* dat : result.data) delete dat;
+    }
+    delete batch;
+    if (bad || (files != 8)) failures << " batch: " << files << " files, " << bad << " bad";
+
+    message = failures.str();
+    return message.empty();
+}
+
+static void usage(const char* program){
+    cerr << "usage: " << program << " [options]\n"
+         << "  --checks join,stream,threads checks to run\n"
+         << "  --rounds n           random files of each check, reads of each thread (500)\n"
+         << "  --seed n             seed of the random files (1)\n"
+         << "  --dir path           directory of the generated files (/tmp)\n"
+         << "  --keep               keep the file of a failed round\n";
+}
+
+int main(int argc, char* argv[]){
+
+    set<string> checks = {"join", "stream", "threads"};
+    int rounds = 500;
+    unsigned int seed = 1;
+    string dir = "/tmp";
+    bool keep = false;
+
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--help"){
+            usage(argv[0]);
+            return 0;
+        }
+        else if (arg == "--keep") keep = true;
+        else if (!hasValue){
+            usage(argv[0]);
+            return 1;
+        }
+        else if (arg == "--checks"){
+            checks.clear();
+            stringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ',')) checks.insert(item);
+        }
+        else if (arg == "--rounds") rounds = max(1, atoi(argv[++i]));
+        else if (arg == "--seed") seed = strtoul(argv[++i], NULL, 10);
+        else if (arg == "--dir") dir = argv[++i];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    H5::Exception::dontPrint();
+    string filename = dir + "/eveh5check.h5";
+    mt19937 random(seed);
+    int failed = 0;
+    for (const string& check : checks){
+        if ((check != "join") && (check != "stream") && (check != "threads")){
+            cerr << "unknown check " << check << endl;
+            return 1;
+        }
+        int round = 0;
+        string message;
+        try {
+            if (check == "threads"){
+                int version = 2 + random() % 4;
+                if (!checkThreads(filename, version, rounds, message)) message = "v" + to_string(version) + message;
+                round = rounds;
+            }
+            for (; round < rounds; ++round){
+                int version = 2 + random() % 4;
+                // a stream needs ascending posRefs
+                bool unsorted = (check == "join") && ((random() % 4) == 0);
+                vector<ChainContent> chains = {randomChain(random, (random() % 2) == 0, unsorted)};
+                writeFile(filename, version, chains);
+                DataFile* file = DataFile::openFile(filename);
+                bool same;
+                if (check == "join")
+                    same = checkJoin(file, chains[0], random, message);
+                else
+                    same = checkStream(file, random, message);
+                delete file;
+                if (!same){
+                    message = "v" + to_string(version) + " " + message;
+                    break;
+                }
+            }
+        }
+        catch (H5::Exception& error){
+            message = "H5 error: " + error.getDetailMsg();
+        }
+        catch (exception& error){
+            message = string("error: ") + error.what();
+        }
+        if (message.empty())
+            cout << check << ": " << rounds << " rounds passed" << endl;
+        else {
+            cout << check << ": round " << round << " failed (seed " << seed << "), " << message << endl;
+            ++failed;
+        }
+        if (message.empty() || !keep) remove(filename.c_str());
+    }
+    return failed ? 1 : 0;
+}
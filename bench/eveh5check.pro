@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Checks of the EVE data interface on random files, build eveH5 first
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = eveh5check
+TEMPLATE = app
+
+CONFIG += console thread
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -std=c++11
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    eveh5check.cpp
+
+LIBS += -L.. -leveH5
+
+linux-g++-64 {
+    LIBS +=  -L/home/eden/src/hdf5/hdf5-1.10.1-gcc7/hdf5/lib64
+}
+
+unix:INCLUDEPATH += /home/eden/src/hdf5/hdf5-1.10.1-gcc7/hdf5/include
+
+LIBS +=  -l:libhdf5_cpp.a -l:libhdf5.a -lz
@@ -0,0 +1,84 @@
+#include "datacache.h"
+
+namespace eve {
+
+void DataCache::setMaxBytes(size_t bytes){
+    maxBytes = bytes;
+    evict(0);
+}
+
+bool DataCache::lookup(const string& fqname, IData* data){
+    unordered_map<string, Entry>::iterator it = entries.find(fqname);
+    if (it == entries.end()) return false;
+
+    Entry& entry = it->second;
+    lru.splice(lru.begin(), lru, entry.lruPos);
+    data->posCounts = entry.posCounts;
+    data->intsptrmap = entry.intsptrmap;
+    data->dblsptrmap = entry.dblsptrmap;
+    data->strsptrmap = entry.strsptrmap;
+    data->arrayBlock = entry.arrayBlock;
+    data->arrayRowSize = entry.arrayRowSize;
+    data->posRowIndex = entry.posRowIndex;
+    return true;
+}
+
+void DataCache::insert(const string& fqname, IData* data){
+    size_t bytes = dataBytes(data);
+    if ((bytes > maxBytes) || (entries.find(fqname) != entries.end())) return;
+
+    evict(bytes);
+    lru.push_front(fqname);
+    Entry& entry = entries[fqname];
+    entry.posCounts = data->posCounts;
+    entry.intsptrmap = data->intsptrmap;
+    entry.dblsptrmap = data->dblsptrmap;
+    entry.strsptrmap = data->strsptrmap;
+    entry.arrayBlock = data->arrayBlock;
+    entry.arrayRowSize = data->arrayRowSize;
+    entry.posRowIndex = data->posRowIndex;
+    entry.bytes = bytes;
+    entry.lruPos = lru.begin();
+    usedBytes += bytes;
+}
+
+void DataCache::erase(const string& fqname){
+    unordered_map<string, Entry>::iterator it = entries.find(fqname);
+    if (it == entries.end()) return;
+    usedBytes -= it->second.bytes;
+    lru.erase(it->second.lruPos);
+    entries.erase(it);
+}
+
+// FQ names of all cached datasets, most recently used first
+vector<string> DataCache::getNames(){
+    return vector<string>(lru.begin(), lru.end());
+}
+
+void DataCache::clear(){
+    lru.clear();
+    entries.clear();
+    usedBytes = 0;
+}
+
+// remove least recently used entries until required bytes fit
+void DataCache::evict(size_t required){
+    while (!lru.empty() && (usedBytes + required > maxBytes)){
+        unordered_map<string, Entry>::iterator it = entries.find(lru.back());
+        usedBytes -= it->second.bytes;
+        entries.erase(it);
+        lru.pop_back();
+    }
+}
+
+size_t DataCache::dataBytes(IData* data){
+    size_t bytes = data->posCounts.size() * sizeof(int);
+    for (auto const &column : data->intsptrmap) bytes += column.second->size() * sizeof(int);
+    for (auto const &column : data->dblsptrmap) bytes += column.second->size() * sizeof(double);
+    for (auto const &column : data->strsptrmap) bytes += column.second->memoryBytes();
+    bytes += data->arrayRowSize * data->posRowIndex.size();
+    bytes += data->posRowIndex.size() * (sizeof(int) + sizeof(unsigned int));
+    return bytes;
+}
+
+} // namespace end
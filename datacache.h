@@ -0,0 +1,56 @@
+#ifndef DATACACHE_H
+#define DATACACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include "IData.h"
+
+using namespace std;
+
+namespace eve {
+
+// LRU cache of decoded datasets, keyed by FQ H5 name and bounded by bytes.
+// Only the columns read from the dataset are kept (no extension data). Columns
+// are shared between the cache and all IData objects served from it, they must
+// not be modified after insertion.
+class DataCache
+{
+public:
+    DataCache() : maxBytes(0), usedBytes(0) {};
+    void setMaxBytes(size_t bytes);
+    size_t getMaxBytes(){return maxBytes;};
+    size_t getUsedBytes(){return usedBytes;};
+    bool lookup(const string& fqname, IData* data);
+    void insert(const string& fqname, IData* data);
+    void erase(const string& fqname);
+    vector<string> getNames();
+    void clear();
+
+private:
+    struct Entry {
+        vector<int> posCounts;
+        map<int, shared_ptr<vector<int>>> intsptrmap;
+        map<int, shared_ptr<vector<double>>> dblsptrmap;
+        map<int, shared_ptr<StringColumn>> strsptrmap;
+        shared_ptr<char> arrayBlock;
+        size_t arrayRowSize;
+        map<int, unsigned int> posRowIndex;
+        size_t bytes;
+        list<string>::iterator lruPos;
+    };
+    static size_t dataBytes(IData* data);
+    void evict(size_t required);
+
+    size_t maxBytes;
+    size_t usedBytes;
+    list<string> lru;           // most recently used first
+    unordered_map<string, Entry> entries;
+};
+
+} // namespace end
+
+#endif // DATACACHE_H
@@ -0,0 +1,240 @@
+#include <math.h>
+#include <algorithm>
+#include "datacompute.h"
+#include "IData.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#define STHROW(msg) { \
+     ostringstream err;\
+     err<<msg; \
+     throw runtime_error(err.str()); }
+
+namespace eve {
+
+ScalarColumn DataComputeAccess::scalarColumn(IData* data, const char* operation){
+    if ((data == NULL) || data->isArrayData() || (data->datatype == DTstring) || (data->datatype == DTunknown))
+        STHROW("DataCompute::" << operation << ": numeric scalar data required");
+    ScalarColumn column;
+    if ((data->datatype == DTfloat64) || (data->datatype == DTfloat32)){
+        map<int, shared_ptr<vector<double>>>::iterator it = data->dblsptrmap.find(DBLVECT1);
+        if (it != data->dblsptrmap.end()){
+            column.doubles = it->second->data();
+            column.rows = it->second->size();
+        }
+        if (data->dblvalidmap.find(DBLVECT1) != data->dblvalidmap.end()) column.valid = data->dblvalidmap.at(DBLVECT1).get();
+    }
+    else {
+        map<int, shared_ptr<vector<int>>>::iterator it = data->intsptrmap.find(INTVECT1);
+        if (it != data->intsptrmap.end()){
+            column.ints = it->second->data();
+            column.rows = it->second->size();
+        }
+        if (data->intvalidmap.find(INTVECT1) != data->intvalidmap.end()) column.valid = data->intvalidmap.at(INTVECT1).get();
+    }
+    column.rows = min(column.rows, data->posCounts.size());
+    return column;
+}
+
+static const unsigned long long* bitmapData(const vector<unsigned long long>* bitmap){
+    return (bitmap != NULL) ? bitmap->data() : NULL;
+}
+
+// values of the rows of column as double with their validity in valid
+static void gatherDoubles(const ScalarColumn& column, const vector<int>& rows, vector<double>& values, vector<unsigned long long>& valid){
+    values.resize(rows.size());
+    valid.assign(validityWords(rows.size()), 0);
+    for (size_t i = 0; i < rows.size(); ++i){
+        values[i] = (column.doubles != NULL) ? column.doubles[rows[i]] : (double)column.ints[rows[i]];
+        if (validBit(column.valid, rows[i])) setValidBit(valid, i);
+    }
+}
+
+void DataComputeAccess::checkArray(IData* data, const char* operation){
+    if ((data == NULL) || !data->isArrayData())
+        STHROW("DataCompute::" << operation << ": array data required");
+    switch (data->datatype) {
+    case DTint8: case DTint16: case DTint32: case DTint64: case DTuint8: case DTuint16:
+    case DTuint32: case DTuint64: case DTfloat32: case DTfloat64:
+        break;
+    default:
+        STHROW("DataCompute::" << operation << ": unsupported array data type of " << data->getName());
+    }
+}
+
+// new DTfloat64 data with the metadata of source;
+// valid is stored only if some rows don't have a value
+IData* DataComputeAccess::newResult(IData* source, const vector<int>& posRefs, shared_ptr<vector<double>> values,
+                                     shared_ptr<vector<unsigned long long>> valid){
+    IData* result = new IData(*(IMetaData*)source);
+    result->datatype = DTfloat64;
+    result->dstype = EVEDSTPCOneColumn;
+    result->dim0 = posRefs.size();
+    result->dim1 = 1;
+    result->posCounts = posRefs;
+    result->dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(DBLVECT1, values));
+    if (valid.get() != NULL){
+        bool complete = true;
+        for (size_t i = 0; complete && (i < posRefs.size()); ++i) complete = validBit(valid.get(), i);
+        if (!complete) result->dblvalidmap.insert(pair<int, shared_ptr<vector<unsigned long long>>>(DBLVECT1, valid));
+    }
+    return result;
+}
+
+Data* DataCompute::normalize(Data* data, Data* normalizer)
+{
+    IData* idata = (IData*)data;
+    IData* inorm = (IData*)normalizer;
+    ScalarColumn dataColumn = DataComputeAccess::scalarColumn(idata, "normalize");
+    ScalarColumn normColumn = DataComputeAccess::scalarColumn(inorm, "normalize");
+
+    // rows of both objects with the same position reference
+    vector<int> posRefs, dataRows, normRows;
+    const vector<int>& dataPos = idata->posCounts;
+    const vector<int>& normPos = inorm->posCounts;
+    if ((dataColumn.rows == normColumn.rows) && equal(dataPos.begin(), dataPos.begin() + dataColumn.rows, normPos.begin())){
+        posRefs.assign(dataPos.begin(), dataPos.begin() + dataColumn.rows);
+        dataRows.resize(dataColumn.rows);
+        for (size_t i = 0; i < dataRows.size(); ++i) dataRows[i] = i;
+        normRows = dataRows;
+    }
+    else {
+        // rows keep the order of data, the first normalizer row of a position reference is used
+        vector<pair<int, int>> normOrder;
+        normOrder.reserve(normColumn.rows);
+        for (size_t i = 0; i < normColumn.rows; ++i) normOrder.push_back(pair<int, int>(normPos[i], i));
+        sort(normOrder.begin(), normOrder.end());
+        for (size_t i = 0; i < dataColumn.rows; ++i){
+            vector<pair<int, int>>::iterator it = lower_bound(normOrder.begin(), normOrder.end(), pair<int, int>(dataPos[i], -1));
+            if ((it == normOrder.end()) || (it->first != dataPos[i])) continue;
+            posRefs.push_back(dataPos[i]);
+            dataRows.push_back(i);
+            normRows.push_back(it->second);
+        }
+    }
+
+    vector<double> numerator, denominator;
+    vector<unsigned long long> numValid, denValid;
+    gatherDoubles(dataColumn, dataRows, numerator, numValid);
+    gatherDoubles(normColumn, normRows, denominator, denValid);
+    shared_ptr<vector<double>> values = make_shared<vector<double>>(posRefs.size());
+    shared_ptr<vector<unsigned long long>> valid = make_shared<vector<unsigned long long>>(numValid.size());
+    divideKernel(numerator.data(), denominator.data(), values->data(), posRefs.size());
+    andValidityKernel(numValid.data(), denValid.data(), valid->data(), valid->size());
+
+    IData* result = DataComputeAccess::newResult(idata, posRefs, values, valid);
+    result->normalizeId = inorm->getId();
+    return result;
+}
+
+Statistics DataCompute::statistics(Data* data)
+{
+    IData* idata = (IData*)data;
+    ScalarColumn column = DataComputeAccess::scalarColumn(idata, "statistics");
+    ReduceAccumulator acc;
+    if (column.doubles != NULL)
+        reduceKernel(column.doubles, bitmapData(column.valid), column.rows, acc);
+    else if (column.ints != NULL)
+        reduceKernel(column.ints, bitmapData(column.valid), column.rows, acc);
+
+    Statistics stats;
+    stats.count = acc.count;
+    stats.missing = idata->posCounts.size() - acc.count;
+    stats.sum = acc.sum;
+    if (acc.count > 0){
+        stats.minimum = acc.minimum;
+        stats.maximum = acc.maximum;
+        stats.mean = acc.sum / acc.count;
+    }
+    return stats;
+}
+
+Histogram DataCompute::histogram(Data* data, double low, double high, unsigned int bins)
+{
+    IData* idata = (IData*)data;
+    if ((bins == 0) || !(high > low))
+        STHROW("DataCompute::histogram: invalid bins " << bins << " from " << low << " to " << high);
+    ScalarColumn column = DataComputeAccess::scalarColumn(idata, "histogram");
+    Histogram hist;
+    hist.low = low;
+    hist.high = high;
+    hist.counts.assign(bins, 0);
+    if (column.doubles != NULL)
+        histogramKernel(column.doubles, bitmapData(column.valid), column.rows, low, high, hist.counts, hist.underflow, hist.overflow);
+    else if (column.ints != NULL)
+        histogramKernel(column.ints, bitmapData(column.valid), column.rows, low, high, hist.counts, hist.underflow, hist.overflow);
+    return hist;
+}
+
+static double sumRow(DataType type, const char* row, size_t first, size_t last){
+    switch (type) {
+    case DTint8: return sumKernel<signed char>(row, first, last);
+    case DTint16: return sumKernel<short>(row, first, last);
+    case DTint32: return sumKernel<int>(row, first, last);
+    case DTint64: return sumKernel<long long>(row, first, last);
+    case DTuint8: return sumKernel<unsigned char>(row, first, last);
+    case DTuint16: return sumKernel<unsigned short>(row, first, last);
+    case DTuint32: return sumKernel<unsigned int>(row, first, last);
+    case DTuint64: return sumKernel<unsigned long long>(row, first, last);
+    case DTfloat32: return sumKernel<float>(row, first, last);
+    default: return sumKernel<double>(row, first, last);
+    }
+}
+
+Data* DataCompute::arraySum(Data* data)
+{
+    DataComputeAccess::checkArray((IData*)data, "arraySum");
+    return regionSum(data, 0, ((IData*)data)->dim1);
+}
+
+Data* DataCompute::regionSum(Data* data, unsigned int first, unsigned int last)
+{
+    IData* idata = (IData*)data;
+    DataComputeAccess::checkArray(idata, "regionSum");
+    last = min(last, (unsigned int)idata->dim1);
+    first = min(first, last);
+    size_t rows = idata->posCounts.size();
+    shared_ptr<vector<double>> values = make_shared<vector<double>>(rows, 0.0);
+    shared_ptr<vector<unsigned long long>> valid = make_shared<vector<unsigned long long>>(validityWords(rows));
+    for (size_t i = 0; i < rows; ++i){
+        map<int, unsigned int>::iterator it = idata->posRowIndex.find(idata->posCounts[i]);
+        if ((it == idata->posRowIndex.end()) || (idata->arrayBlock.get() == NULL)) {
+            (*values)[i] = numeric_limits<double>::quiet_NaN();
+            continue;
+        }
+        const char* row = idata->arrayBlock.get() + (size_t)it->second * idata->arrayRowSize;
+        (*values)[i] = sumRow(idata->datatype, row, first, last);
+        setValidBit(*valid, i);
+    }
+    return DataComputeAccess::newResult(idata, idata->posCounts, values, valid);
+}
+
+vector<double> DataCompute::projection(Data* data)
+{
+    IData* idata = (IData*)data;
+    DataComputeAccess::checkArray(idata, "projection");
+    size_t elements = idata->dim1;
+    vector<double> sums(elements, 0.0);
+    if (idata->arrayBlock.get() == NULL) return sums;
+    for (size_t i = 0; i < idata->posCounts.size(); ++i){
+        map<int, unsigned int>::iterator it = idata->posRowIndex.find(idata->posCounts[i]);
+        if (it == idata->posRowIndex.end()) continue;
+        const char* row = idata->arrayBlock.get() + (size_t)it->second * idata->arrayRowSize;
+        switch (idata->datatype) {
+        case DTint8: addKernel<signed char>(row, sums.data(), elements); break;
+        case DTint16: addKernel<short>(row, sums.data(), elements); break;
+        case DTint32: addKernel<int>(row, sums.data(), elements); break;
+        case DTint64: addKernel<long long>(row, sums.data(), elements); break;
+        case DTuint8: addKernel<unsigned char>(row, sums.data(), elements); break;
+        case DTuint16: addKernel<unsigned short>(row, sums.data(), elements); break;
+        case DTuint32: addKernel<unsigned int>(row, sums.data(), elements); break;
+        case DTuint64: addKernel<unsigned long long>(row, sums.data(), elements); break;
+        case DTfloat32: addKernel<float>(row, sums.data(), elements); break;
+        default: addKernel<double>(row, sums.data(), elements); break;
+        }
+    }
+    return sums;
+}
+
+} // namespace end
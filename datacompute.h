@@ -0,0 +1,123 @@
+#ifndef DATACOMPUTE_H
+#define DATACOMPUTE_H
+
+#include <stddef.h>
+#include <vector>
+#include <memory>
+#include "eve.h"
+
+using namespace std;
+
+namespace eve {
+
+// kernels of DataCompute: plain loops over contiguous values without calls or data
+// dependent branches in the inner loop, the compiler can vectorize them.
+// valid is a validity bitmap (see IData.h), NULL if all values are valid.
+
+// out[i] = numerator[i] / denominator[i]
+inline void divideKernel(const double* numerator, const double* denominator, double* out, size_t count){
+    for (size_t i = 0; i < count; ++i) out[i] = numerator[i] / denominator[i];
+}
+
+// valid rows of both bitmaps, a NULL bitmap has all rows valid
+inline void andValidityKernel(const unsigned long long* first, const unsigned long long* second, unsigned long long* out, size_t words){
+    for (size_t i = 0; i < words; ++i)
+        out[i] = ((first != NULL) ? first[i] : ~0ULL) & ((second != NULL) ? second[i] : ~0ULL);
+}
+
+// sum, count, minimum and maximum of the valid values which aren't NaN
+struct ReduceAccumulator {
+    ReduceAccumulator() : sum(0.0), count(0), minimum(0.0), maximum(0.0) {};
+    double sum;
+    size_t count;
+    double minimum;
+    double maximum;
+};
+
+template <typename T>
+void reduceKernel(const T* values, const unsigned long long* valid, size_t count, ReduceAccumulator& acc){
+    // blocks of 64 rows share one validity word, four partial sums hide the add latency
+    for (size_t block = 0; block < count; block += 64){
+        size_t end = (block + 64 < count) ? block + 64 : count;
+        unsigned long long word = (valid != NULL) ? valid[block / 64] : ~0ULL;
+        double sums[4] = {0.0, 0.0, 0.0, 0.0};
+        size_t used = 0;
+        double minimum = acc.minimum;
+        double maximum = acc.maximum;
+        bool first = (acc.count == 0);
+        for (size_t i = block; i < end; ++i){
+            double value = (double)values[i];
+            bool use = ((word >> (i - block)) & 1ULL) && (value == value);
+            if (use && (first || (value < minimum))) minimum = value;
+            if (use && (first || (value > maximum))) maximum = value;
+            first = first && !use;
+            sums[i & 3] += use ? value : 0.0;
+            used += use;
+        }
+        acc.sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        acc.count += used;
+        acc.minimum = minimum;
+        acc.maximum = maximum;
+    }
+}
+
+// count the valid values which aren't NaN into bins of equal width starting at low
+template <typename T>
+void histogramKernel(const T* values, const unsigned long long* valid, size_t count, double low, double high,
+                     vector<size_t>& bins, size_t& underflow, size_t& overflow){
+    double scale = bins.size() / (high - low);
+    size_t last = bins.size() - 1;
+    for (size_t i = 0; i < count; ++i){
+        double value = (double)values[i];
+        if (((valid != NULL) && !(valid[i / 64] & (1ULL << (i % 64)))) || (value != value)) continue;
+        if (value < low)
+            ++underflow;
+        else if (value >= high)
+            ++overflow;
+        else {
+            size_t bin = (size_t)((value - low) * scale);
+            ++bins[(bin > last) ? last : bin];
+        }
+    }
+}
+
+// sum of the elements first .. last-1 of an array row
+template <typename T>
+double sumKernel(const char* row, size_t first, size_t last){
+    const T* elements = (const T*)row;
+    double sums[4] = {0.0, 0.0, 0.0, 0.0};
+    for (size_t i = first; i < last; ++i) sums[i & 3] += (double)elements[i];
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+// element-wise sum of an array row to projection
+template <typename T>
+void addKernel(const char* row, double* projection, size_t elements){
+    const T* values = (const T*)row;
+    for (size_t i = 0; i < elements; ++i) projection[i] += (double)values[i];
+}
+
+class IData;
+
+// column 0 of scalar data, integer values in ints, float values in doubles
+struct ScalarColumn {
+    ScalarColumn() : ints(NULL), doubles(NULL), valid(NULL), rows(0) {};
+    const int* ints;
+    const double* doubles;
+    const vector<unsigned long long>* valid;
+    size_t rows;
+};
+
+// access of DataCompute to the columns of IData
+class DataComputeAccess
+{
+public:
+    static ScalarColumn scalarColumn(IData* data, const char* operation);
+    static void checkArray(IData* data, const char* operation);
+    static IData* newResult(IData* source, const vector<int>& posRefs, shared_ptr<vector<double>> values,
+                            shared_ptr<vector<unsigned long long>> valid);
+};
+
+} // namespace end
+
+#endif // DATACOMPUTE_H
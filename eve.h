@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <memory>
+#include <functional>
+#include <climits>
+#include <limits>
 
 /*! \mainpage EVE Data Interface
  *
@@ -39,6 +43,15 @@ enum FillRule
     LastNANFill /**< do LastFill and NANFill */
 };
 
+/** time alignment specifies which monitor event is mapped onto a position
+* (see DataFile::getJoinedData(std::vector<MetaData*>&, FillRule, TimeAlignment))
+*/
+enum TimeAlignment
+{
+    LastValue,      /**< value of the last monitor event at or before the time of the position */
+    NearestValue    /**< value of the monitor event closest in time to the position, the earlier one if two are equally close */
+};
+
 /** device type (channel or axis)
 *
 */
@@ -89,6 +102,258 @@ enum DataType
     DTfloat32
 };
 
+/** read-only view of a column of values.
+ * A view doesn't copy data, it shares ownership of the buffer with the Data object
+ * it was retrieved from. Thus it remains valid even after the Data object has been deleted.
+ * Element i is located at data()[i*stride()].
+ */
+template <typename T> class DataView
+{
+public:
+    DataView() : ptr(NULL), count(0), step(1) {};
+    DataView(std::shared_ptr<const void> owner, const T* data, size_t size, size_t stride=1)
+        : keep(owner), ptr(data), count(size), step(stride) {};
+
+    /** get the address of the first element
+     * \return pointer to first element (NULL if view is empty)
+     */
+    const T* data() const {return ptr;};
+
+    /** get the number of elements
+     * \return element count
+     */
+    size_t size() const {return count;};
+
+    /** get the distance between two consecutive elements
+     * \return stride in elements (not bytes)
+     */
+    size_t stride() const {return step;};
+
+    /** check if view has no elements
+     * \return true if empty
+     */
+    bool empty() const {return count == 0;};
+
+    /** get element at index (no range check)
+     * \param index element index
+     * \return reference to element
+     */
+    const T& operator[](size_t index) const {return ptr[index*step];};
+
+    /** copy all elements into a new vector
+     * \return vector with a copy of the viewed data
+     */
+    std::vector<T> toVector() const {
+        std::vector<T> result;
+        result.reserve(count);
+        for (size_t i = 0; i < count; ++i) result.push_back(ptr[i*step]);
+        return result;
+    };
+
+    /** get the object which keeps the viewed buffer alive
+     * \return shared owner of the buffer
+     */
+    std::shared_ptr<const void> owner() const {return keep;};
+
+private:
+    std::shared_ptr<const void> keep;
+    const T* ptr;
+    size_t count;
+    size_t step;
+};
+
+/** read-only view of a (rows x columns) matrix stored row-major in one contiguous block.
+ * Like DataView, a MatrixView shares ownership of the buffer with the Data object.
+ * Element (row, col) is located at data()[row*rowStride()+col].
+ */
+template <typename T> class MatrixView
+{
+public:
+    MatrixView() : ptr(NULL), nrows(0), ncols(0), rstride(0) {};
+    MatrixView(std::shared_ptr<const void> owner, const T* data, size_t rows, size_t cols, size_t rowStride)
+        : keep(owner), ptr(data), nrows(rows), ncols(cols), rstride(rowStride) {};
+
+    /** get the address of the first element
+     * \return pointer to element (0,0) (NULL if view is empty)
+     */
+    const T* data() const {return ptr;};
+
+    /** get the number of rows
+     * \return row count
+     */
+    size_t rows() const {return nrows;};
+
+    /** get the number of columns
+     * \return column count
+     */
+    size_t cols() const {return ncols;};
+
+    /** get the distance between the first elements of two consecutive rows
+     * \return row stride in elements (not bytes)
+     */
+    size_t rowStride() const {return rstride;};
+
+    /** check if view has no elements
+     * \return true if empty
+     */
+    bool empty() const {return (nrows == 0) || (ncols == 0);};
+
+    /** get element (no range check)
+     * \param row row index
+     * \param col column index
+     * \return reference to element
+     */
+    const T& operator()(size_t row, size_t col) const {return ptr[row*rstride+col];};
+
+    /** get a view of one row (no range check)
+     * \param index row index
+     * \return view of row
+     */
+    DataView<T> row(size_t index) const {return DataView<T>(keep, ptr + index*rstride, ncols);};
+
+    /** get the object which keeps the viewed buffer alive
+     * \return shared owner of the buffer
+     */
+    std::shared_ptr<const void> owner() const {return keep;};
+
+private:
+    std::shared_ptr<const void> keep;
+    const T* ptr;
+    size_t nrows;
+    size_t ncols;
+    size_t rstride;
+};
+
+/** read-only reference to the characters of a string (like std::string_view).
+ * The characters are not zero terminated, the reference is valid as long as
+ * the StringColumnView it was retrieved from.
+ */
+class StringRef
+{
+public:
+    StringRef() : ptr(""), count(0) {};
+    StringRef(const char* data, size_t size) : ptr(data), count(size) {};
+
+    /** get the address of the first character
+     * \return pointer to characters (not zero terminated)
+     */
+    const char* data() const {return ptr;};
+
+    /** get the number of characters
+     * \return length in bytes
+     */
+    size_t size() const {return count;};
+
+    /** check if string has no characters
+     * \return true if empty
+     */
+    bool empty() const {return count == 0;};
+
+    /** copy the characters into a new string
+     * \return string
+     */
+    std::string str() const {return std::string(ptr, count);};
+
+    /** compare with another string
+     * \return true if both strings have the same characters
+     */
+    bool operator==(const StringRef& other) const {
+        return (count == other.count) && (std::char_traits<char>::compare(ptr, other.ptr, count) == 0);
+    };
+    bool operator==(const std::string& other) const {return *this == StringRef(other.data(), other.size());};
+    bool operator!=(const StringRef& other) const {return !(*this == other);};
+    bool operator!=(const std::string& other) const {return !(*this == other);};
+
+private:
+    const char* ptr;
+    size_t count;
+};
+
+/** read-only view of a string column stored in one character buffer.
+ * Like DataView, the view shares ownership of the buffers with the Data object.
+ * The column holds valueCount() values, value i consists of the characters
+ * getChars()[getOffsets()[i]] to getChars()[getOffsets()[i+1]-1].
+ * Without dictionary (isDictionary() is false) value i is row i. With dictionary
+ * (used for enum data with few distinct values) row i is value getCodes()[i],
+ * a code < 0 is an empty string.
+ */
+class StringColumnView
+{
+public:
+    StringColumnView() : chars(NULL), offsets(NULL), values(0), codes(NULL), rows(0) {};
+    StringColumnView(std::shared_ptr<const void> owner, const char* chars, const long long* offsets, size_t values,
+                     const int* codes, size_t rows)
+        : keep(owner), chars(chars), offsets(offsets), values(values), codes(codes), rows(rows) {};
+
+    /** get the number of rows
+     * \return row count
+     */
+    size_t size() const {return rows;};
+
+    /** check if view has no rows
+     * \return true if empty
+     */
+    bool empty() const {return rows == 0;};
+
+    /** get string of row (no range check)
+     * \param row row index
+     * \return reference to characters of row
+     */
+    StringRef operator[](size_t row) const {
+        long long value = (codes != NULL) ? codes[row] : (long long)row;
+        if (value < 0) return StringRef();
+        return StringRef(chars + offsets[value], (size_t)(offsets[value + 1] - offsets[value]));
+    };
+
+    /** check if rows are dictionary encoded
+     * \return true if rows refer to the values with getCodes()
+     */
+    bool isDictionary() const {return codes != NULL;};
+
+    /** get the number of values (distinct values if isDictionary(), rows otherwise)
+     * \return value count
+     */
+    size_t valueCount() const {return values;};
+
+    /** get the value of each row (dictionary columns only)
+     * \return view of codes (empty if not isDictionary())
+     */
+    DataView<int> getCodes() const {return DataView<int>(keep, codes, (codes != NULL) ? rows : 0);};
+
+    /** get the start of each value in getChars(), followed by the total number of characters
+     * \return view of valueCount()+1 offsets
+     */
+    DataView<long long> getOffsets() const {return DataView<long long>(keep, offsets, (offsets != NULL) ? values + 1 : 0);};
+
+    /** get the characters of all values
+     * \return view of the character buffer
+     */
+    DataView<char> getChars() const {return DataView<char>(keep, chars, (offsets != NULL) ? (size_t)offsets[values] : 0);};
+
+    /** copy all rows into a new vector
+     * \return vector with a copy of the strings
+     */
+    std::vector<std::string> toVector() const {
+        std::vector<std::string> result;
+        result.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) result.push_back((*this)[i].str());
+        return result;
+    };
+
+    /** get the object which keeps the viewed buffers alive
+     * \return shared owner of the buffers
+     */
+    std::shared_ptr<const void> owner() const {return keep;};
+
+private:
+    std::shared_ptr<const void> keep;
+    const char* chars;
+    const long long* offsets;
+    size_t values;
+    const int* codes;
+    size_t rows;
+};
+
 class MetaData
 {
 public:
@@ -256,9 +521,10 @@ public:
      * Cast the pointer to a vector with type retrieved by getDataType().
      * The size of the vector may be derived from getDimension()[1]
      * This vector must be deleted after use.
+     * Use getArrayView() to access all rows without copying.
      * \param cnt number of desired data array
      * \return ptr address of the vector pointer (NULL if no array data or error)
-     * \sa isArrayData(), getDimension(), getDataType()
+     * \sa isArrayData(), getDimension(), getDataType(), getArrayView()
      */
     virtual void* getArrayDataPointer(unsigned int cnt)=0;
 
@@ -268,8 +534,9 @@ public:
      * depending on the return value ofgetDataType().
      * The size of the vector may be derived from getDimension()[0]
      * This vector must be deleted after use.
+     * Use getIntView(), getDoubleView() or getStringView() to avoid the copy.
      * \return ptr address of a vector<int> or vector<double> or vector<string> (may be NULL)
-     * \sa isArrayData()
+     * \sa isArrayData(), getIntView(), getDoubleView(), getStringView()
      */
     virtual void* getDataPointer()=0;
 
@@ -334,8 +601,382 @@ public:
      */
     virtual std::vector<double> getTriggerIntv()=0;
 
+    /** get a view of all values if getDataType() is DTint32 or any other integer type (not for array data).
+     * Same content as getDataPointer(), but without copying.
+     * \return view of values (empty if data is not integer data)
+     * \sa getDataPointer(), DataView
+     */
+    virtual DataView<int> getIntView()=0;
+
+    /** get a view of all values if getDataType() is DTfloat64 or DTfloat32 (not for array data).
+     * Same content as getDataPointer(), but without copying.
+     * \return view of values (empty if data is not floating point data)
+     * \sa getDataPointer(), DataView
+     */
+    virtual DataView<double> getDoubleView()=0;
+
+    /** get a view of all values if getDataType() is DTstring (not for array data).
+     * Strings are stored in one character buffer (see getStringColumn()), the first call
+     * creates the std::string objects, later calls and views share them.
+     * \return view of values (empty if data is not string data)
+     * \sa getDataPointer(), getStringColumn(), DataView
+     */
+    virtual DataView<std::string> getStringView()=0;
+
+    /** get a view of the string column if getDataType() is DTstring (not for array data).
+     * Same content as getStringView(), but without creating std::string objects.
+     * \return view of strings (empty if data is not string data)
+     * \sa getStringView(), StringColumnView
+     */
+    virtual StringColumnView getStringColumn()=0;
+
+    /** get the validity bitmap of the values (getIntView(), getDoubleView() or getStringView()).
+     * Bit (row % 64) of word (row / 64) is set if the row has a value. Rows without value
+     * are added by joining data (see DataFile::getJoinedData()) and contain INT_MIN, NAN
+     * or an empty string (getDataPointer() returns "NaN" for strings).
+     * Missing rows may be skipped with word-wise bit operations, e.g. a word equal to ~0ULL
+     * consists of 64 valid rows.
+     * \return view of (rows + 63) / 64 words (empty if all rows are valid or for array data)
+     * \sa isValid()
+     */
+    virtual DataView<unsigned long long> getValidity()=0;
+
+    /** check if a row has a value, for array data same as hasArrayRow()
+     * \param row row index
+     * \return true if the row has a value
+     * \sa getValidity()
+     */
+    virtual bool isValid(unsigned int row)=0;
+
+    /** view of getAverageAttemptsPreset() without copying
+     * \return view of maximum allowed attempts
+     */
+    virtual DataView<int> getAverageAttemptsPresetView()=0;
+
+    /** view of getAverageAttempts() without copying
+     * \return view of used attempts
+     */
+    virtual DataView<int> getAverageAttemptsView()=0;
+
+    /** view of getAverageCountPreset() without copying
+     * \return view of preset counts
+     */
+    virtual DataView<int> getAverageCountPresetView()=0;
+
+    /** view of getAverageCount() without copying
+     * \return view of used counts
+     */
+    virtual DataView<int> getAverageCountView()=0;
+
+    /** view of getAverageLimitPreset() without copying
+     * \return view of preset limits
+     */
+    virtual DataView<double> getAverageLimitPresetView()=0;
+
+    /** view of getAverageMaxDeviationPreset() without copying
+     * \return view of allowed maximum deviation
+     */
+    virtual DataView<double> getAverageMaxDeviationPresetView()=0;
+
+    /** view of getStddevCount() without copying
+     * \return view of counts
+     */
+    virtual DataView<int> getStddevCountView()=0;
+
+    /** view of getStddeviation() without copying
+     * \return view of standard deviation
+     */
+    virtual DataView<double> getStddeviationView()=0;
+
+    /** view of getTriggerIntv() without copying
+     * \return view of trigger interval
+     */
+    virtual DataView<double> getTriggerIntvView()=0;
+
+    /** get a view of the memory block holding all array data (for array data only).
+     * Row i of the block contains the array for position reference getPosReferences()[i],
+     * the number of columns is the row size in bytes (getDimension()[1] * size of element).
+     * Rows without data (see hasArrayRow()) are zeroed.
+     * \return byte view of array block (empty if no array data)
+     * \sa getArrayView(), hasArrayRow()
+     */
+    virtual MatrixView<char> getArrayBlock()=0;
+
+    /** check if array data is available for the specified row (for array data only).
+     * \param row row index (see getArrayBlock())
+     * \return true if the row has data
+     */
+    virtual bool hasArrayRow(unsigned int row)=0;
+
+    /** get a typed (rows x getDimension()[1]) view of all array data (for array data only).
+     * T must correspond to getDataType(), e.g. int for DTint32 or double for DTfloat64.
+     * \return view of array data (empty if no array data or size of T doesn't match)
+     * \sa getArrayBlock(), hasArrayRow()
+     */
+    template <typename T> MatrixView<T> getArrayView(){
+        MatrixView<char> block = getArrayBlock();
+        size_t cols = getDimension().second;
+        if (block.empty() || (block.cols() != cols * sizeof(T))) return MatrixView<T>();
+        return MatrixView<T>(block.owner(), (const T*)block.data(), block.rows(), cols, cols);
+    };
+
+};
+
+/** sequential reader of a dataset in blocks of rows
+*
+* The stream keeps the dataset open, delete it before the DataFile it was opened from.
+*/
+class DataStream {
+public:
+    virtual ~DataStream(){};
+
+    /** read the next block of rows.
+     * \return data object with posReferences and values of the next block (delete after use) or NULL at the end of the dataset
+     */
+    virtual Data* next()=0;
+
+    /** \return total number of rows in dataset
+     */
+    virtual unsigned long getRows()=0;
+
+    /** \return number of rows already read
+     */
+    virtual unsigned long getPosition()=0;
+};
+
+/** sequential reader of joined data in blocks of rows
+*
+* The stream keeps the datasets open, delete it before the DataFile it was opened from.
+*/
+class JoinedStream {
+public:
+    virtual ~JoinedStream(){};
+
+    /** read the next block of joined rows.
+     * \return list of data objects with the same posReferences in the order of DataFile::getJoinedData (delete after use), empty at the end
+     */
+    virtual std::vector<Data*> next()=0;
+};
+
+/** table of joined data, stored column by column in one contiguous image.
+*
+* The image can be written to a file and memory-mapped again (mapFile) without parsing.
+* Layout (native byte order, all offsets from the start of the image, buffers 64 byte aligned):
+* - header (64 bytes): char magic[8] "EVECOLS1", uint64 rows, uint64 columns,
+*   uint64 offset of the posReferences (int32[rows]), uint64 offset of the column directory,
+*   uint64 size of the image, 16 bytes reserved
+* - column directory, 64 bytes per column: uint32 type (DTint32, DTfloat64 or DTstring),
+*   uint32 length of the id, uint64 offset of the id, uint64 offset of the values,
+*   uint64 offset of the validity bitmap, uint64 offset and uint64 size of the characters
+*   of string columns, 16 bytes reserved
+* - values: int32[rows], double[rows] or for strings int64[rows+1] offsets into the characters
+* - validity bitmap: (rows+7)/8 bytes, bit (row%8) of byte row/8 is set, if the row has a value
+*
+* Missing rows of a column (no value in the dataset and no fill value) are marked in the
+* validity bitmap only, their value is 0, 0.0 or an empty string.
+*/
+class ColumnarTable {
+public:
+    virtual ~ColumnarTable(){};
+
+    /** Memory-map a table written by write().
+     * \param filename name of file
+     * \return ColumnarTable object (delete after use, views remain valid)
+     */
+    static ColumnarTable* mapFile(const std::string& filename);
+
+    /** \return number of rows
+     */
+    virtual size_t getRows()=0;
+
+    /** \return number of columns
+     */
+    virtual size_t getColumns()=0;
+
+    /** \return posReference of every row
+     */
+    virtual DataView<int> getPosReferences()=0;
+
+    /** \return XML-ID of the data in column col
+     */
+    virtual std::string getColumnId(size_t col)=0;
+
+    /** \return storage type of column col: DTint32 (all integer types), DTfloat64 (float types) or DTstring
+     */
+    virtual DataType getColumnType(size_t col)=0;
+
+    /** \return values of an int column (empty for other types)
+     */
+    virtual DataView<int> getIntColumn(size_t col)=0;
+
+    /** \return values of a double column (empty for other types)
+     */
+    virtual DataView<double> getDoubleColumn(size_t col)=0;
+
+    /** \return rows+1 offsets of the strings of a string column in getStringChars() (empty for other types)
+     */
+    virtual DataView<long long> getStringOffsets(size_t col)=0;
+
+    /** \return characters of all strings of a string column (not null terminated)
+     */
+    virtual DataView<char> getStringChars(size_t col)=0;
+
+    /** \return string in row of a string column (empty if not a string column)
+     */
+    virtual std::string getString(size_t col, size_t row)=0;
+
+    /** \return validity bitmap of column col, see class description
+     */
+    virtual DataView<unsigned char> getValidity(size_t col)=0;
+
+    /** \return true if row of column col has a value
+     */
+    virtual bool isValid(size_t col, size_t row)=0;
+
+    /** Write the image to a file.
+     * \param filename name of file
+     */
+    virtual void write(const std::string& filename)=0;
+};
+
+/** selection of rows by posReference
+*
+* Selects the rows with a posReference in [firstPosRef, lastPosRef], of these every stride-th
+* row starting with the first one. If posRefs is not empty, the rows with a posReference in
+* posRefs are selected instead.
+*/
+struct Selection
+{
+    Selection() : firstPosRef(INT_MIN), lastPosRef(INT_MAX), stride(1) {};
+    Selection(int first, int last, unsigned int stride=1) : firstPosRef(first), lastPosRef(last), stride(stride) {};
+
+    int firstPosRef;        /**< smallest posReference selected */
+    int lastPosRef;         /**< largest posReference selected */
+    unsigned int stride;    /**< select every stride-th row of the interval (0 and 1 select all rows) */
+    std::vector<int> posRefs; /**< if not empty, select the rows with these posReferences */
+};
+
+/** results of queries released together
+*
+* A ResultSet is created with DataFile::createResultSet(). Its queries work like the
+* ones of DataFile with the same name, but the MetaData and Data objects returned are
+* allocated in memory blocks owned by the ResultSet: don't delete them, deleting the
+* ResultSet (or clear()) releases all of them at once. Views (DataView etc.) retrieved
+* from the data remain valid. Delete the ResultSet before the DataFile, use it in one
+* thread at a time.
+*/
+class ResultSet {
+public:
+    virtual ~ResultSet(){};
+
+    /** see DataFile::getMetaData()
+     * \return list of metadata (owned by the ResultSet)
+     */
+    virtual std::vector<MetaData *> getMetaData(Section section, std::string id="", std::string name="")=0;
+
+    /** see DataFile::getData(std::vector<MetaData*>&)
+     * \return list of data (owned by the ResultSet)
+     */
+    virtual std::vector<Data*> getData(std::vector<MetaData*>& metadatalist)=0;
+
+    /** see DataFile::getData(std::vector<MetaData*>&, const Selection&)
+     * \return list of data (owned by the ResultSet)
+     */
+    virtual std::vector<Data*> getData(std::vector<MetaData*>& metadatalist, const Selection& selection)=0;
+
+    /** see DataFile::getJoinedData(std::vector<MetaData*>&, FillRule)
+     * \return list of data (owned by the ResultSet)
+     */
+    virtual std::vector<Data*> getJoinedData(std::vector<MetaData*>& metadatalist, FillRule fill=NoFill)=0;
+
+    /** see DataFile::getJoinedData(std::vector<MetaData*>&, FillRule, const Selection&)
+     * \return list of data (owned by the ResultSet)
+     */
+    virtual std::vector<Data*> getJoinedData(std::vector<MetaData*>& metadatalist, FillRule fill, const Selection& selection)=0;
+
+    /** see DataFile::getJoinedData(std::vector<MetaData*>&, FillRule, TimeAlignment)
+     * \return list of data (owned by the ResultSet)
+     */
+    virtual std::vector<Data*> getJoinedData(std::vector<MetaData*>& metadatalist, FillRule fill, TimeAlignment alignment)=0;
+
+    /** see DataFile::getPreferredData()
+     * \return list of data (owned by the ResultSet)
+     */
+    virtual std::vector<Data*> getPreferredData(FillRule fill=NoFill)=0;
+
+    /** get the number of objects owned by the ResultSet
+     * \return number of MetaData and Data objects
+     */
+    virtual size_t size()=0;
+
+    /** release all objects returned so far
+     */
+    virtual void clear()=0;
 };
 
+/** file driver of the H5 library used to open a file (see OpenOptions::driver)
+*
+*/
+enum FileDriver
+{
+    DefaultDriver,  /**< POSIX I/O (sec2 driver) */
+    CoreDriver,     /**< read the whole file into memory when opening it (core driver) */
+    DirectDriver    /**< POSIX I/O bypassing the system cache (direct driver, if the H5 library has been built with it) */
+};
+
+/** statistics of one call of a DataFile, see DataFile::setStatsCallback() */
+struct CallStats
+{
+    CallStats() : seconds(0.0), bytesRead(0), datasetsOpened(0), allocations(0) {};
+    std::string call;       /**< name of the method */
+    double seconds;         /**< wall time of the call, including waits for the H5 calls of other threads */
+    size_t bytesRead;       /**< bytes of datasets read (mapped datasets, see OpenOptions::mappedReads, count with the bytes mapped) */
+    size_t datasetsOpened;  /**< datasets opened for their metadata or data */
+    size_t allocations;     /**< data buffers allocated: staging buffers, columns and array blocks */
+};
+
+/** callback receiving the statistics of calls of a DataFile, called in the thread of the
+* call when it has ended (also if it failed). Exceptions thrown by the callback are ignored.
+*/
+typedef std::function<void(const CallStats&)> StatsCallback;
+
+/** options used when opening a data file
+*
+*/
+struct OpenOptions
+{
+    OpenOptions() : lazyInventory(false), deferInventory(false), memberReads(false), mappedReads(false), cacheSize(0), decodeThreads(0), followFile(false),
+        prefetch(false), driver(DefaultDriver), coreLimit(0), chunkCacheSize(0), chunkCacheSlots(0), metadataCacheSize(0), pageBufferSize(0) {};
+
+    bool lazyInventory;     /**< list datasets only by name when opening a file or selecting a chain, read their attributes and datatypes when metadata or data is requested */
+    bool deferInventory;    /**< read only the attributes of the file and of the selected chain when opening a file or selecting a chain, datasets are listed when metadata or data is first requested (getMetaData(), getPreferredData() etc.), for catalogues using getFileMetaData(), getChains() and getChainMetaData() only */
+    bool memberReads;       /**< read posCounts and values of numeric datasets directly into their columns (HDF5 compound member reads) instead of through a staging buffer holding the whole dataset */
+    bool mappedReads;       /**< decode the records of contiguous, unfiltered one and two column datasets in place from a memory mapping of the file instead of reading them with the H5 library (chunked or compressed datasets and files not opened with the default sec2 driver are read with the library) */
+    size_t cacheSize;       /**< size in bytes of the per file cache of datasets read, least recently used datasets are dropped first (0 disables the cache) */
+    unsigned int decodeThreads; /**< number of worker threads decoding datasets in DataFile::getData(std::vector<MetaData*>&), the H5 reads stay in the calling thread (0 reads and decodes serially) */
+    bool followFile;        /**< follow a file still being written: open it with HDF5 SWMR read access (if the file supports it), see DataFile::refresh() */
+    std::string indexDir;   /**< directory for inventory files: the inventory of all chains is saved there when a file is opened the first time, later openings use it as long as path, modification and status change times, inode and size of the file are unchanged (empty: no inventory files, ignored with followFile) */
+    bool prefetch;          /**< read ahead in a background thread while no method of the file is running: the preferred data (see DataFile::getPreferredData) of the selected chain with its average and standard deviation data (into the cache, only with cacheSize > 0), the inventory of the next chain and its preferred data (ignored with deferInventory) */
+    FileDriver driver;      /**< file driver */
+    size_t coreLimit;       /**< files up to this size in bytes are read into memory with CoreDriver, larger ones use driver (0: always use driver, ignored with followFile) */
+    size_t chunkCacheSize;  /**< size in bytes of the raw data chunk cache of each dataset (0: library default of 1 MB) */
+    size_t chunkCacheSlots; /**< number of slots of the raw data chunk cache, best a prime about 100 times the number of chunks fitting into the cache (0: library default) */
+    size_t metadataCacheSize; /**< initial size in bytes of the metadata cache, the maximum size is raised to it if necessary (0: library default) */
+    size_t pageBufferSize;  /**< size in bytes of the page buffer for files written with paged file space strategy, other files are opened without (0: no page buffer) */
+    StatsCallback statsCallback; /**< receives the statistics of opening the file (call "openFile", with the inventory read then) and of the later calls, see DataFile::setStatsCallback() (empty: no statistics) */
+};
+
+/** data file
+*
+* The methods may be called from several threads. The H5 library isn't thread-safe:
+* H5 calls of all DataFile, AsyncFile and FileBatch objects (and their streams) take
+* turns, decoding, joining and metadata lookups of the calls run in parallel.
+* The inventory of a chain is read once and not changed afterwards (see refresh()).
+* The selected chain (setChain()) is shared by all threads. Threads working on
+* different chains use the methods with a chain parameter, reads of data use the
+* chain of their metadata. Objects returned by a DataFile (metadata, data, streams)
+* are used by one thread at a time.
+*/
 class DataFile {
 public:
     virtual ~DataFile(){};
@@ -346,6 +987,14 @@ public:
      */
     static DataFile* openFile(std::string name);
 
+    /** Open a Data File (usually H5 format) with the specified options.
+     * \param name Name of file to open
+     * \param options open options
+     * \return DataFile object
+     * \sa OpenOptions
+     */
+    static DataFile* openFile(std::string name, const OpenOptions& options);
+
     /** get a list of all available chains.
      * \return list of chains
      */
@@ -357,6 +1006,9 @@ public:
     virtual int getChain()=0;
 
     /** Set chain as selected chain (chain 1 selected as default).
+     * The inventory of a chain is kept, switching back to a chain doesn't read it again.
+     * The selection is shared by all threads using the file, it is used by the methods
+     * without a chain parameter.
      * \param chain id of an available chain
      */
     virtual void setChain(int chain)=0;
@@ -366,6 +1018,12 @@ public:
      */
     virtual ChainMetaData* getChainMetaData()=0;
 
+    /** Retrieve metadata of a chain, the selected chain is not changed.
+     * \param chain id of an available chain
+     * \return return a ChainMetaData object
+     */
+    virtual ChainMetaData* getChainMetaData(int chain)=0;
+
     /** Retrieve file metadata.
      * \return return a FileMetaData object
      */
@@ -376,6 +1034,13 @@ public:
      */
     virtual std::string getNameById(Section section, std::string id)=0;
 
+    /** Retrieve a string with the name of the device with identification id in a chain or empty string,
+     * the selected chain is not changed.
+     * \param chain id of an available chain
+     * \return return name for id
+     */
+    virtual std::string getNameById(int chain, Section section, std::string id)=0;
+
     /**
      * @brief Retrieve metadata objects for the specified section in selected chain.
      * @param section
@@ -385,20 +1050,42 @@ public:
      */
     virtual std::vector<MetaData *> getMetaData(Section section, std::string id="", std::string name="")=0;
 
+    /**
+     * @brief Retrieve metadata objects for the specified section in a chain, the selected chain is not changed.
+     * @param chain id of an available chain
+     * @param section
+     * @param id if not empty, select metada with XML-ID id
+     * @param name if not empty, select metada with Name name
+     * @return MetaData list of metadata pointers
+     */
+    virtual std::vector<MetaData *> getMetaData(int chain, Section section, std::string id="", std::string name="")=0;
+
     /** Retrieve a list of data objects.
+     * Like all reads of data, it uses the chain of the metadata (not the selected chain)
+     * to find average and standard deviation data.
      *
      * \param metadatalist list of metadata to retrieve data for
      * \return list of data pointers (delete after use)
      */
     virtual std::vector<Data*> getData(std::vector<MetaData*>& metadatalist)=0;
 
+    /** Retrieve a list of data objects with the selected rows only.
+     * Only the posReferences and the selected rows of a dataset are read.
+     *
+     * \param metadatalist list of metadata to retrieve data for
+     * \param selection rows to retrieve, the stride counts the rows of each dataset
+     * \return list of data pointers (delete after use)
+     */
+    virtual std::vector<Data*> getData(std::vector<MetaData*>& metadatalist, const Selection& selection)=0;
+
     /** Retrieve joined data for given metada.
      * Transforms a list of data objects to data objects with corresponding rows.
      * May be used to create table data from single data objects. All data will have the
      * same number of values and my be merged into a table. Depending on the fill rule,
      * missing values will be added or all data objects are reduced to rows
      * existent in evey dataset. If the metadatalist contains snapshot data, this metadata
-     * is used to find the last axis position for fill rules LastFill/LastNANFill
+     * is used to find the last axis position for fill rules LastFill/LastNANFill.
+     * Rows added without a value (not filled) are marked invalid in Data::getValidity().
      *
      * \param metadatalist list of metadata to retrieve data for
      * \param fill desired fill rule
@@ -406,6 +1093,36 @@ public:
      */
     virtual std::vector<Data*> getJoinedData(std::vector<MetaData*>& metadatalist, FillRule fill=NoFill)=0;
 
+    /** Retrieve the selected rows of joined data for given metadata.
+     * Only the rows in the posReference interval of the selection (and for LastFill/LastNANFill
+     * the last axis positions before it) are read and joined, stride and posRefs of the
+     * selection are applied to the rows of the joined data.
+     *
+     * \param metadatalist list of metadata to retrieve data for
+     * \param fill desired fill rule
+     * \param selection rows to retrieve
+     * \return list of data pointers (delete after use)
+     */
+    virtual std::vector<Data*> getJoinedData(std::vector<MetaData*>& metadatalist, FillRule fill, const Selection& selection)=0;
+
+    /** Retrieve joined data with monitor data aligned to the positions.
+     * Data of metadatalist which isn't monitor data is joined like getJoinedData(metadatalist, fill).
+     * Monitor data (section Monitor, rows are milliseconds since start) is mapped onto the
+     * position references of the joined data through the timestamp dataset of the chain
+     * (section Timestamp): a position gets the value of the monitor event selected by alignment
+     * for the time of the position. Positions without timestamp or without such an event
+     * are marked invalid in Data::getValidity(). Without other data the monitor data is
+     * mapped onto all position references of the timestamp dataset.
+     * Events and positions are aligned with one sorted merge.
+     *
+     * \param metadatalist list of metadata to retrieve data for
+     * \param fill desired fill rule
+     * \param alignment monitor event used for a position
+     * \return list of data pointers, the monitor data last (delete after use)
+     * \sa TimeAlignment
+     */
+    virtual std::vector<Data*> getJoinedData(std::vector<MetaData*>& metadatalist, FillRule fill, TimeAlignment alignment)=0;
+
     /** Retrieve joined data for data marked as preferred in selected chain.
      *
      * \param fill desired fill rule
@@ -413,12 +1130,375 @@ public:
      */
     virtual std::vector<Data*> getPreferredData(FillRule fill=NoFill)=0;
 
+    /** Retrieve joined data for data marked as preferred in a chain, the selected chain is not changed.
+     *
+     * \param chain id of an available chain
+     * \param fill desired fill rule
+     * \return list of data pointers (delete after use)
+     */
+    virtual std::vector<Data*> getPreferredData(int chain, FillRule fill)=0;
+
     /** Retrieve log
      *
      * \return list of log messages
      */
     virtual std::vector<std::string> getLogData()=0;
 
+    /** Open a dataset for reading in blocks of at most chunkRows rows.
+     * Only the dataset itself is read, no average or standard deviation data.
+     * Array data can't be streamed.
+     * \param metadata metadata of the dataset
+     * \param chunkRows max. number of rows in a block
+     * \return DataStream object (delete after use)
+     */
+    virtual DataStream* openStream(MetaData* metadata, unsigned int chunkRows)=0;
+
+    /** Open a joined reader returning the rows of getJoinedData in posReference order,
+     * in blocks of at most chunkRows rows. The datasets are read and joined block by block,
+     * their posReferences must be ascending. Only the datasets themselves are joined,
+     * no average or standard deviation data. Array data can't be streamed.
+     * \param metadatalist list of metadata to retrieve data for (may contain snapshot data, see getJoinedData)
+     * \param fill desired fill rule
+     * \param chunkRows max. number of rows in a block
+     * \return JoinedStream object (delete after use)
+     */
+    virtual JoinedStream* openJoinedStream(std::vector<MetaData*>& metadatalist, FillRule fill, unsigned int chunkRows)=0;
+
+    /** Update the inventory of a file still being written (see OpenOptions::followFile).
+     * The file is reopened and rescanned: new chains are added to getChains(), new datasets and
+     * the new size of known datasets and array groups of the selected chain and the monitors are
+     * picked up, attributes of known datasets are not read again. Cached datasets are extended by
+     * the rows written since they were read. Inventories of other chains are dropped and read
+     * again when they are needed. Reads running in other threads keep the inventory they started with.
+     * Metadata, data and streams retrieved before keep the old dimensions, retrieve the metadata
+     * again to read new rows (e.g. with getData(std::vector<MetaData*>&, const Selection&) for
+     * the posReferences after the last row read). Streams should be deleted before.
+     */
+    virtual void refresh()=0;
+
+    /** Retrieve joined data for given metadata as columnar table.
+     * The rows of getJoinedData(metadatalist, fill) are stored in one column per dataset
+     * (without average or standard deviation data), array data is skipped.
+     * \param metadatalist list of metadata to retrieve data for (may contain snapshot data, see getJoinedData)
+     * \param fill desired fill rule
+     * \return ColumnarTable object (delete after use)
+     */
+    virtual ColumnarTable* getColumnarData(std::vector<MetaData*>& metadatalist, FillRule fill=NoFill)=0;
+
+    /** create a ResultSet for queries whose results are released together.
+     * The metadata of the results share their attributes with the metadata of the file.
+     * \return ResultSet object (delete after use, before the DataFile)
+     */
+    virtual ResultSet* createResultSet()=0;
+
+    /** Report statistics of calls reading metadata or data.
+     * Reads done in the background (see OpenOptions::prefetch) and by streams after they
+     * were opened are not counted. Opening the file is reported to OpenOptions::statsCallback.
+     * \param callback called after every call except the ones only returning the chains,
+     * the selected chain, file metadata or chain metadata of the selected chain (empty: no statistics)
+     */
+    virtual void setStatsCallback(const StatsCallback& callback)=0;
+
+};
+
+/** metadata selected in every file of a FileBatch
+*
+* With preferred set, the preferred axis and channel of the chain are read (see
+* DataFile::getPreferredData). Otherwise the datasets of sections with an id in ids or
+* a name in names are read, all datasets of sections if both lists are empty.
+*/
+struct BatchSelection
+{
+    BatchSelection() : chain(1), sections(1, Standard), preferred(false), joined(false), fill(NoFill) {};
+
+    int chain;                      /**< chain to read */
+    std::vector<Section> sections;  /**< sections to select datasets from */
+    std::vector<std::string> ids;   /**< XML-IDs of datasets to read */
+    std::vector<std::string> names; /**< names of datasets to read */
+    bool preferred;                 /**< read preferred data instead of ids and names */
+    bool joined;                    /**< join the data of a file (see DataFile::getJoinedData), preferred data is always joined */
+    FillRule fill;                  /**< fill rule for joined data */
+};
+
+/** data read from one file of a FileBatch
+*
+*/
+struct BatchResult
+{
+    std::string filename;           /**< name of the file */
+    std::vector<Data*> data;        /**< data read (delete after use) */
+    std::string error;              /**< error message if the file couldn't be read (data is empty) */
+};
+
+/** reads the same selection of data from many files with a pool of worker threads
+*
+* Every worker opens, inventories and reads one file at a time. The H5 library
+* isn't thread-safe: workers take turns with H5 calls (opening, inventory and reading
+* of the raw datasets) and with the H5 calls of other files (see DataFile), decoding
+* and joining run in parallel.
+*/
+class FileBatch {
+public:
+    /** Stops the workers after their current file and deletes the data not yet retrieved.
+     */
+    virtual ~FileBatch(){};
+
+    /** Start reading files.
+     * \param files names of the files to read
+     * \param selection data to read from every file
+     * \param options options used to open the files (decodeThreads and prefetch are ignored, statsCallback is called by the workers)
+     * \param threads number of worker threads (0: number of cores)
+     * \return FileBatch object (delete after use)
+     */
+    static FileBatch* open(const std::vector<std::string>& files, const BatchSelection& selection, const OpenOptions& options=OpenOptions(), unsigned int threads=0);
+
+    /** Retrieve the data of the next file finished, files are delivered in order of completion.
+     * Blocks until a file is finished.
+     * \param result data or error of the file
+     * \return false if all files have been delivered
+     */
+    virtual bool next(BatchResult& result)=0;
+};
+
+/** progress of an asynchronous read (see AsyncRead::getProgress)
+*
+*/
+struct ReadProgress
+{
+    ReadProgress() : datasetsDone(0), datasetsTotal(0), rowsDone(0), rowsTotal(0) {};
+
+    size_t datasetsDone;    /**< datasets read so far (joined data also reads timestamps and snapshots) */
+    size_t datasetsTotal;   /**< number of metadata of the request (0 if not known, e.g. for getPreferredData) */
+    size_t rowsDone;        /**< arrays read of the array data being read */
+    size_t rowsTotal;       /**< arrays of the array data being read (0 if no array data has been read) */
+};
+
+/** callback of an asynchronous read, called in the I/O thread of the AsyncFile when
+* the read is finished, cancelled or failed (see AsyncFile)
+*/
+typedef std::function<void()> ReadCallback;
+
+/** handle of an asynchronous read of an AsyncFile
+*
+* The methods may be called from any thread.
+*/
+class AsyncRead {
+public:
+    /** Cancels the read if it isn't finished, waits for it to stop and deletes the data not retrieved.
+     * Don't delete the AsyncRead in its callback.
+     */
+    virtual ~AsyncRead(){};
+
+    /** check if the read is finished (successfully, cancelled or with an error)
+     * \return true if finished
+     */
+    virtual bool isFinished()=0;
+
+    /** wait until the read is finished
+     */
+    virtual void wait()=0;
+
+    /** wait at most milliseconds for the read to finish
+     * \param milliseconds max. time to wait
+     * \return true if finished
+     */
+    virtual bool waitFor(unsigned int milliseconds)=0;
+
+    /** Cancel the read. A queued read isn't started, a running read stops before the
+     * next dataset or array, the data read so far is deleted.
+     */
+    virtual void cancel()=0;
+
+    /** check if the read has been stopped by cancel() (or deleting the AsyncFile)
+     * \return true if the read has been stopped before it was finished
+     */
+    virtual bool isCancelled()=0;
+
+    /** get the progress of the read.
+     * \return progress so far
+     */
+    virtual ReadProgress getProgress()=0;
+
+    /** Retrieve the data read, waits until the read is finished.
+     * Throws a runtime_error with the error message of the read or if it was cancelled.
+     * \return list of data pointers (delete after use), empty if already retrieved
+     */
+    virtual std::vector<Data*> getData()=0;
+
+    /** Retrieve the log of AsyncFile::getLogData(), waits until the read is finished.
+     * Throws a runtime_error with the error message of the read or if it was cancelled.
+     * \return list of log messages
+     */
+    virtual std::vector<std::string> getLogData()=0;
+};
+
+/** data file read asynchronously from an I/O thread
+*
+* An AsyncFile owns a DataFile whose reads are queued and executed one after
+* another by its I/O thread. The read methods return at once with an AsyncRead
+* (e.g. to keep a user interface responsive), the other methods are executed in the
+* calling thread, also while a read is in progress (cancel it to switch data quickly). The metadata passed to reads must be kept until they are
+* finished. H5 calls of all AsyncFile objects take turns with the H5 calls of other
+* files (see DataFile).
+*/
+class AsyncFile {
+public:
+    /** Cancels all reads, waits for a running read to stop and closes the file.
+     * The AsyncRead objects remain valid and must be deleted.
+     */
+    virtual ~AsyncFile(){};
+
+    /** Open a data file for asynchronous reads.
+     * \param name name of file to open
+     * \param options open options
+     * \return AsyncFile object (delete after use)
+     */
+    static AsyncFile* openFile(const std::string& name, const OpenOptions& options=OpenOptions());
+
+    /** see DataFile::getChains()
+     * \return list of chains
+     */
+    virtual std::vector<int> getChains()=0;
+
+    /** see DataFile::getChain()
+     * \return id of selected chain
+     */
+    virtual int getChain()=0;
+
+    /** see DataFile::setChain(), reads queued before read the data of their metadata
+     * \param chain id of an available chain
+     */
+    virtual void setChain(int chain)=0;
+
+    /** see DataFile::getMetaData()
+     * \return list of metadata (delete after use)
+     */
+    virtual std::vector<MetaData *> getMetaData(Section section, std::string id="", std::string name="")=0;
+
+    /** queue DataFile::getData(std::vector<MetaData*>&)
+     * \param metadatalist list of metadata to retrieve data for
+     * \param done called when the read is finished (may be empty)
+     * \return AsyncRead object (delete after use)
+     */
+    virtual AsyncRead* getData(std::vector<MetaData*>& metadatalist, const ReadCallback& done=ReadCallback())=0;
+
+    /** queue DataFile::getData(std::vector<MetaData*>&, const Selection&)
+     * \param metadatalist list of metadata to retrieve data for
+     * \param selection rows to retrieve
+     * \param done called when the read is finished (may be empty)
+     * \return AsyncRead object (delete after use)
+     */
+    virtual AsyncRead* getData(std::vector<MetaData*>& metadatalist, const Selection& selection, const ReadCallback& done=ReadCallback())=0;
+
+    /** queue DataFile::getJoinedData(std::vector<MetaData*>&, FillRule)
+     * \param metadatalist list of metadata to retrieve data for
+     * \param fill desired fill rule
+     * \param done called when the read is finished (may be empty)
+     * \return AsyncRead object (delete after use)
+     */
+    virtual AsyncRead* getJoinedData(std::vector<MetaData*>& metadatalist, FillRule fill=NoFill, const ReadCallback& done=ReadCallback())=0;
+
+    /** queue DataFile::getPreferredData()
+     * \param fill desired fill rule
+     * \param done called when the read is finished (may be empty)
+     * \return AsyncRead object (delete after use)
+     */
+    virtual AsyncRead* getPreferredData(FillRule fill=NoFill, const ReadCallback& done=ReadCallback())=0;
+
+    /** queue DataFile::getLogData(), retrieve the log with AsyncRead::getLogData()
+     * \param done called when the read is finished (may be empty)
+     * \return AsyncRead object (delete after use)
+     */
+    virtual AsyncRead* getLogData(const ReadCallback& done=ReadCallback())=0;
+
+    /** cancel all queued and running reads
+     */
+    virtual void cancelAll()=0;
+};
+
+/** NaN-aware statistics of the values of a data object (see DataCompute::statistics)
+*
+*/
+struct Statistics
+{
+    Statistics() : count(0), missing(0), minimum(std::numeric_limits<double>::quiet_NaN()),
+        maximum(std::numeric_limits<double>::quiet_NaN()), sum(0.0), mean(std::numeric_limits<double>::quiet_NaN()) {};
+
+    size_t count;       /**< number of values used */
+    size_t missing;     /**< number of rows skipped (without value or NaN) */
+    double minimum;     /**< smallest value (NaN if count is 0) */
+    double maximum;     /**< largest value (NaN if count is 0) */
+    double sum;         /**< sum of the values */
+    double mean;        /**< mean value (NaN if count is 0) */
+};
+
+/** histogram with bins of equal width (see DataCompute::histogram)
+*
+*/
+struct Histogram
+{
+    Histogram() : low(0.0), high(0.0), underflow(0), overflow(0) {};
+
+    double low;                     /**< lower edge of the first bin */
+    double high;                    /**< upper edge of the last bin */
+    std::vector<size_t> counts;     /**< number of values in each bin, bin i starts at low + i * (high - low) / counts.size() */
+    size_t underflow;               /**< number of values below low */
+    size_t overflow;                /**< number of values at or above high */
+};
+
+/** computations on the values of data objects inside the library
+*
+* The values are used in place, integer values are computed as double. Rows without
+* value (see Data::isValid()) and NaN values are skipped. Data objects returned have
+* the metadata of the source, DTfloat64 values (rows without result are marked invalid)
+* and must be deleted after use. Unsuitable data (strings, array data for scalar
+* operations or vice versa) throws a runtime_error.
+*/
+class DataCompute {
+public:
+    /** divide the values of data by the values of normalizer with the same position references.
+     * Only position references of both objects are kept, a row without value in either is invalid.
+     * Division by 0 gives inf or NaN.
+     * \param data values to normalize (not array data)
+     * \param normalizer values to divide by, e.g. the data of data->getNormalizeId() (not array data)
+     * \return normalized data, getNormalizeId() is the id of normalizer (delete after use)
+     */
+    static Data* normalize(Data* data, Data* normalizer);
+
+    /** get minimum, maximum, sum and mean of the values.
+     * \param data values (not array data)
+     * \return statistics of the valid values which aren't NaN
+     */
+    static Statistics statistics(Data* data);
+
+    /** count the values into bins of equal width.
+     * \param data values (not array data)
+     * \param low lower edge of the first bin
+     * \param high upper edge of the last bin (must be larger than low)
+     * \param bins number of bins (> 0)
+     * \return histogram of the valid values which aren't NaN
+     */
+    static Histogram histogram(Data* data, double low, double high, unsigned int bins);
+
+    /** sum the elements of the array of every position.
+     * \param data array data
+     * \return one value per position reference, invalid for positions without array (delete after use)
+     */
+    static Data* arraySum(Data* data);
+
+    /** sum the elements of a region of interest of the array of every position.
+     * \param data array data
+     * \param first first element of the region
+     * \param last element after the region (limited to the array size)
+     * \return one value per position reference, invalid for positions without array (delete after use)
+     */
+    static Data* regionSum(Data* data, unsigned int first, unsigned int last);
+
+    /** sum the arrays of all positions element by element.
+     * \param data array data
+     * \return one value per array element (getDimension().second values)
+     */
+    static std::vector<double> projection(Data* data);
 };
 
 } // namespace end
@@ -12,7 +12,7 @@ TEMPLATE = lib
 VERSION += 6.0.3
 DEFINES += EVEH5_LIBRARY
 
-CONFIG += dll
+CONFIG += dll thread
 
 QMAKE_CXXFLAGS += -std=c++11
 
@@ -27,7 +27,22 @@ SOURCES += \
     ih5filev5.cpp \
     attributemetadata.cpp \
     ifilemetadata.cpp \
-    ichainmetadata.cpp
+    ichainmetadata.cpp \
+    metadataindex.cpp \
+    datacache.cpp \
+    idatastream.cpp \
+    ijoinedstream.cpp \
+    inventoryfile.cpp \
+    ifilebatch.cpp \
+    icolumnartable.cpp \
+    stringcolumn.cpp \
+    resultarena.cpp \
+    iresultset.cpp \
+    datacompute.cpp \
+    iasyncfile.cpp \
+    h5lock.cpp \
+    iprefetcher.cpp \
+    icallstats.cpp
 
 HEADERS += \
     eve.h \
@@ -41,7 +56,22 @@ HEADERS += \
     ih5filev5.h \
     attributemetadata.h \
     ifilemetadata.h \
-    ichainmetadata.h
+    ichainmetadata.h \
+    metadataindex.h \
+    datacache.h \
+    idatastream.h \
+    ijoinedstream.h \
+    inventoryfile.h \
+    ifilebatch.h \
+    icolumnartable.h \
+    stringcolumn.h \
+    resultarena.h \
+    iresultset.h \
+    datacompute.h \
+    iasyncfile.h \
+    h5lock.h \
+    iprefetcher.h \
+    icallstats.h
 
 #linux-g++-32 {
 #    LIBS +=  -L/home/eden/src/hdf5/hdf5-1.8.9/hdf5/lib-static
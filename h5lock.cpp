@@ -0,0 +1,10 @@
+#include "h5lock.h"
+
+namespace eve {
+
+recursive_mutex& h5Mutex(){
+    static recursive_mutex h5mutex;
+    return h5mutex;
+}
+
+} // namespace end
@@ -0,0 +1,20 @@
+#ifndef H5LOCK_H
+#define H5LOCK_H
+
+#include <mutex>
+
+using namespace std;
+
+namespace eve {
+
+// The H5 library isn't thread-safe: all H5 calls of DataFile, AsyncFile and FileBatch
+// objects and their streams are made with this lock held. It is held for the H5 calls
+// only, decoding and joining run without it. It is recursive, the H5 functions of a file
+// may call each other. The inventory lock of a file is taken before this one.
+recursive_mutex& h5Mutex();
+
+typedef lock_guard<recursive_mutex> H5Lock;
+
+} // namespace end
+
+#endif // H5LOCK_H
@@ -0,0 +1,226 @@
+#include <chrono>
+#include <stdexcept>
+#include "iasyncfile.h"
+#include "IFile.h"
+
+namespace eve {
+
+AsyncFile* AsyncFile::openFile(const string& name, const OpenOptions& options){
+    return new IAsyncFile(name, options);
+}
+
+IAsyncRead::~IAsyncRead(){
+    cancel();
+    unique_lock<mutex> lock(task->stateMutex);
+    task->stateCond.wait(lock, [&]{return task->done;});
+    if (!task->taken)
+        for (Data* data : task->data) delete data;
+    task->data.clear();
+}
+
+bool IAsyncRead::isFinished(){
+    lock_guard<mutex> lock(task->stateMutex);
+    return task->finished;
+}
+
+void IAsyncRead::wait(){
+    unique_lock<mutex> lock(task->stateMutex);
+    task->stateCond.wait(lock, [&]{return task->finished;});
+}
+
+bool IAsyncRead::waitFor(unsigned int milliseconds){
+    unique_lock<mutex> lock(task->stateMutex);
+    return task->stateCond.wait_for(lock, chrono::milliseconds(milliseconds), [&]{return task->finished;});
+}
+
+bool IAsyncRead::isCancelled(){
+    lock_guard<mutex> lock(task->stateMutex);
+    return task->finished && task->stopped;
+}
+
+ReadProgress IAsyncRead::getProgress(){
+    ReadProgress progress;
+    progress.datasetsDone = task->control.datasetsDone;
+    progress.datasetsTotal = task->datasetsTotal;
+    progress.rowsDone = task->control.rowsDone;
+    progress.rowsTotal = task->control.rowsTotal;
+    return progress;
+}
+
+// throws the error of a finished task, stateMutex must be held
+void IAsyncRead::checkResult(){
+    if (task->stopped) throw runtime_error("Read cancelled");
+    if (!task->error.empty()) throw runtime_error(task->error);
+}
+
+vector<Data*> IAsyncRead::getData(){
+    wait();
+    lock_guard<mutex> lock(task->stateMutex);
+    checkResult();
+    vector<Data*> data;
+    if (task->taken) return data;
+    task->taken = true;
+    data.swap(task->data);
+    return data;
+}
+
+vector<string> IAsyncRead::getLogData(){
+    wait();
+    lock_guard<mutex> lock(task->stateMutex);
+    checkResult();
+    return task->log;
+}
+
+IAsyncFile::IAsyncFile(const string& name, const OpenOptions& options) : stopping(false)
+{
+    file = new IFile(name, options);
+    worker = thread(&IAsyncFile::work, this);
+}
+
+IAsyncFile::~IAsyncFile(){
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+        if (running.get() != NULL) running->control.cancelled = true;
+    }
+    queueCond.notify_all();
+    worker.join();
+    // reads not started are finished as cancelled
+    for (shared_ptr<AsyncTask>& task : tasks){
+        task->stopped = true;
+        finish(*task);
+    }
+    delete file;
+}
+
+vector<int> IAsyncFile::getChains(){
+    return file->getChains();
+}
+
+int IAsyncFile::getChain(){
+    return file->getChain();
+}
+
+void IAsyncFile::setChain(int chain){
+    file->setChain(chain);
+}
+
+vector<MetaData *> IAsyncFile::getMetaData(Section section, string id, string name){
+    return file->getMetaData(section, id, name);
+}
+
+AsyncRead* IAsyncFile::getData(vector<MetaData*>& mdvec, const ReadCallback& done){
+    IFile* ifile = file;
+    vector<MetaData*> mdlist = mdvec;
+    return queue([ifile, mdlist](AsyncTask& task) mutable {task.data = ifile->getData(mdlist);}, mdvec.size(), done);
+}
+
+AsyncRead* IAsyncFile::getData(vector<MetaData*>& mdvec, const Selection& selection, const ReadCallback& done){
+    IFile* ifile = file;
+    vector<MetaData*> mdlist = mdvec;
+    return queue([ifile, mdlist, selection](AsyncTask& task) mutable {task.data = ifile->getData(mdlist, selection);}, mdvec.size(), done);
+}
+
+AsyncRead* IAsyncFile::getJoinedData(vector<MetaData*>& mdvec, FillRule fill, const ReadCallback& done){
+    IFile* ifile = file;
+    vector<MetaData*> mdlist = mdvec;
+    return queue([ifile, mdlist, fill](AsyncTask& task) mutable {task.data = ifile->getJoinedData(mdlist, fill);}, mdvec.size(), done);
+}
+
+AsyncRead* IAsyncFile::getPreferredData(FillRule fill, const ReadCallback& done){
+    IFile* ifile = file;
+    return queue([ifile, fill](AsyncTask& task){task.data = ifile->getPreferredData(fill);}, 0, done);
+}
+
+AsyncRead* IAsyncFile::getLogData(const ReadCallback& done){
+    IFile* ifile = file;
+    return queue([ifile](AsyncTask& task){task.log = ifile->getLogData();}, 0, done);
+}
+
+void IAsyncFile::cancelAll(){
+    lock_guard<mutex> lock(queueMutex);
+    for (shared_ptr<AsyncTask>& task : tasks) task->control.cancelled = true;
+    if (running.get() != NULL) running->control.cancelled = true;
+}
+
+AsyncRead* IAsyncFile::queue(function<void(AsyncTask&)> read, size_t datasets, const ReadCallback& done){
+    shared_ptr<AsyncTask> task = make_shared<AsyncTask>();
+    task->read = read;
+    task->callback = done;
+    task->datasetsTotal = datasets;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        tasks.push_back(task);
+    }
+    queueCond.notify_one();
+    return new IAsyncRead(task);
+}
+
+void IAsyncFile::work(){
+    while (true){
+        shared_ptr<AsyncTask> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCond.wait(lock, [&]{return stopping || !tasks.empty();});
+            if (stopping) return;
+            task = tasks.front();
+            tasks.pop_front();
+            running = task;
+        }
+        execute(*task);
+        {
+            lock_guard<mutex> lock(queueMutex);
+            running.reset();
+        }
+        finish(*task);
+    }
+}
+
+// run the read of task, a cancelled read deletes the data read so far.
+// The read control is set for the reads of the I/O thread only.
+void IAsyncFile::execute(AsyncTask& task){
+    if (task.control.cancelled){
+        task.stopped = true;
+        return;
+    }
+    file->setReadControl(&task.control);
+    try {
+        task.read(task);
+    }
+    catch (ReadCancelled&){
+        task.stopped = true;
+    }
+    catch (std::exception& error){
+        task.error = error.what();
+    }
+    catch (H5::Exception& error){
+        task.error = "H5 Error: " + error.getDetailMsg();
+    }
+    catch (...){
+        task.error = "Unknown error while reading";
+    }
+    file->setReadControl(NULL);
+}
+
+// make the result available and call the callback
+void IAsyncFile::finish(AsyncTask& task){
+    {
+        lock_guard<mutex> lock(task.stateMutex);
+        task.finished = true;
+    }
+    task.stateCond.notify_all();
+    if (task.callback){
+        try {
+            task.callback();
+        }
+        catch (...){
+        }
+    }
+    {
+        lock_guard<mutex> lock(task.stateMutex);
+        task.done = true;
+    }
+    task.stateCond.notify_all();
+}
+
+} // namespace end
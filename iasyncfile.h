@@ -0,0 +1,94 @@
+#ifndef IASYNCFILE_H
+#define IASYNCFILE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "eve.h"
+#include "IH5File.h"
+
+using namespace std;
+
+namespace eve {
+
+class IFile;
+
+// state of a read shared by the AsyncRead handle and the I/O thread
+struct AsyncTask
+{
+    AsyncTask() : datasetsTotal(0), finished(false), done(false), stopped(false), taken(false) {};
+    function<void(AsyncTask&)> read;    // called in the I/O thread, sets data or log
+    ReadCallback callback;
+    ReadControl control;
+    size_t datasetsTotal;
+    vector<Data*> data;
+    vector<string> log;
+    string error;
+    bool finished;                      // result is available
+    bool done;                          // callback has returned
+    bool stopped;                       // cancelled before finished
+    bool taken;                         // data retrieved by getData()
+    mutex stateMutex;
+    condition_variable stateCond;
+};
+
+// handle of an AsyncTask, see AsyncRead
+class IAsyncRead : public AsyncRead
+{
+public:
+    IAsyncRead(shared_ptr<AsyncTask> readTask) : task(readTask) {};
+    virtual ~IAsyncRead();
+    bool isFinished();
+    void wait();
+    bool waitFor(unsigned int milliseconds);
+    void cancel(){task->control.cancelled = true;};
+    bool isCancelled();
+    ReadProgress getProgress();
+    vector<Data*> getData();
+    vector<string> getLogData();
+
+private:
+    void checkResult();
+    shared_ptr<AsyncTask> task;
+};
+
+// DataFile with an I/O thread executing the queued reads, see AsyncFile
+class IAsyncFile : public AsyncFile
+{
+public:
+    IAsyncFile(const string& name, const OpenOptions& options);
+    virtual ~IAsyncFile();
+    vector<int> getChains();
+    int getChain();
+    void setChain(int chain);
+    vector<MetaData *> getMetaData(Section section, string id, string name);
+    AsyncRead* getData(vector<MetaData*>& mdvec, const ReadCallback& done);
+    AsyncRead* getData(vector<MetaData*>& mdvec, const Selection& selection, const ReadCallback& done);
+    AsyncRead* getJoinedData(vector<MetaData*>& mdvec, FillRule fill, const ReadCallback& done);
+    AsyncRead* getPreferredData(FillRule fill, const ReadCallback& done);
+    AsyncRead* getLogData(const ReadCallback& done);
+    void cancelAll();
+
+private:
+    AsyncRead* queue(function<void(AsyncTask&)> read, size_t datasets, const ReadCallback& done);
+    void work();
+    void execute(AsyncTask& task);
+    static void finish(AsyncTask& task);
+
+    IFile* file;
+    bool stopping;
+    deque<shared_ptr<AsyncTask>> tasks;
+    shared_ptr<AsyncTask> running;
+    mutex queueMutex;
+    condition_variable queueCond;
+    thread worker;
+};
+
+} // namespace end
+
+#endif // IASYNCFILE_H
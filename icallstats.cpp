@@ -0,0 +1,31 @@
+#include "icallstats.h"
+
+namespace eve {
+
+thread_local ReadStats* threadStats = NULL;
+
+StatsScope::StatsScope(const StatsCallback& callback, const char* call) : active(callback), callback(callback), call(call), previous(threadStats)
+{
+    if (!active) return;
+    threadStats = &stats;
+    start = chrono::steady_clock::now();
+}
+
+StatsScope::~StatsScope(){
+    if (!active) return;
+    threadStats = previous;
+    CallStats report;
+    report.call = call;
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report.bytesRead = stats.bytesRead;
+    report.datasetsOpened = stats.datasetsOpened;
+    report.allocations = stats.allocations;
+    // the call has ended, errors of the callback are not reported
+    try {
+        callback(report);
+    }
+    catch (...){
+    }
+}
+
+} // namespace end
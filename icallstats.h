@@ -0,0 +1,47 @@
+#ifndef ICALLSTATS_H
+#define ICALLSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include "eve.h"
+
+using namespace std;
+
+namespace eve {
+
+// counters of the DataFile call running in a thread (see DataFile::setStatsCallback)
+struct ReadStats {
+    ReadStats() : bytesRead(0), datasetsOpened(0), allocations(0) {};
+    atomic<size_t> bytesRead;
+    atomic<size_t> datasetsOpened;
+    atomic<size_t> allocations;     // also counted by decode workers
+};
+
+// counters of the call running in this thread, NULL if the call isn't counted
+extern thread_local ReadStats* threadStats;
+
+inline void countOpened(){if (threadStats != NULL) ++threadStats->datasetsOpened;}
+inline void countRead(size_t bytes){if (threadStats != NULL) threadStats->bytesRead += bytes;}
+inline void countAllocated(size_t buffers=1){if (threadStats != NULL) threadStats->allocations += buffers;}
+
+// counts one call of IFile (if a stats callback is set) and reports it when the call ends
+class StatsScope
+{
+public:
+    StatsScope(const StatsCallback& callback, const char* call);
+    ~StatsScope();
+
+private:
+    StatsScope(const StatsScope&);
+    StatsScope& operator=(const StatsScope&);
+    bool active;
+    StatsCallback callback;
+    const char* call;
+    ReadStats stats;
+    ReadStats* previous;
+    chrono::steady_clock::time_point start;
+};
+
+} // namespace end
+
+#endif // ICALLSTATS_H
@@ -0,0 +1,283 @@
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sstream>
+#include <stdexcept>
+#include "icolumnartable.h"
+
+#define STHROW(msg) { \
+     ostringstream err;\
+     err<<msg; \
+     throw runtime_error(err.str()); }
+
+#define COLUMNARMAGIC "EVECOLS1"
+#define COLUMNARALIGN 64
+
+namespace eve {
+
+static uint64_t align(uint64_t offset){
+    return (offset + COLUMNARALIGN - 1) / COLUMNARALIGN * COLUMNARALIGN;
+}
+
+// copy the validity of data (all rows valid if empty) into the LSB-first bitmap of rows rows
+static void copyValidity(const DataView<unsigned long long>& valid, unsigned char* bitmap, size_t rows){
+    size_t bytes = (rows + 7) / 8;
+    for (size_t i = 0; i < bytes; ++i){
+        if (valid.empty())
+            bitmap[i] = 0xff;
+        else if (i / 8 < valid.size())
+            bitmap[i] = (unsigned char)(valid[i / 8] >> (8 * (i % 8)));
+    }
+    if ((rows % 8) != 0) bitmap[bytes - 1] &= (unsigned char)((1 << (rows % 8)) - 1);
+}
+
+// storage type of data
+static eve::DataType columnType(Data* data){
+    eve::DataType type = data->getDataType();
+    if ((type == DTfloat64) || (type == DTfloat32)) return DTfloat64;
+    if (type == DTstring) return DTstring;
+    return DTint32;
+}
+
+// build the image from the rows of joined data (all with the same posReferences),
+// the validity bitmaps are taken from the data, values of invalid rows are zero
+IColumnarTable::IColumnarTable(const vector<Data*>& joined){
+
+    vector<Data*> columns;
+    for (Data* data : joined)
+        if (!data->isArrayData()) columns.push_back(data);
+    vector<int> posRefs;
+    if (!columns.empty()) posRefs = columns[0]->getPosReferences();
+    uint64_t rows = posRefs.size();
+    uint64_t bitmapBytes = (rows + 7) / 8;
+
+    // layout: header, directory, posRefs, per column id, values, validity, characters
+    vector<ColumnarEntry> directory(columns.size());
+    vector<StringColumnView> strings(columns.size());
+    vector<DataView<unsigned long long>> validity(columns.size());
+    uint64_t offset = align(sizeof(ColumnarHeader) + columns.size() * sizeof(ColumnarEntry));
+    uint64_t posRefOffset = offset;
+    offset = align(offset + rows * sizeof(int32_t));
+    for (size_t col = 0; col < columns.size(); ++col){
+        ColumnarEntry& centry = directory[col];
+        memset(&centry, 0, sizeof(centry));
+        string id = columns[col]->getId();
+        centry.type = columnType(columns[col]);
+        centry.idBytes = id.size();
+        centry.idOffset = offset;
+        offset = align(offset + id.size());
+        centry.valuesOffset = offset;
+        if (centry.type == DTint32)
+            offset = align(offset + rows * sizeof(int32_t));
+        else if (centry.type == DTfloat64)
+            offset = align(offset + rows * sizeof(double));
+        else
+            offset = align(offset + (rows + 1) * sizeof(int64_t));
+        centry.validityOffset = offset;
+        offset = align(offset + bitmapBytes);
+        validity[col] = columns[col]->getValidity();
+        if (centry.type == DTstring){
+            strings[col] = columns[col]->getStringColumn();
+            centry.charsOffset = offset;
+            for (size_t row = 0; row < strings[col].size(); ++row)
+                centry.charsBytes += strings[col][row].size();
+            offset = align(offset + centry.charsBytes);
+        }
+    }
+    imageBytes = offset;
+
+    char* buffer = new char[imageBytes]();
+    image = shared_ptr<const char>(buffer, default_delete<const char[]>());
+    ColumnarHeader* head = (ColumnarHeader*)buffer;
+    memcpy(head->magic, COLUMNARMAGIC, sizeof(head->magic));
+    head->rows = rows;
+    head->columns = columns.size();
+    head->posRefOffset = posRefOffset;
+    head->directoryOffset = sizeof(ColumnarHeader);
+    head->imageBytes = imageBytes;
+    header = head;
+    if (rows > 0) memcpy(buffer + posRefOffset, posRefs.data(), rows * sizeof(int32_t));
+
+    for (size_t col = 0; col < columns.size(); ++col){
+        ColumnarEntry& centry = directory[col];
+        string id = columns[col]->getId();
+        memcpy(buffer + centry.idOffset, id.data(), id.size());
+        unsigned char* bitmap = (unsigned char*)buffer + centry.validityOffset;
+        copyValidity(validity[col], bitmap, rows);
+        if (centry.type == DTint32){
+            DataView<int> values = columns[col]->getIntView();
+            int32_t* dst = (int32_t*)(buffer + centry.valuesOffset);
+            for (size_t row = 0; (row < values.size()) && (row < rows); ++row)
+                if (bitmap[row / 8] & (1 << (row % 8))) dst[row] = values[row];
+        }
+        else if (centry.type == DTfloat64){
+            DataView<double> values = columns[col]->getDoubleView();
+            double* dst = (double*)(buffer + centry.valuesOffset);
+            for (size_t row = 0; (row < values.size()) && (row < rows); ++row)
+                if (bitmap[row / 8] & (1 << (row % 8))) dst[row] = values[row];
+        }
+        else {
+            StringColumnView& values = strings[col];
+            int64_t* offsets = (int64_t*)(buffer + centry.valuesOffset);
+            char* chars = buffer + centry.charsOffset;
+            int64_t used = 0;
+            for (size_t row = 0; row < rows; ++row){
+                offsets[row] = used;
+                if (row >= values.size()) continue;
+                StringRef value = values[row];
+                memcpy(chars + used, value.data(), value.size());
+                used += value.size();
+            }
+            offsets[rows] = used;
+        }
+    }
+    memcpy(buffer + head->directoryOffset, directory.data(), directory.size() * sizeof(ColumnarEntry));
+}
+
+// table in a memory-mapped file
+IColumnarTable::IColumnarTable(shared_ptr<const char> mapped, size_t bytes) : image(mapped), imageBytes(bytes)
+{
+    header = (const ColumnarHeader*)image.get();
+    check();
+}
+
+ColumnarTable* ColumnarTable::mapFile(const string& filename){
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) STHROW("Unable to open columnar file " << filename);
+    struct stat status;
+    if ((fstat(fd, &status) != 0) || (status.st_size < (off_t)sizeof(ColumnarHeader))){
+        close(fd);
+        STHROW("Not a columnar file: " << filename);
+    }
+    size_t bytes = status.st_size;
+    void* mapping = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) STHROW("Unable to map columnar file " << filename);
+    shared_ptr<const char> image((const char*)mapping, [bytes](const char* ptr){munmap((void*)ptr, bytes);});
+    return new IColumnarTable(image, bytes);
+}
+
+// region of size bytes at offset lies within an image of total bytes, without overflow
+static bool within(uint64_t offset, uint64_t size, uint64_t total){
+    return (offset <= total) && (size <= total - offset);
+}
+
+// all offsets of a mapped image must lie within the image
+void IColumnarTable::check(){
+    if ((imageBytes < sizeof(ColumnarHeader)) || (memcmp(header->magic, COLUMNARMAGIC, sizeof(header->magic)) != 0))
+        STHROW("Not a columnar image");
+    uint64_t rows = header->rows;
+    uint64_t bitmapBytes = (rows + 7) / 8;
+    // rows and columns are bounded before they are multiplied by their width
+    bool valid = (header->imageBytes == imageBytes) && (rows <= imageBytes / sizeof(int32_t))
+            && (header->columns <= imageBytes / sizeof(ColumnarEntry))
+            && within(header->directoryOffset, header->columns * sizeof(ColumnarEntry), imageBytes)
+            && within(header->posRefOffset, rows * sizeof(int32_t), imageBytes)
+            && ((header->posRefOffset % sizeof(int64_t)) == 0) && ((header->directoryOffset % sizeof(int64_t)) == 0);
+    for (size_t col = 0; valid && (col < header->columns); ++col){
+        const ColumnarEntry& centry = entry(col);
+        uint64_t count = rows;
+        uint64_t width;
+        if (centry.type == DTint32) width = sizeof(int32_t);
+        else if (centry.type == DTfloat64) width = sizeof(double);
+        else if (centry.type == DTstring){
+            count = rows + 1;
+            width = sizeof(int64_t);
+        }
+        else {
+            valid = false;
+            break;
+        }
+        if (count > imageBytes / width){
+            valid = false;
+            break;
+        }
+        uint64_t valueBytes = count * width;
+        valid = within(centry.idOffset, centry.idBytes, imageBytes) && within(centry.valuesOffset, valueBytes, imageBytes)
+                && ((centry.valuesOffset % sizeof(int64_t)) == 0) && within(centry.validityOffset, bitmapBytes, imageBytes)
+                && within(centry.charsOffset, centry.charsBytes, imageBytes);
+        if (valid && (centry.type == DTstring)){
+            const int64_t* offsets = (const int64_t*)(image.get() + centry.valuesOffset);
+            for (uint64_t row = 0; valid && (row < rows); ++row)
+                valid = (offsets[row] >= 0) && (offsets[row] <= offsets[row + 1]);
+            valid = valid && ((uint64_t)offsets[rows] <= centry.charsBytes);
+        }
+    }
+    if (!valid) STHROW("Damaged columnar image");
+}
+
+const ColumnarEntry& IColumnarTable::entry(size_t col){
+    if (col >= header->columns) STHROW("Column index " << col << " out of range");
+    return ((const ColumnarEntry*)(image.get() + header->directoryOffset))[col];
+}
+
+DataView<int> IColumnarTable::getPosReferences(){
+    return DataView<int>(image, (const int*)(image.get() + header->posRefOffset), header->rows);
+}
+
+string IColumnarTable::getColumnId(size_t col){
+    const ColumnarEntry& centry = entry(col);
+    return string(image.get() + centry.idOffset, centry.idBytes);
+}
+
+eve::DataType IColumnarTable::getColumnType(size_t col){
+    return (eve::DataType)entry(col).type;
+}
+
+DataView<int> IColumnarTable::getIntColumn(size_t col){
+    const ColumnarEntry& centry = entry(col);
+    if (centry.type != DTint32) return DataView<int>();
+    return DataView<int>(image, (const int*)(image.get() + centry.valuesOffset), header->rows);
+}
+
+DataView<double> IColumnarTable::getDoubleColumn(size_t col){
+    const ColumnarEntry& centry = entry(col);
+    if (centry.type != DTfloat64) return DataView<double>();
+    return DataView<double>(image, (const double*)(image.get() + centry.valuesOffset), header->rows);
+}
+
+DataView<long long> IColumnarTable::getStringOffsets(size_t col){
+    const ColumnarEntry& centry = entry(col);
+    if (centry.type != DTstring) return DataView<long long>();
+    return DataView<long long>(image, (const long long*)(image.get() + centry.valuesOffset), header->rows + 1);
+}
+
+DataView<char> IColumnarTable::getStringChars(size_t col){
+    const ColumnarEntry& centry = entry(col);
+    if (centry.type != DTstring) return DataView<char>();
+    return DataView<char>(image, image.get() + centry.charsOffset, centry.charsBytes);
+}
+
+string IColumnarTable::getString(size_t col, size_t row){
+    const ColumnarEntry& centry = entry(col);
+    if ((centry.type != DTstring) || (row >= header->rows)) return string();
+    const int64_t* offsets = (const int64_t*)(image.get() + centry.valuesOffset);
+    return string(image.get() + centry.charsOffset + offsets[row], offsets[row + 1] - offsets[row]);
+}
+
+DataView<unsigned char> IColumnarTable::getValidity(size_t col){
+    const ColumnarEntry& centry = entry(col);
+    return DataView<unsigned char>(image, (const unsigned char*)(image.get() + centry.validityOffset), (header->rows + 7) / 8);
+}
+
+bool IColumnarTable::isValid(size_t col, size_t row){
+    if (row >= header->rows) return false;
+    const unsigned char* bitmap = (const unsigned char*)(image.get() + entry(col).validityOffset);
+    return (bitmap[row / 8] >> (row % 8)) & 1;
+}
+
+void IColumnarTable::write(const string& filename){
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (file == NULL) STHROW("Unable to create columnar file " << filename);
+    size_t written = fwrite(image.get(), 1, imageBytes, file);
+    if ((fclose(file) != 0) || (written != imageBytes)){
+        remove(filename.c_str());
+        STHROW("Error writing columnar file " << filename);
+    }
+}
+
+} // namespace end
@@ -0,0 +1,69 @@
+#ifndef ICOLUMNARTABLE_H
+#define ICOLUMNARTABLE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include "eve.h"
+
+using namespace std;
+
+namespace eve {
+
+// image layout, see ColumnarTable
+struct ColumnarHeader {
+    char magic[8];
+    uint64_t rows;
+    uint64_t columns;
+    uint64_t posRefOffset;
+    uint64_t directoryOffset;
+    uint64_t imageBytes;
+    uint64_t reserved[2];
+};
+
+struct ColumnarEntry {
+    uint32_t type;
+    uint32_t idBytes;
+    uint64_t idOffset;
+    uint64_t valuesOffset;
+    uint64_t validityOffset;
+    uint64_t charsOffset;
+    uint64_t charsBytes;
+    uint64_t reserved[2];
+};
+
+// columnar table in an image built from joined data or memory-mapped from a file
+class IColumnarTable : public ColumnarTable
+{
+public:
+    IColumnarTable(const vector<Data*>& joined);
+    IColumnarTable(shared_ptr<const char> mapped, size_t bytes);
+    virtual ~IColumnarTable(){};
+
+    size_t getRows(){return header->rows;};
+    size_t getColumns(){return header->columns;};
+    DataView<int> getPosReferences();
+    string getColumnId(size_t col);
+    eve::DataType getColumnType(size_t col);
+    DataView<int> getIntColumn(size_t col);
+    DataView<double> getDoubleColumn(size_t col);
+    DataView<long long> getStringOffsets(size_t col);
+    DataView<char> getStringChars(size_t col);
+    string getString(size_t col, size_t row);
+    DataView<unsigned char> getValidity(size_t col);
+    bool isValid(size_t col, size_t row);
+    void write(const string& filename);
+
+private:
+    const ColumnarEntry& entry(size_t col);
+    void check();
+
+    shared_ptr<const char> image;
+    size_t imageBytes;
+    const ColumnarHeader* header;
+};
+
+} // namespace end
+
+#endif // ICOLUMNARTABLE_H
@@ -0,0 +1,71 @@
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+#include "idatastream.h"
+#include "h5lock.h"
+
+#define STHROW(msg) { \
+     ostringstream err;\
+     err<<msg; \
+     throw runtime_error(err.str()); }
+
+namespace eve {
+
+IDataStream::IDataStream(IMetaData& mdata, DataSet dset, H5::DataType dtype, size_t elementSize, hsize_t rows,
+                         unsigned int chunkRows, void (*decode)(IData*, RawRecords&))
+    : metadata(mdata), h5dset(dset), h5dtype(dtype), elementSize(elementSize), rows(rows), position(0),
+      chunkRows(chunkRows), decode(decode)
+{
+}
+
+IDataStream::~IDataStream()
+{
+    // the handles are closed here, with the lock held
+    H5Lock lock(h5Mutex());
+    try {
+        h5dset.close();
+        h5dtype.close();
+    }
+    catch (Exception error){
+    }
+}
+
+Data* IDataStream::next(){
+
+    if (position >= rows) return NULL;
+
+    hsize_t count = rows - position;
+    if (count > chunkRows) count = chunkRows;
+    hsize_t offset = position;
+
+    RawRecords raw;
+    raw.buffer = shared_ptr<char>((char*)malloc(elementSize * count), free);
+    if (raw.buffer == NULL)
+        STHROW("Unable to allocate memory when reading Dataset " << metadata.getFQH5Name());
+    raw.elementSize = elementSize;
+    raw.count = count;
+    try {
+        H5Lock lock(h5Mutex());
+        DataSpace filespace = h5dset.getSpace();
+        filespace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+        DataSpace memspace(1, &count);
+        h5dset.read(raw.buffer.get(), h5dtype, memspace, filespace);
+    }
+    catch (Exception error){
+        STHROW("Error reading Dataset " << metadata.getFQH5Name() << " H5 Error: " << error.getDetailMsg() );
+    }
+
+    IData* block = new IData(metadata);
+    try {
+        decode(block, raw);
+    }
+    catch (...){
+        delete block;
+        throw;
+    }
+    block->dim0 = count;
+    position += count;
+    return block;
+}
+
+} // namespace end
@@ -0,0 +1,50 @@
+#ifndef IDATASTREAM_H
+#define IDATASTREAM_H
+
+#include <memory>
+#include "eve.h"
+#include "H5Cpp.h"
+#include "IData.h"
+#include "IMetaData.h"
+
+#ifndef H5_NO_NAMESPACE
+     using namespace H5;
+#endif
+
+using namespace std;
+
+namespace eve {
+
+// records of a dataset as read from file, decoded later
+struct RawRecords {
+    RawRecords() : elementSize(0), count(0) {};
+    shared_ptr<char> buffer;
+    size_t elementSize;
+    hsize_t count;
+};
+
+// reads a PC one or two column dataset with hyperslab selections of chunkRows rows
+class IDataStream : public DataStream
+{
+public:
+    IDataStream(IMetaData& mdata, DataSet dset, H5::DataType dtype, size_t elementSize, hsize_t rows,
+                unsigned int chunkRows, void (*decode)(IData*, RawRecords&));
+    virtual ~IDataStream();
+    virtual Data* next();
+    virtual unsigned long getRows(){return rows;};
+    virtual unsigned long getPosition(){return position;};
+
+private:
+    IMetaData metadata;
+    DataSet h5dset;
+    H5::DataType h5dtype;
+    size_t elementSize;
+    hsize_t rows;
+    hsize_t position;
+    unsigned int chunkRows;
+    void (*decode)(IData*, RawRecords&);
+};
+
+} // namespace end
+
+#endif // IDATASTREAM_H
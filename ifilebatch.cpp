@@ -0,0 +1,87 @@
+#include <stdexcept>
+#include "ifilebatch.h"
+#include "IFile.h"
+
+namespace eve {
+
+FileBatch* FileBatch::open(const vector<string>& files, const BatchSelection& selection, const OpenOptions& options, unsigned int threads){
+    return new IFileBatch(files, selection, options, threads);
+}
+
+IFileBatch::IFileBatch(const vector<string>& filelist, const BatchSelection& batchSelection, const OpenOptions& openOptions, unsigned int threads)
+    : files(filelist), selection(batchSelection), options(openOptions), nextFile(0), delivered(0), stopping(false)
+{
+    // the batch reads files in parallel, not the datasets of a file
+    options.decodeThreads = 0;
+    options.prefetch = false;
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > files.size()) threads = files.size();
+    maxFinished = 2 * threads;
+    for (unsigned int i = 0; i < threads; ++i) workers.push_back(thread(&IFileBatch::work, this));
+}
+
+IFileBatch::~IFileBatch(){
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    slotCond.notify_all();
+    for (thread& worker : workers) worker.join();
+    for (BatchResult& result : finished)
+        for (Data* data : result.data) delete data;
+}
+
+bool IFileBatch::next(BatchResult& result){
+    unique_lock<mutex> lock(queueMutex);
+    if (delivered >= files.size()) return false;
+    finishedCond.wait(lock, [&]{return !finished.empty();});
+    result = finished.front();
+    finished.pop_front();
+    ++delivered;
+    lock.unlock();
+    slotCond.notify_one();
+    return true;
+}
+
+void IFileBatch::work(){
+    while (true){
+        size_t index;
+        {
+            // don't read ahead more than maxFinished files of a slow consumer
+            unique_lock<mutex> lock(queueMutex);
+            slotCond.wait(lock, [&]{return stopping || (finished.size() < maxFinished);});
+            if (stopping || (nextFile >= files.size())) return;
+            index = nextFile++;
+        }
+        BatchResult result;
+        result.filename = files[index];
+        readFile(files[index], result);
+        {
+            lock_guard<mutex> lock(queueMutex);
+            finished.push_back(result);
+        }
+        finishedCond.notify_one();
+    }
+}
+
+// open, inventory and read a file, the H5 calls take the H5 lock
+void IFileBatch::readFile(const string& filename, BatchResult& result){
+    IFile* file = NULL;
+    try {
+        file = new IFile(filename, options);
+        result.data = file->getBatchData(selection);
+    }
+    catch (std::exception& error){
+        result.error = error.what();
+    }
+    catch (H5::Exception& error){
+        result.error = "Error reading file " + filename + "; H5 Error: " + error.getDetailMsg();
+    }
+    catch (...){
+        result.error = "Unknown error while reading file " + filename;
+    }
+    if (file != NULL) delete file;
+}
+
+} // namespace end
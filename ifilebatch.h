@@ -0,0 +1,44 @@
+#ifndef IFILEBATCH_H
+#define IFILEBATCH_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "eve.h"
+
+using namespace std;
+
+namespace eve {
+
+// worker pool reading files of a batch, see FileBatch
+class IFileBatch : public FileBatch
+{
+public:
+    IFileBatch(const vector<string>& files, const BatchSelection& selection, const OpenOptions& options, unsigned int threads);
+    virtual ~IFileBatch();
+    virtual bool next(BatchResult& result);
+
+private:
+    void work();
+    void readFile(const string& filename, BatchResult& result);
+
+    vector<string> files;
+    BatchSelection selection;
+    OpenOptions options;
+    size_t nextFile;            // next file to be read by a worker
+    size_t delivered;           // files returned by next()
+    size_t maxFinished;         // finished files kept until next() is called
+    bool stopping;
+    deque<BatchResult> finished;
+    mutex queueMutex;
+    condition_variable finishedCond;
+    condition_variable slotCond;
+    vector<thread> workers;
+};
+
+} // namespace end
+
+#endif // IFILEBATCH_H
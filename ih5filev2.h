@@ -10,7 +10,7 @@ class IH5FileV2 : public IH5File
 {
 public:
     IH5FileV2(H5::H5File, string, float version);
-    virtual string getSectionString(Section);
+    virtual string getSectionString(Section sect, int chain);
 
 
 };
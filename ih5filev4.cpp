@@ -9,8 +9,8 @@ IH5FileV4::IH5FileV4(H5::H5File oh5file, string filename, float version) : IH5Fi
 
 }
 
-string IH5FileV4::getSectionString(Section sect){
-    string chainname = "/c" + to_string(selectedChain);
+string IH5FileV4::getSectionString(Section sect, int chain){
+    string chainname = "/c" + to_string(chain);
     switch (sect) {
     case Standard:
         return chainname +"/main";
@@ -7,56 +7,39 @@ IH5FileV5::IH5FileV5(H5::H5File oh5file, string filename, float version) : IH5Fi
     sections = {"main", "snapshot", "meta"};
 }
 
-void IH5FileV5::addExtensionData(IData* data){
+void IH5FileV5::addExtensionData(const ChainInventory& inventory, IData* data, const ReadSelection* selection){
 
-    string fullh5name = data->getPath() + "averagemeta/" + data->getH5name() + "__AverageCount";
-    MetaData *extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCTwoCol(avdata);
-        copyAndFill(avdata, DTint32, INTVECT1, data, DTint32, AVCOUNT);
-        copyAndFill(avdata, DTint32, INTVECT2, data, DTint32, AVCOUNTPR);
-        delete avdata;
+    string fullh5name = data->getPath() + "averagemeta/" + data->getH5name();
+    shared_ptr<IData> avdata = readExtension(inventory, fullh5name + "__AverageCount", true, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTint32, INTVECT1, data, DTint32, AVCOUNT);
+        copyAndFill(avdata.get(), DTint32, INTVECT2, data, DTint32, AVCOUNTPR);
     }
-    fullh5name = data->getPath() + "averagemeta/" + data->getH5name() + "__Limit-MaxDev";
-    extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCTwoCol(avdata);
-        copyAndFill(avdata, DTfloat64, DBLVECT1, data, DTfloat64, AVLIMIT);
-        copyAndFill(avdata, DTfloat64, DBLVECT2, data, DTfloat64, AVMAXDEV);
-        delete avdata;
+    avdata = readExtension(inventory, fullh5name + "__Limit-MaxDev", true, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT1, data, DTfloat64, AVLIMIT);
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT2, data, DTfloat64, AVMAXDEV);
     }
-    fullh5name = data->getPath() + "averagemeta/" + data->getH5name() + "__Attempts";
-    extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCTwoCol(avdata);
-        copyAndFill(avdata, DTint32, INTVECT1, data, DTint32, AVATT);
-        copyAndFill(avdata, DTint32, INTVECT2, data, DTint32, AVATTPR);
-        delete avdata;
+    avdata = readExtension(inventory, fullh5name + "__Attempts", true, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTint32, INTVECT1, data, DTint32, AVATT);
+        copyAndFill(avdata.get(), DTint32, INTVECT2, data, DTint32, AVATTPR);
     }
-    fullh5name = data->getPath() + "standarddev/" + data->getH5name() + "__Count";
-    extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCOneCol(avdata);
-        copyAndFill(avdata, DTint32, INTVECT1, data, DTint32, STDDEVCOUNT);
-        delete avdata;
+    fullh5name = data->getPath() + "standarddev/" + data->getH5name();
+    avdata = readExtension(inventory, fullh5name + "__Count", false, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTint32, INTVECT1, data, DTint32, STDDEVCOUNT);
     }
-    fullh5name = data->getPath() + "standarddev/" + data->getH5name() + "__TrigIntv-StdDev";
-    extensionmd = findMetaData(extensionmeta, fullh5name);
-    if (extensionmd != NULL){
-        IData* avdata = new IData((IMetaData&)*extensionmd);
-        readDataPCTwoCol(avdata);
-        copyAndFill(avdata, DTfloat64, DBLVECT1, data, DTfloat64, TRIGGERINTV);
-        copyAndFill(avdata, DTfloat64, DBLVECT2, data, DTfloat64, STDDEV);
-        delete avdata;
+    avdata = readExtension(inventory, fullh5name + "__TrigIntv-StdDev", true, selection);
+    if (avdata != NULL){
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT1, data, DTfloat64, TRIGGERINTV);
+        copyAndFill(avdata.get(), DTfloat64, DBLVECT2, data, DTfloat64, STDDEV);
     }
 }
 
 vector<string> IH5FileV5::getLogData(){
 
+    H5Lock lock(h5Mutex());
     vector<string> stringlist;
     StrType tid1(0, H5T_VARIABLE);
     hid_t		native_type;
@@ -65,6 +48,7 @@ vector<string> IH5FileV5::getLogData(){
 
     try {
         h5dset = h5file.openDataSet("/LiveComment");
+        countOpened();
     }
     catch (Exception error) {
         return stringlist;
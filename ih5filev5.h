@@ -12,7 +12,7 @@ public:
     IH5FileV5(H5::H5File, string, float version);
 
 protected:
-    virtual void addExtensionData(IData* data);
+    virtual void addExtensionData(const ChainInventory& inventory, IData* data, const ReadSelection* selection=NULL);
     virtual vector<string> getLogData();
 };
 
@@ -0,0 +1,390 @@
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <climits>
+#include <cmath>
+#include "ijoinedstream.h"
+
+#define STHROW(msg) { \
+     ostringstream err;\
+     err<<msg; \
+     throw runtime_error(err.str()); }
+
+namespace eve {
+
+JoinSource::JoinSource(IData& shape, DataStream* stream, bool generating, bool dofill, IData* snapshot)
+    : shape(shape), stream(stream), deviceType(shape.getDeviceType()), generating(generating), dofill(dofill),
+      snapshot(snapshot), rows(stream->getRows()), base(0), started(false), idx(0), doLast(false), skippedPending(false),
+      tp(generating ? 0 : ULONG_MAX), warned(false), lastLoaded(INT_MIN), lastint(INT_MIN), lastdbl(NAN), lastintValid(false),
+      lastdblValid(false), laststrValid(false), block(NULL), intComplete(true), dblComplete(true), strComplete(true)
+{
+    for (auto const &vpair : shape.intsptrmap) ints[vpair.first];
+    for (auto const &vpair : shape.dblsptrmap) dbls[vpair.first];
+    for (auto const &vpair : shape.strsptrmap) strs[vpair.first];
+    int0 = (ints.find(0) != ints.end()) ? &ints.at(0) : NULL;
+    dbl0 = (dbls.find(0) != dbls.end()) ? &dbls.at(0) : NULL;
+    str0 = (strs.find(0) != strs.end()) ? &strs.at(0) : NULL;
+}
+
+JoinSource::~JoinSource()
+{
+    delete block;
+    delete snapshot;
+    delete stream;
+}
+
+// make row available in the window, read the next blocks of the stream if necessary
+bool JoinSource::loadRow(unsigned long row){
+
+    while (row >= base + posCounts.size()){
+        if (base + posCounts.size() >= rows) return false;
+        trim();
+        IData* data = (IData*)stream->next();
+        if (data == NULL) return false;
+        bool first = (base + posCounts.size() == 0);
+        for (int pc : data->posCounts){
+            if (!first && (pc < lastLoaded)){
+                delete data;
+                STHROW("Unable to join " << shape.getFQH5Name() << ": posCounts are not ascending, use getJoinedData");
+            }
+            if (!first && (pc == lastLoaded) && (deviceType == Axis) && !warned){
+                cout << "Warning: posrefs for axis " << shape.getId() << " are not unique, applying doublePosRef workaround" << endl;
+                warned = true;
+            }
+            lastLoaded = pc;
+            first = false;
+        }
+        posCounts.insert(posCounts.end(), data->posCounts.begin(), data->posCounts.end());
+        for (auto &vpair : ints) vpair.second.insert(vpair.second.end(), data->intsptrmap.at(vpair.first)->begin(), data->intsptrmap.at(vpair.first)->end());
+        for (auto &vpair : dbls) vpair.second.insert(vpair.second.end(), data->dblsptrmap.at(vpair.first)->begin(), data->dblsptrmap.at(vpair.first)->end());
+        for (auto &vpair : strs) {
+            // the window keeps the dictionary encoding of the stream
+            StringColumn& column = *data->strsptrmap.at(vpair.first);
+            if ((vpair.second.size() == 0) && (vpair.second.isDictionary() != column.isDictionary())) vpair.second = StringColumn(column.isDictionary());
+            vpair.second.append(column);
+        }
+        delete data;
+    }
+    return true;
+}
+
+// drop rows no longer needed: the join looks back one row before idx
+void JoinSource::trim(){
+
+    unsigned long keep = (tp < idx) ? tp : idx;
+    if (keep > 0) --keep;
+    if ((keep <= base) || ((keep - base) * 2 < posCounts.size())) return;
+
+    unsigned long count = keep - base;
+    posCounts.erase(posCounts.begin(), posCounts.begin() + count);
+    for (auto &vpair : ints) vpair.second.erase(vpair.second.begin(), vpair.second.begin() + count);
+    for (auto &vpair : dbls) vpair.second.erase(vpair.second.begin(), vpair.second.begin() + count);
+    for (auto &vpair : strs) vpair.second.erase(count);
+    base = keep;
+}
+
+// posCount of an axis appears more than once (rows with the same posCount are adjacent)
+bool JoinSource::isDoubleRow(unsigned long row){
+
+    if (deviceType != Axis) return false;
+    int pc = posCount(row);
+    if ((row > base) && (posCount(row - 1) == pc)) return true;
+    return haveRow(row + 1) && (posCount(row + 1) == pc);
+}
+
+unsigned long JoinSource::lastOfRun(unsigned long row){
+
+    int pc = posCount(row);
+    while (haveRow(row + 1) && (posCount(row + 1) == pc)) ++row;
+    return row;
+}
+
+// column 0 of row provides the fill values
+void JoinSource::setLast(unsigned long row){
+
+    if (int0 != NULL) {
+        lastint = (*int0)[row - base];
+        lastintValid = true;
+    }
+    if (dbl0 != NULL) {
+        lastdbl = (*dbl0)[row - base];
+        lastdblValid = true;
+    }
+    if (str0 != NULL) {
+        laststring = str0->str(row - base);
+        laststrValid = true;
+    }
+}
+
+// start value of the axis from the last snapshot before the first posCount
+void JoinSource::seed(int firstpc){
+
+    if ((snapshot == NULL) || snapshot->isArrayData()) return;
+    vector<int>& snap_pc = snapshot->posCounts;
+    if ((snap_pc.size() == 0) || (firstpc <= snap_pc[0])) return;
+
+    int snap_idx=0;
+    for (unsigned int i=0; i < snap_pc.size(); ++i) if (firstpc > snap_pc[i]) snap_idx = i;
+    if ((snapshot->getDataType() == DTint32) && (snapshot->intsptrmap.find(0) != snapshot->intsptrmap.end())) {
+        lastint = snapshot->intsptrmap.at(0)->at(snap_idx);
+        lastintValid = true;
+    }
+    else if ((snapshot->getDataType() == DTfloat64) && (snapshot->dblsptrmap.find(0) != snapshot->dblsptrmap.end())) {
+        lastdbl = snapshot->dblsptrmap.at(0)->at(snap_idx);
+        lastdblValid = true;
+    }
+    else if ((snapshot->getDataType() == DTstring) && (snapshot->strsptrmap.find(0) != snapshot->strsptrmap.end())) {
+        laststring = snapshot->strsptrmap.at(0)->str(snap_idx);
+        laststrValid = true;
+    }
+}
+
+bool JoinSource::head(int& posCount){
+
+    if (!haveRow(tp)) return false;
+    posCount = this->posCount(tp);
+    return true;
+}
+
+// move the head past posCount; the rows before the head are smaller than
+// the next posCount joined, the join would skip them anyway
+void JoinSource::consume(int posCount){
+
+    while (haveRow(tp) && (this->posCount(tp) == posCount)) ++tp;
+    fastForward();
+}
+
+void JoinSource::fastForward(){
+
+    if (rows == 0) return;
+    while ((idx < tp) && (idx < rows - 1)) {
+        ++idx;
+        skippedPending = true;
+        if (idx == rows - 1) doLast = true;
+    }
+}
+
+// append the row for newpc to the current block, same rules as the IData join constructor
+void JoinSource::join(int newpc){
+
+    if (!started){
+        if (dofill) seed(newpc);
+        started = true;
+    }
+    if (block == NULL) newBlock();
+
+    long srcidx = -1;
+    if ((rows > 0) && haveRow(idx)){
+        unsigned long last = rows - 1;
+        bool skippedValues = skippedPending;
+        skippedPending = false;
+        while((posCount(idx) < newpc) && (idx < last) && haveRow(idx + 1)) {
+            ++idx;
+            skippedValues = true;
+            if (idx == last) doLast = true;
+        }
+        // adjust fill values
+        if (dofill && (skippedValues || (doLast && (posCount(idx) < newpc)))){
+            unsigned long lastidx = idx;
+            if (skippedValues)
+                lastidx = idx - 1;
+            else
+                doLast = false;
+            if (isDoubleRow(idx)) lastidx = lastOfRun(idx);
+            setLast(lastidx);
+        }
+
+        // posCounts are ascending, newpc is either at idx or not in the dataset
+        if (posCount(idx) == newpc){
+            if (isDoubleRow(idx)) {
+                srcidx = lastOfRun(idx);
+            }
+            else {
+                srcidx = idx;
+                if (idx < last) {
+                    ++idx;
+                    if (idx == last) doLast = true;
+                }
+            }
+            if (dofill) setLast(srcidx);
+        }
+    }
+
+    // when filling an axis, all columns of a type having a column 0 get the last value of column 0,
+    // rows without value keep INT_MIN or NAN (strings remain empty) and are marked invalid
+    size_t blockRow = block->posCounts.size();
+    if ((blockRow % 64) == 0){
+        intValid.push_back(0);
+        dblValid.push_back(0);
+        strValid.push_back(0);
+    }
+    if (srcidx >= 0) {
+        unsigned long row = srcidx - base;
+        for (auto &cols : intCols) cols.second->push_back((*cols.first)[row]);
+        for (auto &cols : dblCols) cols.second->push_back((*cols.first)[row]);
+        for (auto &cols : strCols) cols.second->append(*cols.first, row);
+        setValidBit(intValid, blockRow);
+        setValidBit(dblValid, blockRow);
+        setValidBit(strValid, blockRow);
+    }
+    else {
+        bool fillint = dofill && (int0 != NULL) && lastintValid;
+        bool filldbl = dofill && (dbl0 != NULL) && lastdblValid;
+        bool fillstr = dofill && (str0 != NULL) && laststrValid;
+        for (auto &cols : intCols) cols.second->push_back(fillint ? lastint : INT_MIN);
+        for (auto &cols : dblCols) cols.second->push_back(filldbl ? lastdbl : NAN);
+        for (auto &cols : strCols) {
+            if (fillstr)
+                cols.second->append(laststring);
+            else
+                cols.second->appendEmpty();
+        }
+        if (fillint) setValidBit(intValid, blockRow);
+        if (filldbl) setValidBit(dblValid, blockRow);
+        if (fillstr) setValidBit(strValid, blockRow);
+        intComplete = intComplete && fillint;
+        dblComplete = dblComplete && filldbl;
+        strComplete = strComplete && fillstr;
+    }
+    block->posCounts.push_back(newpc);
+}
+
+void JoinSource::newBlock(){
+
+    block = new IData((IMetaData&)shape);
+    intCols.clear();
+    dblCols.clear();
+    strCols.clear();
+    intValid.clear();
+    dblValid.clear();
+    strValid.clear();
+    intComplete = dblComplete = strComplete = true;
+    for (auto &vpair : ints){
+        shared_ptr<vector<int>> column = make_shared<vector<int>>();
+        block->intsptrmap.insert(pair<int, shared_ptr<vector<int>>>(vpair.first, column));
+        intCols.push_back(make_pair(&vpair.second, column.get()));
+    }
+    for (auto &vpair : dbls){
+        shared_ptr<vector<double>> column = make_shared<vector<double>>();
+        block->dblsptrmap.insert(pair<int, shared_ptr<vector<double>>>(vpair.first, column));
+        dblCols.push_back(make_pair(&vpair.second, column.get()));
+    }
+    for (auto &vpair : strs){
+        shared_ptr<StringColumn> column = make_shared<StringColumn>(vpair.second.isDictionary());
+        block->strsptrmap.insert(pair<int, shared_ptr<StringColumn>>(vpair.first, column));
+        strCols.push_back(make_pair(&vpair.second, column.get()));
+    }
+}
+
+// all columns of a type share the validity of the block rows
+template <typename C>
+static void setValidity(const map<int, shared_ptr<C>>& columns, const vector<unsigned long long>& valid, bool complete,
+                        map<int, shared_ptr<vector<unsigned long long>>>& validmap){
+    if (complete || columns.empty()) return;
+    shared_ptr<vector<unsigned long long>> bitmap = make_shared<vector<unsigned long long>>(valid);
+    for (auto const &vpair : columns) validmap.insert(pair<int, shared_ptr<vector<unsigned long long>>>(vpair.first, bitmap));
+}
+
+IData* JoinSource::takeBlock(){
+
+    IData* data = block;
+    block = NULL;
+    if (data != NULL) {
+        data->dim0 = data->posCounts.size();
+        setValidity(data->intsptrmap, intValid, intComplete, data->intvalidmap);
+        setValidity(data->dblsptrmap, dblValid, dblComplete, data->dblvalidmap);
+        setValidity(data->strsptrmap, strValid, strComplete, data->strvalidmap);
+    }
+    return data;
+}
+
+IJoinedStream::IJoinedStream(vector<JoinSource*> sources, FillRule fill, unsigned int chunkRows)
+    : sources(sources), fillType(fill), chunkRows(chunkRows), started(false), finished(false)
+{
+}
+
+IJoinedStream::~IJoinedStream()
+{
+    for (JoinSource* source : sources) delete source;
+}
+
+// smallest head of the generating channels and/or axes
+bool IJoinedStream::minHead(bool channels, bool axes, int& posCount){
+
+    bool found = false;
+    for (JoinSource* source : sources){
+        int pc;
+        if (!source->isGenerating() || !((channels && source->isChannel()) || (axes && source->isAxis()))) continue;
+        if (!source->head(pc)) continue;
+        if (!found || (pc < posCount)) posCount = pc;
+        found = true;
+    }
+    return found;
+}
+
+// next posCount of the join: merge of the channels and/or axes posCounts, the intersection for NoFill
+bool IJoinedStream::nextTarget(int& target){
+
+    if (fillType == NoFill) {
+        while (true) {
+            int axisPC, channelPC;
+            if (!minHead(false, true, axisPC) || !minHead(true, false, channelPC)) return false;
+            if (axisPC == channelPC) {
+                target = axisPC;
+                return true;
+            }
+            bool skipAxes = axisPC < channelPC;
+            for (JoinSource* source : sources)
+                if (source->isGenerating() && (skipAxes ? source->isAxis() : source->isChannel()))
+                    source->consume(skipAxes ? axisPC : channelPC);
+        }
+    }
+    else if (fillType == LastFill)
+        return minHead(true, false, target);
+    else if (fillType == NANFill)
+        return minHead(false, true, target);
+    return minHead(true, true, target);
+}
+
+void IJoinedStream::consume(int target){
+    for (JoinSource* source : sources)
+        if (source->isGenerating()) source->consume(target);
+}
+
+vector<Data*> IJoinedStream::next(){
+
+    vector<Data*> datavect;
+    if (finished) return datavect;
+
+    if (!started) {
+        // no data if the posCounts defining the join are missing, like getJoinedData
+        started = true;
+        bool channelRows = false;
+        bool axisRows = false;
+        for (JoinSource* source : sources){
+            if (!source->isGenerating() || !source->hasRows()) continue;
+            if (source->isChannel()) channelRows = true;
+            if (source->isAxis()) axisRows = true;
+        }
+        if ((fillType == NoFill) ? !(channelRows && axisRows) : !(channelRows || axisRows)) {
+            finished = true;
+            return datavect;
+        }
+    }
+
+    int target;
+    unsigned int count = 0;
+    while ((count < chunkRows) && nextTarget(target)) {
+        for (JoinSource* source : sources) source->join(target);
+        consume(target);
+        ++count;
+    }
+    if (count == 0) {
+        finished = true;
+        return datavect;
+    }
+    for (JoinSource* source : sources) datavect.push_back(source->takeBlock());
+    return datavect;
+}
+
+} // namespace end
@@ -0,0 +1,112 @@
+#ifndef IJOINEDSTREAM_H
+#define IJOINEDSTREAM_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include "eve.h"
+#include "IData.h"
+#include "IMetaData.h"
+
+using namespace std;
+
+namespace eve {
+
+// one dataset of a joined stream: a window of rows read from its DataStream
+// and the state of the join (same rules as the IData join constructor)
+class JoinSource
+{
+public:
+    JoinSource(IData& shape, DataStream* stream, bool generating, bool dofill, IData* snapshot);
+    ~JoinSource();
+    bool isGenerating(){return generating;};
+    bool isChannel(){return deviceType == Channel;};
+    bool isAxis(){return deviceType == Axis;};
+    bool hasRows(){return rows > 0;};
+    bool head(int& posCount);
+    void consume(int posCount);
+    void join(int newpc);
+    IData* takeBlock();
+
+private:
+    bool haveRow(unsigned long row){return (row < base + posCounts.size()) || loadRow(row);};
+    bool loadRow(unsigned long row);
+    int posCount(unsigned long row){return posCounts[row - base];};
+    bool isDoubleRow(unsigned long row);
+    unsigned long lastOfRun(unsigned long row);
+    void setLast(unsigned long row);
+    void fastForward();
+    void trim();
+    void seed(int firstpc);
+    void newBlock();
+
+    IData shape;
+    DataStream* stream;
+    DeviceType deviceType;
+    bool generating;
+    bool dofill;
+    IData* snapshot;
+    unsigned long rows;
+
+    // window of rows [base, base + posCounts.size())
+    unsigned long base;
+    vector<int> posCounts;
+    map<int, vector<int>> ints;
+    map<int, vector<double>> dbls;
+    map<int, StringColumn> strs;
+    // column 0 of the window (NULL if the type has no column 0)
+    vector<int>* int0;
+    vector<double>* dbl0;
+    StringColumn* str0;
+
+    // join state
+    bool started;
+    unsigned long idx;
+    bool doLast;
+    bool skippedPending;
+    unsigned long tp;               // first row of the next head (generating sources)
+    bool warned;
+    int lastLoaded;
+    int lastint;
+    double lastdbl;
+    string laststring;
+    bool lastintValid;
+    bool lastdblValid;
+    bool laststrValid;
+
+    IData* block;
+    // validity of the rows of block per type
+    vector<unsigned long long> intValid;
+    vector<unsigned long long> dblValid;
+    vector<unsigned long long> strValid;
+    bool intComplete;
+    bool dblComplete;
+    bool strComplete;
+    vector<pair<vector<int>*, vector<int>*>> intCols;
+    vector<pair<vector<double>*, vector<double>*>> dblCols;
+    vector<pair<StringColumn*, StringColumn*>> strCols;
+};
+
+// cursor over joined data, see DataFile::openJoinedStream
+class IJoinedStream : public JoinedStream
+{
+public:
+    IJoinedStream(vector<JoinSource*> sources, FillRule fill, unsigned int chunkRows);
+    virtual ~IJoinedStream();
+    virtual vector<Data*> next();
+
+private:
+    bool nextTarget(int& target);
+    void consume(int target);
+    bool minHead(bool channels, bool axes, int& posCount);
+
+    vector<JoinSource*> sources;
+    FillRule fillType;
+    unsigned int chunkRows;
+    bool started;
+    bool finished;
+};
+
+} // namespace end
+
+#endif // IJOINEDSTREAM_H
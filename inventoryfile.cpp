@@ -0,0 +1,224 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include "inventoryfile.h"
+
+// increase if the layout changes, older inventory files are ignored
+#define INVENTORYFORMAT 2
+// longest string accepted when reading (a damaged length must not allocate gigabytes)
+#define INVENTORYMAXSTRING (1 << 24)
+#define INVENTORYMAGIC "EVEH5INV"
+
+namespace eve {
+
+static void writeInt(ostream& out, int64_t value){
+    out.write((const char*)&value, sizeof(value));
+}
+
+static void writeString(ostream& out, const string& value){
+    writeInt(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+static void writeAttributes(ostream& out, const map<string, string>& attributes){
+    writeInt(out, attributes.size());
+    for (auto const &attribute : attributes){
+        writeString(out, attribute.first);
+        writeString(out, attribute.second);
+    }
+}
+
+// readers return false for a damaged or truncated file
+static bool readInt(istream& in, int64_t& value){
+    in.read((char*)&value, sizeof(value));
+    return in.good();
+}
+
+static bool readString(istream& in, string& value){
+    int64_t length;
+    if (!readInt(in, length) || (length < 0) || (length > INVENTORYMAXSTRING)) return false;
+    value.resize(length);
+    if (length > 0) in.read(&value[0], length);
+    return in.good();
+}
+
+static bool readAttributes(istream& in, map<string, string>& attributes){
+    int64_t count;
+    if (!readInt(in, count) || (count < 0)) return false;
+    for (int64_t index = 0; index < count; ++index){
+        string name, value;
+        if (!readString(in, name) || !readString(in, value)) return false;
+        attributes[name] = value;
+    }
+    return true;
+}
+
+// the inventory of filename is saved in indexDir with a name made from the absolute path
+InventoryFile::InventoryFile(const string& indexDir, const string& filename, float version)
+    : h5version(version), mtime(0), ctime(0), inode(0), device(0), size(-1)
+{
+    char fullpath[PATH_MAX];
+    h5name = (realpath(filename.c_str(), fullpath) != NULL) ? string(fullpath) : filename;
+    ostringstream name;
+    name << indexDir << "/" << hex << hash<string>()(h5name) << ".eveinv";
+    indexName = name.str();
+
+    struct stat status;
+    if (stat(h5name.c_str(), &status) == 0){
+        mtime = status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+        ctime = status.st_ctim.tv_sec * 1000000000LL + status.st_ctim.tv_nsec;
+        inode = status.st_ino;
+        device = status.st_dev;
+        size = status.st_size;
+    }
+}
+
+// load the inventory, false if there is no valid inventory file
+bool InventoryFile::read(){
+
+    if (size < 0) return false;
+    ifstream in(indexName.c_str(), ios::binary);
+    if (!in.is_open()) return false;
+
+    string magic, name;
+    int64_t format, version, filetime, changetime, fileinode, filedevice, filesize, count;
+    if (!readString(in, magic) || (magic != INVENTORYMAGIC)) return false;
+    if (!readInt(in, format) || (format != INVENTORYFORMAT)) return false;
+    if (!readString(in, name) || (name != h5name)) return false;
+    if (!readInt(in, version) || (version != (int64_t)(h5version * 100))) return false;
+    if (!readInt(in, filetime) || (filetime != mtime)) return false;
+    if (!readInt(in, changetime) || (changetime != ctime)) return false;
+    if (!readInt(in, fileinode) || (fileinode != inode)) return false;
+    if (!readInt(in, filedevice) || (filedevice != device)) return false;
+    if (!readInt(in, filesize) || (filesize != size)) return false;
+
+    bool valid = readAttributes(in, rootAttributes) && readInt(in, count) && (count >= 0);
+    for (int64_t index = 0; valid && (index < count); ++index){
+        int64_t chain;
+        valid = readInt(in, chain);
+        if (valid) chainList.push_back(chain);
+    }
+    valid = valid && readInt(in, count) && (count >= 0);
+    for (int64_t index = 0; valid && (index < count); ++index){
+        int64_t chainId, hasTimestamp;
+        valid = readInt(in, chainId);
+        if (!valid) break;
+        Chain& chain = chains[chainId];
+        vector<IMetaData*> timestamp;
+        valid = readAttributes(in, chain.chainAttributes) && readMetaData(in, chain.chainmeta)
+                && readMetaData(in, chain.extensionmeta) && readInt(in, hasTimestamp)
+                && ((hasTimestamp == 0) || readMetaData(in, timestamp));
+        if (!timestamp.empty()) chain.timestampMeta = timestamp[0];
+    }
+    valid = valid && readMetaData(in, monitormeta);
+    if (!valid) {
+        deleteMetaData();
+        rootAttributes.clear();
+        chainList.clear();
+        chains.clear();
+    }
+    return valid;
+}
+
+// save the inventory, the inventory file is optional: write errors are ignored
+void InventoryFile::write(){
+
+    if (size < 0) return;
+    // written to a temporary file first, readers never see a partial inventory
+    string tempName = indexName + "." + to_string(getpid());
+    {
+        ofstream out(tempName.c_str(), ios::binary | ios::trunc);
+        if (!out.is_open()) return;
+        writeString(out, INVENTORYMAGIC);
+        writeInt(out, INVENTORYFORMAT);
+        writeString(out, h5name);
+        writeInt(out, (int64_t)(h5version * 100));
+        writeInt(out, mtime);
+        writeInt(out, ctime);
+        writeInt(out, inode);
+        writeInt(out, device);
+        writeInt(out, size);
+        writeAttributes(out, rootAttributes);
+        writeInt(out, chainList.size());
+        for (int chain : chainList) writeInt(out, chain);
+        writeInt(out, chains.size());
+        for (auto const &cpair : chains){
+            writeInt(out, cpair.first);
+            writeAttributes(out, cpair.second.chainAttributes);
+            writeMetaData(out, cpair.second.chainmeta);
+            writeMetaData(out, cpair.second.extensionmeta);
+            writeInt(out, (cpair.second.timestampMeta != NULL) ? 1 : 0);
+            if (cpair.second.timestampMeta != NULL) writeMetaData(out, vector<IMetaData*>(1, cpair.second.timestampMeta));
+        }
+        writeMetaData(out, monitormeta);
+        out.close();
+        if (out.fail()){
+            remove(tempName.c_str());
+            return;
+        }
+    }
+    if (rename(tempName.c_str(), indexName.c_str()) != 0) remove(tempName.c_str());
+}
+
+// delete the metadata read (if not handed over)
+void InventoryFile::deleteMetaData(){
+    for (auto& cpair : chains){
+        for (IMetaData* mdata : cpair.second.chainmeta) delete mdata;
+        cpair.second.chainmeta.clear();
+        for (IMetaData* mdata : cpair.second.extensionmeta) delete mdata;
+        cpair.second.extensionmeta.clear();
+        if (cpair.second.timestampMeta != NULL) delete cpair.second.timestampMeta;
+        cpair.second.timestampMeta = NULL;
+    }
+    for (IMetaData* mdata : monitormeta) delete mdata;
+    monitormeta.clear();
+}
+
+void InventoryFile::writeMetaData(ostream& out, const vector<IMetaData*>& mdlist){
+    writeInt(out, mdlist.size());
+    for (IMetaData* mdata : mdlist){
+        writeString(out, mdata->path);
+        writeString(out, mdata->calculation);
+        writeString(out, mdata->h5name);
+        writeInt(out, mdata->selSection);
+        writeAttributes(out, *mdata->attributes);
+        writeInt(out, mdata->datatype);
+        writeInt(out, mdata->dstype);
+        writeInt(out, mdata->dim0);
+        writeInt(out, mdata->dim1);
+        writeInt(out, mdata->h5dimensions[0]);
+        writeInt(out, mdata->h5dimensions[1]);
+    }
+}
+
+bool InventoryFile::readMetaData(istream& in, vector<IMetaData*>& mdlist){
+    int64_t count;
+    if (!readInt(in, count) || (count < 0)) return false;
+    for (int64_t index = 0; index < count; ++index){
+        string path, calculation, name;
+        map<string, string> attributes;
+        int64_t section, datatype, dstype, dim0, dim1, h5dim0, h5dim1;
+        if (!readString(in, path) || !readString(in, calculation) || !readString(in, name)
+                || !readInt(in, section) || !readAttributes(in, attributes) || !readInt(in, datatype)
+                || !readInt(in, dstype) || !readInt(in, dim0) || !readInt(in, dim1)
+                || !readInt(in, h5dim0) || !readInt(in, h5dim1))
+            return false;
+        IMetaData* mdata = new IMetaData(path, calculation, name, (Section)section, attributes);
+        mdata->datatype = (eve::DataType)datatype;
+        mdata->dstype = (EVEDatasetType)dstype;
+        mdata->dim0 = dim0;
+        mdata->dim1 = dim1;
+        mdata->h5dimensions[0] = h5dim0;
+        mdata->h5dimensions[1] = h5dim1;
+        mdlist.push_back(mdata);
+    }
+    return true;
+}
+
+} // namespace end
@@ -0,0 +1,56 @@
+#ifndef INVENTORYFILE_H
+#define INVENTORYFILE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include "IMetaData.h"
+
+using namespace std;
+
+namespace eve {
+
+// persisted inventory of an EVEH5 file (sidecar index in a cache directory), valid
+// as long as path, modification and status change times (in ns), inode, device and size
+// of the EVEH5 file are unchanged.
+// Holds resolved metadata only, the metadata is not owned by the inventory file.
+class InventoryFile
+{
+public:
+    struct Chain {
+        Chain() : timestampMeta(NULL) {};
+        map<string, string> chainAttributes;
+        vector<IMetaData*> chainmeta;
+        vector<IMetaData*> extensionmeta;
+        IMetaData* timestampMeta;
+    };
+
+    InventoryFile(const string& indexDir, const string& filename, float version);
+    bool read();
+    void write();
+    void deleteMetaData();
+
+    map<string, string> rootAttributes;
+    vector<int> chainList;
+    map<int, Chain> chains;
+    vector<IMetaData*> monitormeta;
+
+private:
+    bool readKey();
+    void writeMetaData(ostream& out, const vector<IMetaData*>& mdlist);
+    bool readMetaData(istream& in, vector<IMetaData*>& mdlist);
+
+    string indexName;
+    string h5name;
+    float h5version;
+    long long mtime;        // ns
+    long long ctime;        // ns, also changed by copies keeping the modification time
+    long long inode;
+    long long device;
+    long long size;
+};
+
+} // namespace end
+
+#endif // INVENTORYFILE_H
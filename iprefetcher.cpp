@@ -0,0 +1,89 @@
+#include <algorithm>
+#include "iprefetcher.h"
+
+namespace eve {
+
+IPrefetcher::IPrefetcher(IH5File* h5file) : file(h5file), foreground(0), pending(true), stopping(false)
+{
+    worker = thread(&IPrefetcher::work, this);
+}
+
+IPrefetcher::~IPrefetcher(){
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    stateCond.notify_all();
+    worker.join();
+}
+
+void IPrefetcher::enter(){
+    lock_guard<mutex> lock(stateMutex);
+    ++foreground;
+}
+
+void IPrefetcher::leave(){
+    {
+        lock_guard<mutex> lock(stateMutex);
+        --foreground;
+        pending = true;
+        lastCall = chrono::steady_clock::now();
+    }
+    stateCond.notify_one();
+}
+
+void IPrefetcher::work(){
+    unique_lock<mutex> lock(stateMutex);
+    while (true){
+        stateCond.wait(lock, [&]{return stopping || (pending && (foreground == 0));});
+        if (stopping) return;
+        // calls often come in a row (setChain, getData), don't start a step in between
+        chrono::steady_clock::time_point idle = lastCall + chrono::milliseconds(idleDelay);
+        if (chrono::steady_clock::now() < idle){
+            stateCond.wait_until(lock, idle);
+            continue;
+        }
+        lock.unlock();
+        bool done = step();
+        lock.lock();
+        // nothing left to do until the next call of the file
+        if (!done) pending = false;
+    }
+}
+
+// do the first step not yet done for the selected chain, false if there is none.
+// Steps read the inventory of the chain they work on, the selected chain is not changed.
+bool IPrefetcher::step(){
+
+    int chain = file->getChain();
+    if (chain == 0) return false;
+    vector<int> chains = file->getChains();
+    sort(chains.begin(), chains.end());
+    vector<int>::iterator next = upper_bound(chains.begin(), chains.end(), chain);
+    int nextChain = (next != chains.end()) ? *next : 0;
+
+    // errors are reported when the data is requested
+    try {
+        if (warmed.insert(chain).second){
+            file->warmCache(*file->getInventory(chain));
+            return true;
+        }
+        if (nextChain == 0) return false;
+        if (!file->hasInventory(nextChain) && (failed.count(nextChain) == 0)){
+            failed.insert(nextChain);
+            file->getInventory(nextChain);
+            failed.erase(nextChain);
+            return true;
+        }
+        if (file->hasInventory(nextChain) && warmed.insert(nextChain).second){
+            file->warmCache(*file->getInventory(nextChain));
+            return true;
+        }
+    }
+    catch (...){
+        return true;
+    }
+    return false;
+}
+
+} // namespace end
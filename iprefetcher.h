@@ -0,0 +1,62 @@
+#ifndef IPREFETCHER_H
+#define IPREFETCHER_H
+
+#include <set>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "IH5File.h"
+
+using namespace std;
+
+namespace eve {
+
+// reads ahead in a background thread (see OpenOptions::prefetch). Every call of the
+// file is bracketed by enter() and leave(), the prefetcher runs one step at a time
+// and only starts a step after the file has been idle for idleDelay ms.
+class IPrefetcher
+{
+public:
+    IPrefetcher(IH5File* file);
+    ~IPrefetcher();
+    void enter();
+    void leave();
+
+private:
+    void work();
+    bool step();
+
+    IH5File* file;
+    int foreground;         // calls of the file running
+    bool pending;           // a call has finished since the last step found nothing to do
+    bool stopping;
+    chrono::steady_clock::time_point lastCall;  // end of the last call
+    static const int idleDelay = 20;    // ms without calls before a step
+    set<int> warmed;        // chains with preferred data read into the cache
+    set<int> failed;        // chains whose inventory couldn't be read
+    mutex stateMutex;
+    condition_variable stateCond;
+    thread worker;
+};
+
+// a call of IFile, lets the prefetcher (if any) wait for the call
+class CallScope
+{
+public:
+    CallScope(IPrefetcher* prefetcher) : prefetcher(prefetcher) {
+        if (prefetcher != NULL) prefetcher->enter();
+    };
+    ~CallScope(){
+        if (prefetcher != NULL) prefetcher->leave();
+    };
+
+private:
+    CallScope(const CallScope&);
+    CallScope& operator=(const CallScope&);
+    IPrefetcher* prefetcher;
+};
+
+} // namespace end
+
+#endif // IPREFETCHER_H
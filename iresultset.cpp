@@ -0,0 +1,59 @@
+#include "iresultset.h"
+
+namespace eve {
+
+IResultSet::~IResultSet()
+{
+    clear();
+    delete arena;
+}
+
+// objects allocated in the arena only run their destructor, the memory is released with the arena
+void IResultSet::clear(){
+    for (MetaData* object : objects) delete object;
+    objects.clear();
+    delete arena;
+    arena = new ResultArena();
+}
+
+template <typename T> vector<T*> IResultSet::own(const vector<T*>& results){
+    objects.insert(objects.end(), results.begin(), results.end());
+    return results;
+}
+
+vector<MetaData *> IResultSet::getMetaData(Section section, string id, string name){
+    ArenaScope scope(arena);
+    return own(file->getMetaData(section, id, name));
+}
+
+vector<Data*> IResultSet::getData(vector<MetaData*>& mdvec){
+    ArenaScope scope(arena);
+    return own(file->getData(mdvec));
+}
+
+vector<Data*> IResultSet::getData(vector<MetaData*>& mdvec, const Selection& selection){
+    ArenaScope scope(arena);
+    return own(file->getData(mdvec, selection));
+}
+
+vector<Data*> IResultSet::getJoinedData(vector<MetaData*>& mdvec, FillRule fill){
+    ArenaScope scope(arena);
+    return own(file->getJoinedData(mdvec, fill));
+}
+
+vector<Data*> IResultSet::getJoinedData(vector<MetaData*>& mdvec, FillRule fill, const Selection& selection){
+    ArenaScope scope(arena);
+    return own(file->getJoinedData(mdvec, fill, selection));
+}
+
+vector<Data*> IResultSet::getJoinedData(vector<MetaData*>& mdvec, FillRule fill, TimeAlignment alignment){
+    ArenaScope scope(arena);
+    return own(file->getJoinedData(mdvec, fill, alignment));
+}
+
+vector<Data*> IResultSet::getPreferredData(FillRule fill){
+    ArenaScope scope(arena);
+    return own(file->getPreferredData(fill));
+}
+
+} // namespace end
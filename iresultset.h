@@ -0,0 +1,40 @@
+#ifndef IRESULTSET_H
+#define IRESULTSET_H
+
+#include <string>
+#include <vector>
+#include "eve.h"
+#include "resultarena.h"
+
+using namespace std;
+
+namespace eve {
+
+// results of queries of a DataFile allocated in one arena, see ResultSet
+class IResultSet : public ResultSet
+{
+public:
+    IResultSet(DataFile* file) : file(file), arena(new ResultArena()) {};
+    virtual ~IResultSet();
+
+    vector<MetaData *> getMetaData(Section section, string id, string name);
+    vector<Data*> getData(vector<MetaData*>& mdvec);
+    vector<Data*> getData(vector<MetaData*>& mdvec, const Selection& selection);
+    vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill);
+    vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill, const Selection& selection);
+    vector<Data*> getJoinedData(vector<MetaData*>& mdvec, FillRule fill, TimeAlignment alignment);
+    vector<Data*> getPreferredData(FillRule fill);
+    size_t size(){return objects.size();};
+    void clear();
+
+private:
+    template <typename T> vector<T*> own(const vector<T*>& results);
+
+    DataFile* file;
+    ResultArena* arena;
+    vector<MetaData*> objects;
+};
+
+} // namespace end
+
+#endif // IRESULTSET_H
@@ -0,0 +1,91 @@
+#include "metadataindex.h"
+
+namespace eve {
+
+void MetaDataIndex::build(const vector<IMetaData*>& mdlist){
+    clear();
+    entries = mdlist;
+    byFQName.reserve(entries.size());
+    // the first entry wins, same as a linear search
+    for (IMetaData* mdat : entries) byFQName.insert(pair<string, IMetaData*>(mdat->getFQH5Name(), mdat));
+    for (IMetaData* mdat : entries)
+        if (!mdat->calculation.empty()) byCalculation[mdat->calculation].push_back(mdat);
+    built = true;
+}
+
+void MetaDataIndex::clear(){
+    entries.clear();
+    byFQName.clear();
+    byCalculation.clear();
+    buckets.clear();
+    built = false;
+}
+
+IMetaData* MetaDataIndex::findByFQName(const string& fqname) const {
+    unordered_map<string, IMetaData*>::const_iterator it = byFQName.find(fqname);
+    if (it == byFQName.end()) return NULL;
+    return it->second;
+}
+
+// bucketMutex held
+MetaDataIndex::SectionBucket& MetaDataIndex::getBucket(const string& prefix) const {
+    map<string, SectionBucket>::iterator it = buckets.find(prefix);
+    if (it != buckets.end()) return it->second;
+
+    SectionBucket& bucket = buckets[prefix];
+    for (IMetaData* mdat : entries)
+        if (mdat->getPath().compare(0, prefix.size(), prefix) == 0) bucket.entries.push_back(mdat);
+    return bucket;
+}
+
+// bucketMutex held
+void MetaDataIndex::addKeys(SectionBucket& bucket) const {
+    if (bucket.keyed) return;
+    for (IMetaData* mdat : bucket.entries){
+        bucket.byId[mdat->getId()].push_back(mdat);
+        bucket.byName[mdat->getName()].push_back(mdat);
+    }
+    bucket.keyed = true;
+}
+
+const vector<IMetaData*>& MetaDataIndex::getSection(const string& prefix) const {
+    lock_guard<mutex> lock(bucketMutex);
+    return getBucket(prefix).entries;
+}
+
+bool MetaDataIndex::hasKeys(const string& prefix) const {
+    lock_guard<mutex> lock(bucketMutex);
+    return getBucket(prefix).keyed;
+}
+
+void MetaDataIndex::buildKeys(const string& prefix) const {
+    lock_guard<mutex> lock(bucketMutex);
+    addKeys(getBucket(prefix));
+}
+
+const vector<IMetaData*>& MetaDataIndex::findKey(const unordered_map<string, vector<IMetaData*>>& keys, const string& key) const {
+    unordered_map<string, vector<IMetaData*>>::const_iterator it = keys.find(key);
+    if (it == keys.end()) return noEntries;
+    return it->second;
+}
+
+const vector<IMetaData*>& MetaDataIndex::findById(const string& prefix, const string& id) const {
+    lock_guard<mutex> lock(bucketMutex);
+    SectionBucket& bucket = getBucket(prefix);
+    addKeys(bucket);
+    return findKey(bucket.byId, id);
+}
+
+const vector<IMetaData*>& MetaDataIndex::findByName(const string& prefix, const string& name) const {
+    lock_guard<mutex> lock(bucketMutex);
+    SectionBucket& bucket = getBucket(prefix);
+    addKeys(bucket);
+    return findKey(bucket.byName, name);
+}
+
+// entries of a calculation or normalization group (e.g. "normalized")
+const vector<IMetaData*>& MetaDataIndex::findByCalculation(const string& calculation) const {
+    return findKey(byCalculation, calculation);
+}
+
+} // namespace end
@@ -0,0 +1,59 @@
+#ifndef METADATAINDEX_H
+#define METADATAINDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include "IMetaData.h"
+
+using namespace std;
+
+namespace eve {
+
+// hash index of an inventory list (chainmeta, extensionmeta, monitors).
+// Entries keep the order of the list, lookups return the same entries a linear
+// scan of the list would return. The index does not own the metadata.
+// It is built once, lookups of several threads may add section buckets and keys.
+class MetaDataIndex
+{
+public:
+    MetaDataIndex() : built(false) {};
+    void build(const vector<IMetaData*>& mdlist);
+    void clear();
+    bool isBuilt() const {return built;};
+    IMetaData* findByFQName(const string& fqname) const;
+    const vector<IMetaData*>& getSection(const string& prefix) const;
+    bool hasKeys(const string& prefix) const;
+    void buildKeys(const string& prefix) const;
+    const vector<IMetaData*>& findById(const string& prefix, const string& id) const;
+    const vector<IMetaData*>& findByName(const string& prefix, const string& name) const;
+    const vector<IMetaData*>& findByCalculation(const string& calculation) const;
+
+private:
+    // entries whose path starts with prefix; Id and Name keys need resolved
+    // metadata and are only built on request (see buildKeys)
+    struct SectionBucket {
+        SectionBucket() : keyed(false) {};
+        vector<IMetaData*> entries;
+        bool keyed;
+        unordered_map<string, vector<IMetaData*>> byId;
+        unordered_map<string, vector<IMetaData*>> byName;
+    };
+    SectionBucket& getBucket(const string& prefix) const;
+    void addKeys(SectionBucket& bucket) const;
+    const vector<IMetaData*>& findKey(const unordered_map<string, vector<IMetaData*>>& keys, const string& key) const;
+
+    bool built;
+    vector<IMetaData*> entries;
+    unordered_map<string, IMetaData*> byFQName;
+    unordered_map<string, vector<IMetaData*>> byCalculation;    // known without resolving
+    mutable map<string, SectionBucket> buckets;     // buckets are not changed once keyed
+    mutable mutex bucketMutex;
+    vector<IMetaData*> noEntries;
+};
+
+} // namespace end
+
+#endif // METADATAINDEX_H
@@ -0,0 +1,29 @@
+#include "resultarena.h"
+
+namespace eve {
+
+thread_local ResultArena* ResultArena::current = NULL;
+
+ResultArena::~ResultArena()
+{
+    for (char* block : blocks) delete[] block;
+}
+
+// allocations are 16 byte aligned, large ones get a block of their own
+void* ResultArena::allocate(size_t size){
+    size = (size + 15) & ~(size_t)15;
+    if (size > RESULTARENABLOCK / 4){
+        char* block = new char[size];
+        blocks.insert(blocks.begin(), block);
+        return block;
+    }
+    if (used + size > RESULTARENABLOCK){
+        blocks.push_back(new char[RESULTARENABLOCK]);
+        used = 0;
+    }
+    char* ptr = blocks.back() + used;
+    used += size;
+    return ptr;
+}
+
+} // namespace end
@@ -0,0 +1,49 @@
+#ifndef RESULTARENA_H
+#define RESULTARENA_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+namespace eve {
+
+// bytes in front of each IMetaData/IData allocation holding its arena (NULL: heap)
+#define RESULTARENAHEADER 16
+#define RESULTARENABLOCK 65536
+
+// block allocator for the results of a ResultSet. Memory is only released with the
+// arena, objects deleted before just leave their memory unused.
+// A ResultSet makes its arena active() for the calling thread during a query.
+class ResultArena
+{
+public:
+    ResultArena() : used(RESULTARENABLOCK) {};
+    ~ResultArena();
+    void* allocate(size_t size);
+    static ResultArena* active(){return current;};
+
+private:
+    ResultArena(const ResultArena&);
+    ResultArena& operator=(const ResultArena&);
+    vector<char*> blocks;
+    size_t used;
+    static thread_local ResultArena* current;
+
+    friend class ArenaScope;
+};
+
+// make arena active for the calling thread while in scope
+class ArenaScope
+{
+public:
+    ArenaScope(ResultArena* arena) : previous(ResultArena::current) {ResultArena::current = arena;};
+    ~ArenaScope(){ResultArena::current = previous;};
+
+private:
+    ResultArena* previous;
+};
+
+} // namespace end
+
+#endif // RESULTARENA_H
@@ -0,0 +1,172 @@
+#include "stringcolumn.h"
+
+namespace eve {
+
+StringColumn::StringColumn(bool dictionary) : dictionary(dictionary), offsets(1, 0)
+{
+}
+
+void StringColumn::reserve(size_t rows, size_t bytes){
+    if (dictionary)
+        codes.reserve(rows);
+    else {
+        offsets.reserve(rows + 1);
+        chars.reserve(bytes);
+    }
+}
+
+// code of value in the dictionary, the value is added if missing
+int StringColumn::code(const char* value, size_t length){
+    if (lookup.size() + 1 < offsets.size()){
+        for (size_t i = lookup.size(); i + 1 < offsets.size(); ++i)
+            lookup.insert(pair<string, int>(string(chars.data() + offsets[i], offsets[i + 1] - offsets[i]), (int)i));
+    }
+    string key(value, length);
+    unordered_map<string, int>::iterator it = lookup.find(key);
+    if (it != lookup.end()) return it->second;
+    int newcode = offsets.size() - 1;
+    chars.insert(chars.end(), value, value + length);
+    offsets.push_back(chars.size());
+    lookup.insert(pair<string, int>(key, newcode));
+    return newcode;
+}
+
+void StringColumn::append(const char* value, size_t length){
+    if (dictionary)
+        codes.push_back(code(value, length));
+    else {
+        chars.insert(chars.end(), value, value + length);
+        offsets.push_back(chars.size());
+    }
+}
+
+void StringColumn::append(const StringColumn& source, size_t row){
+    if (dictionary && source.dictionary && (&source == this))
+        codes.push_back(codes[row]);
+    else
+        append(source.data(row), source.length(row));
+}
+
+void StringColumn::append(const StringColumn& source){
+    if (dictionary && source.dictionary && sameDictionary(source)){
+        codes.insert(codes.end(), source.codes.begin(), source.codes.end());
+        return;
+    }
+    if (!dictionary && !source.dictionary){
+        long long base = chars.size();
+        chars.insert(chars.end(), source.chars.begin(), source.chars.end());
+        for (size_t i = 1; i < source.offsets.size(); ++i) offsets.push_back(base + source.offsets[i]);
+        return;
+    }
+    for (size_t row = 0; row < source.size(); ++row) append(source.data(row), source.length(row));
+}
+
+void StringColumn::appendEmpty(){
+    if (dictionary)
+        codes.push_back(-1);
+    else
+        offsets.push_back(chars.size());
+}
+
+// remove the first rows
+void StringColumn::erase(size_t rows){
+    if (rows == 0) return;
+    if (dictionary){
+        codes.erase(codes.begin(), codes.begin() + rows);
+        return;
+    }
+    long long first = offsets[rows];
+    chars.erase(chars.begin(), chars.begin() + first);
+    offsets.erase(offsets.begin(), offsets.begin() + rows);
+    for (long long& offset : offsets) offset -= first;
+}
+
+void StringColumn::clear(){
+    chars.clear();
+    offsets.assign(1, 0);
+    codes.clear();
+    lookup.clear();
+}
+
+// release the lookup table, a dictionary with more values than half the rows is expanded
+void StringColumn::compact(){
+    lookup.clear();
+    if (!dictionary || (offsets.size() - 1 <= codes.size() / 2)) return;
+    StringColumn plain;
+    plain.append(*this);
+    *this = plain;
+}
+
+size_t StringColumn::memoryBytes() const {
+    size_t bytes = chars.capacity() + offsets.capacity() * sizeof(long long) + codes.capacity() * sizeof(int);
+    if (!lookup.empty()) bytes += lookup.size() * (sizeof(string) + sizeof(int) + 2 * sizeof(void*)) + chars.size();
+    return bytes;
+}
+
+bool StringColumn::sameDictionary(const StringColumn& other) const {
+    return (&other == this) || ((offsets == other.offsets) && (chars == other.chars));
+}
+
+// new column with the rows of source, rows < 0 get the row of fill in fillsource
+// (if fill is not NULL and >= 0), fillValue (if not NULL) or an empty string
+shared_ptr<StringColumn> StringColumn::gather(const StringColumn& source, const vector<int>& rows, const StringColumn& fillsource,
+                                              const vector<int>* fill, const string* fillValue){
+
+    shared_ptr<StringColumn> column = make_shared<StringColumn>(source.dictionary);
+    if (source.dictionary){
+        // the gathered rows keep the codes of source
+        column->chars = source.chars;
+        column->offsets = source.offsets;
+        column->codes.reserve(rows.size());
+        bool fillCodes = fillsource.dictionary && source.sameDictionary(fillsource);
+        int fillCode = (fillValue != NULL) ? column->code(fillValue->data(), fillValue->size()) : -1;
+        for (size_t i = 0; i < rows.size(); ++i){
+            if (rows[i] >= 0)
+                column->codes.push_back(source.codes[rows[i]]);
+            else if ((fill != NULL) && ((*fill)[i] >= 0)) {
+                if (fillCodes)
+                    column->codes.push_back(fillsource.codes[(*fill)[i]]);
+                else
+                    column->append(fillsource, (*fill)[i]);
+            }
+            else
+                column->codes.push_back(fillCode);
+        }
+        return column;
+    }
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < rows.size(); ++i){
+        if (rows[i] >= 0)
+            bytes += source.length(rows[i]);
+        else if ((fill != NULL) && ((*fill)[i] >= 0))
+            bytes += fillsource.length((*fill)[i]);
+        else if (fillValue != NULL)
+            bytes += fillValue->size();
+    }
+    column->reserve(rows.size(), bytes);
+    for (size_t i = 0; i < rows.size(); ++i){
+        if (rows[i] >= 0)
+            column->append(source.data(rows[i]), source.length(rows[i]));
+        else if ((fill != NULL) && ((*fill)[i] >= 0))
+            column->append(fillsource.data((*fill)[i]), fillsource.length((*fill)[i]));
+        else if (fillValue != NULL)
+            column->append(*fillValue);
+        else
+            column->appendEmpty();
+    }
+    return column;
+}
+
+StringColumnView StringColumn::view(shared_ptr<const void> owner) const {
+    return StringColumnView(owner, chars.data(), offsets.data(), offsets.size() - 1, dictionary ? codes.data() : NULL, size());
+}
+
+vector<string> StringColumn::toStrings() const {
+    vector<string> strings;
+    strings.reserve(size());
+    for (size_t row = 0; row < size(); ++row) strings.push_back(str(row));
+    return strings;
+}
+
+} // namespace end
@@ -0,0 +1,56 @@
+#ifndef STRINGCOLUMN_H
+#define STRINGCOLUMN_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "eve.h"
+
+using namespace std;
+
+namespace eve {
+
+// strings of a column in one character buffer: value i is chars[offsets[i], offsets[i+1]).
+// Without dictionary value i is row i, with dictionary row i is value codes[i]
+// (-1: empty string), appending looks up the values of the dictionary.
+class StringColumn
+{
+public:
+    StringColumn(bool dictionary=false);
+    size_t size() const {return dictionary ? codes.size() : offsets.size() - 1;};
+    bool isDictionary() const {return dictionary;};
+    const char* data(size_t row) const {long long value = valueOf(row); return (value < 0) ? "" : chars.data() + offsets[value];};
+    size_t length(size_t row) const {long long value = valueOf(row); return (value < 0) ? 0 : offsets[value + 1] - offsets[value];};
+    string str(size_t row) const {return string(data(row), length(row));};
+    void reserve(size_t rows, size_t bytes);
+    void append(const char* value, size_t length);
+    void append(const string& value){append(value.data(), value.size());};
+    void append(const StringColumn& source, size_t row);
+    void append(const StringColumn& source);
+    void appendEmpty();
+    void erase(size_t rows);
+    void clear();
+    void compact();
+    size_t memoryBytes() const;
+    static shared_ptr<StringColumn> gather(const StringColumn& source, const vector<int>& rows, const StringColumn& fillsource,
+                                           const vector<int>* fill, const string* fillValue);
+    StringColumnView view(shared_ptr<const void> owner) const;
+    vector<string> toStrings() const;
+
+private:
+    long long valueOf(size_t row) const {return dictionary ? codes[row] : (long long)row;};
+    bool sameDictionary(const StringColumn& other) const;
+    int code(const char* value, size_t length);
+
+    bool dictionary;
+    vector<char> chars;
+    vector<long long> offsets;
+    vector<int> codes;
+    // code of each dictionary value, built when the first value is looked up
+    unordered_map<string, int> lookup;
+};
+
+} // namespace end
+
+#endif // STRINGCOLUMN_H